@@ -15,7 +15,12 @@
 
 // Libraries
 #include <iostream>
+#include <memory_resource>
+#include <new>
 #include <utility>
+#include <vector>
+
+#include "Serialization.hpp"
 
 // Determines the threshold for how imbalanced
 // the tree may be.
@@ -44,6 +49,9 @@ private:
     };
     avl_node* _root;
 
+    // Every node is allocated from alloc's memory resource
+    std::pmr::polymorphic_allocator<avl_node> alloc;
+
 
     // Private Functions
 
@@ -117,7 +125,7 @@ private:
         n->right = t->left;
         t->left = n;
         n->height = max(height(n->right), height(n->left)) + 1;
-        t->height = max(height(n->right), n->height) + 1;
+        t->height = max(height(t->right), n->height) + 1;
         n = t;
     }
 
@@ -141,6 +149,34 @@ private:
         rotate_right_child(n);
     }
 
+    // Node Allocation
+
+    /* *
+     * Description: Allocates a node from the memory resource and
+     *              constructs it with d as its data.
+     */
+    template <class U>
+    avl_node* create_node(U&& d) {
+        avl_node* n = alloc.allocate(1);
+        try {
+            ::new (static_cast<void*>(n)) avl_node{std::forward<U>(d), nullptr, nullptr};
+        }
+        catch (...) {
+            alloc.deallocate(n, 1);
+            throw;
+        }
+        return n;
+    }
+
+    /* *
+     * Description: Destroys node n and gives its memory back to the
+     *              memory resource.
+     */
+    void destroy_node(avl_node* n) {
+        n->~avl_node();
+        alloc.deallocate(n, 1);
+    }
+
     // Private Insert and Remove
 
     /*
@@ -154,7 +190,7 @@ private:
      */
     void insert(const T& d, avl_node*& n) {
         if (n == nullptr) {
-            n = new avl_node{d,nullptr,nullptr};
+            n = create_node(d);
         }
         else if (d < n->data) {
             insert(d, n->left);
@@ -176,10 +212,10 @@ private:
         }
 
         if (d < n->data) {
-            n = remove(d,n->right);
+            remove(d, n->left);
         }
         else if (n->data < d) {
-            n = remove(d,n->left);
+            remove(d, n->right);
         }
         else if (n->left != nullptr && n->right != nullptr) {
             n->data = find_min(n->right)->data;
@@ -188,7 +224,7 @@ private:
         else {
             avl_node* old_node = n;
             n = (n->left != nullptr) ? n->left : n->right;
-            delete old_node;
+            destroy_node(old_node);
         }
 
         balance(n);
@@ -282,15 +318,74 @@ private:
             if (node->right != nullptr) {
                 destroy_subtree(node->right);
             }
-            delete node;
+            destroy_node(node);
             node = nullptr;
         }
     }
 
+    // Serialization
+
+    /* *
+     * Description: Counts the nodes below and including n.
+     */
+    uint64_t count_nodes(avl_node* n) const {
+        return (n == nullptr) ? 0 : 1 + count_nodes(n->left) + count_nodes(n->right);
+    }
+
+    /* *
+     * Description: Calls visit(data) on every node below and including
+     *              n, in sorted order.
+     */
+    template <class Visitor>
+    void visit_in_order(avl_node* n, Visitor& visit) const {
+        if (n != nullptr) {
+            visit_in_order(n->left, visit);
+            visit(n->data);
+            visit_in_order(n->right, visit);
+        }
+    }
+
+    /* *
+     * Description: Builds a perfectly balanced tree out of the sorted
+     *              items[lo, hi) by making the middle item the root,
+     *              so loading n items costs O(n) and no rotations.
+     */
+    avl_node* build_balanced(std::vector<T>& items, size_t lo, size_t hi) {
+        if (lo >= hi) {
+            return nullptr;
+        }
+        size_t mid = lo + (hi - lo) / 2;
+        avl_node* n = create_node(std::move(items[mid]));
+        n->left = build_balanced(items, lo, mid);
+        n->right = build_balanced(items, mid + 1, hi);
+        n->height = max(height(n->left), height(n->right)) + 1;
+        return n;
+    }
+
+    /* *
+     * Description: Replaces the tree with the one stored in reader. The
+     *              current tree is only destroyed once the whole input
+     *              has been read and checked.
+     */
+    void load(BinaryReader& reader) {
+        std::vector<T> items;
+        readSerialized<T>(reader, SerializedKind::AVL_TREE,
+                          [&](T&& item) { items.push_back(std::move(item)); });
+        for (size_t i = 1; i < items.size(); ++i) {
+            if (!(items[i - 1] < items[i])) {
+                throw std::runtime_error("deserialize: tree elements are out of order");
+            }
+        }
+        destroy_subtree(_root);
+        _root = build_balanced(items, 0, items.size());
+    }
+
     // Public Accessible Functions
 public:
 
-    AVLTree() {_root = nullptr;}
+    // Nodes are allocated from resource, which must outlive the tree
+    explicit AVLTree(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : _root{nullptr}, alloc{resource} {}
 
     ~AVLTree() { destroy_subtree(_root);}
 
@@ -304,6 +399,24 @@ public:
 
     bool validate() const { return validate(_root);}
 
+    std::pmr::memory_resource* get_resource() const { return alloc.resource();}
+
+    // Writes the elements in sorted order (see Serialization.hpp)
+    void serialize(std::ostream& output) const {
+        writeSerialized<T>(output, SerializedKind::AVL_TREE, count_nodes(_root), 0, 0,
+                           [&](auto&& visit) { visit_in_order(_root, visit); });
+    }
+
+    void deserialize(std::istream& input) {
+        BinaryReader reader(input);
+        load(reader);
+    }
+
+    void deserialize(const MappedFile& file) {
+        BinaryReader reader(file.data(), file.size());
+        load(reader);
+    }
+
 };
 
 #endif /* endif AVL_Tree_hpp */
@@ -16,13 +16,25 @@
 #ifndef BinarySearchTree_hpp
 #define BinarySearchTree_hpp
 
-#include "ttype.hpp"
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <sstream>
+#include <vector>
+#include <iterator>
+#include <memory_resource>
+#include <new>
+#include <cerrno>
+#include <unistd.h>
+
+#include "Serialization.hpp"
 
 template<class T>
 class BinarySearchTree {
+public:
+    // Traversal Orders
+    enum TraversalOrder { IN_ORDER, PRE_ORDER, POST_ORDER };
+
 private:
     // Struct Declaration
     struct TreeNode {
@@ -31,6 +43,11 @@ private:
         TreeNode *left;
     };
     TreeNode *root;
+    std::pmr::polymorphic_allocator<TreeNode> alloc;
+    
+    // Node Allocation
+    template<class U> TreeNode *createNode(U &&);
+    void destroyNode(TreeNode *);
     
     // Deletions
     void destroySubTree(TreeNode *);
@@ -40,16 +57,78 @@ private:
     // Inserts
     void insert(TreeNode *&, TreeNode *&); //if(TreeNode.data < otherNode.data) {}
     
-    // Displays
-    void displayInOrder(TreeNode *) const;
-    void displayPreOrder(TreeNode *) const;
-    void displayPostOrder(TreeNode *) const;
+    // Traversals
+    template<class Visitor> void visitInOrder(Visitor &) const;
+    template<class Visitor> void visitPreOrder(Visitor &) const;
+    template<class Visitor> void visitPostOrder(Visitor &) const;
+
+    // Writers
+    template<class Sink> bool writeBuffered(Sink &, TraversalOrder, char) const;
+
+    // Serialization
+    TreeNode *buildBalanced(std::vector<T> &, size_t, size_t);
+    void load(BinaryReader &);
+
+    // Bytes collected by write() before handing them to the output
+    static constexpr std::streamoff WRITE_BUFFER_SIZE = 1 << 16;
 
 public:
+
+    // In-Order Iterator
+    class const_iterator {
+    private:
+        std::vector<const TreeNode *> path;
+
+        void pushLeft(const TreeNode *nodePtr) {
+            while (nodePtr) {
+                path.push_back(nodePtr);
+                nodePtr = nodePtr->left;
+            }
+        }
+
+        friend class BinarySearchTree;
+        explicit const_iterator(const TreeNode *nodePtr) { pushLeft(nodePtr); }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T                         value_type;
+        typedef std::ptrdiff_t            difference_type;
+        typedef const T *                 pointer;
+        typedef const T &                 reference;
+
+        const_iterator() {}
+
+        reference operator*() const { return path.back()->data; }
+        pointer operator->() const { return &path.back()->data; }
+
+        const_iterator &operator++() {
+            const TreeNode *nodePtr = path.back();
+            path.pop_back();
+            pushLeft(nodePtr->right);
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+
+        bool operator==(const const_iterator &other) const {
+            if (path.empty() || other.path.empty()) {
+                return path.empty() && other.path.empty();
+            }
+            return path.back() == other.path.back();
+        }
+        bool operator!=(const const_iterator &other) const {
+            return !(*this == other);
+        }
+    };
     
     // Constructors
-    BinarySearchTree() {
-        root = nullptr;
+    //
+    // Nodes are allocated from resource, which must outlive the tree.
+    explicit BinarySearchTree(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : root{nullptr}, alloc{resource} {
     }
     
     // Destructors
@@ -64,33 +143,98 @@ public:
     void insertNode(T);
     void remove(T);
     bool isNode(T);
+    std::pmr::memory_resource *getResource() const {
+        return alloc.resource();
+    }
     
-    // Override Display Functions
+    // Iterators
+    const_iterator begin() const {
+        return const_iterator(root);
+    }
+    const_iterator end() const {
+        return const_iterator();
+    }
+
+    // Visitors
+    template<class Visitor> void visit(TraversalOrder, Visitor) const;
+
+    // Writers
+    void write(std::ostream &, TraversalOrder = IN_ORDER, char = '\n') const;
+    bool write(int, TraversalOrder = IN_ORDER, char = '\n') const;
+
+    // Serialization
+    void serialize(std::ostream &) const;
+    void deserialize(std::istream &);
+    void deserialize(const MappedFile &);
+
+    // Display Functions
     void displayInOrder() const {
-        displayInOrder(root);
+        write(std::cout, IN_ORDER);
+        std::cout.flush();
     }
     void displayPreOrder() const {
-        displayPreOrder(root);
+        write(std::cout, PRE_ORDER);
+        std::cout.flush();
     }
     void displayPostOrder() const {
-        displayPostOrder(root);
+        write(std::cout, POST_ORDER);
+        std::cout.flush();
     }
 };
 
 // Function Definitions
+// **Private** //
+// createNode()
+//
+// Allocates a leaf holding d from the memory resource.
+template<class T>
+template<class U>
+typename BinarySearchTree<T>::TreeNode *BinarySearchTree<T>::createNode(U &&d) {
+    
+    TreeNode *nodePtr = alloc.allocate(1);
+    try {
+        ::new (static_cast<void *>(nodePtr)) TreeNode{std::forward<U>(d), nullptr, nullptr};
+    }
+    catch (...) {
+        alloc.deallocate(nodePtr, 1);
+        throw;
+    }
+    return nodePtr;
+}
+
+// **Private** //
+// destroyNode()
+template<class T>
+void BinarySearchTree<T>::destroyNode(TreeNode *nodePtr) {
+    
+    nodePtr->~TreeNode();
+    alloc.deallocate(nodePtr, 1);
+}
+
 // **Private** //
 // destroySubTree()
+//
+// Walks the tree with an explicit stack so that tearing down a
+// degenerate (list shaped) tree cannot overflow the call stack.
 template<class T>
 void BinarySearchTree<T>::destroySubTree(TreeNode *nodePtr) {
     
+    std::vector<TreeNode *> pending;
+    
     if (nodePtr) {
+        pending.push_back(nodePtr);
+    }
+    while (!pending.empty()) {
+        nodePtr = pending.back();
+        pending.pop_back();
+        
         if (nodePtr->left) {
-            destroySubTree(nodePtr->left);
+            pending.push_back(nodePtr->left);
         }
         if (nodePtr->right) {
-            destroySubTree(nodePtr->right);
+            pending.push_back(nodePtr->right);
         }
-        delete nodePtr;
+        destroyNode(nodePtr);
     }
 }
 
@@ -123,12 +267,12 @@ void BinarySearchTree<T>::makeDeletion(TreeNode *&nodePtr) {
     else if (nodePtr->right == nullptr) {
         tempPtr = nodePtr;
         nodePtr = nodePtr->left;
-        delete tempPtr;
+        destroyNode(tempPtr);
     }
     else if (nodePtr->left == nullptr) {
         tempPtr = nodePtr;
         nodePtr = nodePtr->right;
-        delete tempPtr;
+        destroyNode(tempPtr);
     }
     else {
         tempPtr = nodePtr->right;
@@ -140,7 +284,7 @@ void BinarySearchTree<T>::makeDeletion(TreeNode *&nodePtr) {
         tempPtr = nodePtr;
         nodePtr = nodePtr->right;
         
-        delete tempPtr;
+        destroyNode(tempPtr);
     }
 }
 
@@ -161,41 +305,111 @@ void BinarySearchTree<T>::insert(TreeNode *&nodePtr, TreeNode *&newNode) {
 }
 
 // **Private** //
-// displayInOrder()
+// visitInOrder()
 template<class T>
-void BinarySearchTree<T>::displayInOrder(TreeNode *nodePtr) const {
+template<class Visitor>
+void BinarySearchTree<T>::visitInOrder(Visitor &visitor) const {
     
-    if (nodePtr) {
-        displayInOrder(nodePtr->left);
-        std::cout << nodePtr->data << std::endl;
-        displayInOrder(nodePtr->right);
+    std::vector<const TreeNode *> pending;
+    const TreeNode *nodePtr = root;
+    
+    while (nodePtr || !pending.empty()) {
+        while (nodePtr) {
+            pending.push_back(nodePtr);
+            nodePtr = nodePtr->left;
+        }
+        nodePtr = pending.back();
+        pending.pop_back();
+        
+        visitor(nodePtr->data);
+        nodePtr = nodePtr->right;
     }
 }
 
 // **Private** //
-// displayPreOrder
+// visitPreOrder()
 template<class T>
-void BinarySearchTree<T>::displayPreOrder(TreeNode *nodePtr) const {
+template<class Visitor>
+void BinarySearchTree<T>::visitPreOrder(Visitor &visitor) const {
     
-    if (nodePtr) {
-        std::cout << nodePtr->data << std::endl;
-        displayPreOrder(nodePtr->left);
-        displayPreOrder(nodePtr->right);
+    std::vector<const TreeNode *> pending;
+    
+    if (root) {
+        pending.push_back(root);
+    }
+    while (!pending.empty()) {
+        const TreeNode *nodePtr = pending.back();
+        pending.pop_back();
+        
+        visitor(nodePtr->data);
+        if (nodePtr->right) {
+            pending.push_back(nodePtr->right);
+        }
+        if (nodePtr->left) {
+            pending.push_back(nodePtr->left);
+        }
     }
 }
 
 // **Private** //
-// displayPostOrder()
+// visitPostOrder()
+//
+// A node is only visited once its right subtree has been finished,
+// which is detected by the right child being the last node visited.
 template<class T>
-void BinarySearchTree<T>::displayPostOrder(TreeNode *nodePtr) const {
+template<class Visitor>
+void BinarySearchTree<T>::visitPostOrder(Visitor &visitor) const {
     
-    if (nodePtr) {
-        displayPostOrder(nodePtr->left);
-        displayPostOrder(nodePtr->right);
-        std::cout << nodePtr->data << std::endl;
+    std::vector<const TreeNode *> pending;
+    const TreeNode *nodePtr = root;
+    const TreeNode *lastVisited = nullptr;
+    
+    while (nodePtr || !pending.empty()) {
+        while (nodePtr) {
+            pending.push_back(nodePtr);
+            nodePtr = nodePtr->left;
+        }
+        const TreeNode *topPtr = pending.back();
+        
+        if (topPtr->right && topPtr->right != lastVisited) {
+            nodePtr = topPtr->right;
+        }
+        else {
+            visitor(topPtr->data);
+            lastVisited = topPtr;
+            pending.pop_back();
+        }
     }
 }
 
+// **Private** //
+// writeBuffered()
+//
+// Formats the elements into a local buffer and only hands the
+// buffer to the sink once WRITE_BUFFER_SIZE bytes have collected,
+// so the output is never flushed once per element.
+template<class T>
+template<class Sink>
+bool BinarySearchTree<T>::writeBuffered(Sink &sink, TraversalOrder order, char delim) const {
+    
+    std::ostringstream buffer;
+    bool success = true;
+    
+    auto collect = [&](const T &d) {
+        buffer << d << delim;
+        if (buffer.tellp() >= WRITE_BUFFER_SIZE) {
+            success = success && sink(buffer.str());
+            buffer.str("");
+        }
+    };
+    visit(order, collect);
+    
+    if (buffer.tellp() > 0) {
+        success = success && sink(buffer.str());
+    }
+    return success;
+}
+
 // **Public** //
 // getString()
 template<class T>
@@ -216,11 +430,7 @@ T BinarySearchTree<T>::getData(T d) {
 template<class T>
 void BinarySearchTree<T>::insertNode(T d) {
     
-    TreeNode *newNode = nullptr;
-    newNode = new TreeNode;
-    
-    newNode->data = d;
-    newNode->right = newNode->left = nullptr;
+    TreeNode *newNode = createNode(std::move(d));
     
     insert(root, newNode);
 }
@@ -248,4 +458,136 @@ bool BinarySearchTree<T>::isNode(T d) {
     return false;
 }
 
+// **Public** //
+// visit()
+//
+// Calls visitor(data) on every element in the requested order.
+// None of the traversals recurse, so deep trees are safe to walk.
+template<class T>
+template<class Visitor>
+void BinarySearchTree<T>::visit(TraversalOrder order, Visitor visitor) const {
+    
+    switch (order) {
+        case PRE_ORDER:
+            visitPreOrder(visitor);
+            break;
+        case POST_ORDER:
+            visitPostOrder(visitor);
+            break;
+        default:
+            visitInOrder(visitor);
+            break;
+    }
+}
+
+// **Public** //
+// write()
+//
+// Writes every element followed by delim to the stream. The stream
+// is not flushed; that is left to the caller.
+template<class T>
+void BinarySearchTree<T>::write(std::ostream &output, TraversalOrder order, char delim) const {
+    
+    auto sink = [&](const std::string &chunk) {
+        output.write(chunk.data(), chunk.size());
+        return static_cast<bool>(output);
+    };
+    writeBuffered(sink, order, delim);
+}
+
+// **Public** //
+// write()
+//
+// Same as above, but writes straight to a file descriptor. Returns
+// false if any write to the descriptor failed.
+template<class T>
+bool BinarySearchTree<T>::write(int fd, TraversalOrder order, char delim) const {
+    
+    auto sink = [&](const std::string &chunk) {
+        const char *data = chunk.data();
+        size_t remaining = chunk.size();
+        
+        while (remaining > 0) {
+            ssize_t written = ::write(fd, data, remaining);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data      += written;
+            remaining -= written;
+        }
+        return true;
+    };
+    return writeBuffered(sink, order, delim);
+}
+
+// **Private** //
+// buildBalanced()
+//
+// Builds a balanced tree out of the sorted items[lo, hi), middle item
+// at the root. Equal items may end up on either side of each other,
+// which every lookup and removal copes with.
+template<class T>
+typename BinarySearchTree<T>::TreeNode *BinarySearchTree<T>::buildBalanced(std::vector<T> &items, size_t lo, size_t hi) {
+    
+    if (lo >= hi) {
+        return nullptr;
+    }
+    size_t mid = lo + (hi - lo) / 2;
+    TreeNode *nodePtr = createNode(std::move(items[mid]));
+    nodePtr->left  = buildBalanced(items, lo, mid);
+    nodePtr->right = buildBalanced(items, mid + 1, hi);
+    return nodePtr;
+}
+
+// **Private** //
+// load()
+//
+// Replaces the tree with the one stored in reader, once all of it has
+// been read and checked.
+template<class T>
+void BinarySearchTree<T>::load(BinaryReader &reader) {
+    
+    std::vector<T> items;
+    readSerialized<T>(reader, SerializedKind::BINARY_SEARCH_TREE,
+                      [&](T &&item) { items.push_back(std::move(item)); });
+    for (size_t i = 1; i < items.size(); ++i) {
+        if (items[i] < items[i - 1]) {
+            throw std::runtime_error("deserialize: tree elements are out of order");
+        }
+    }
+    destroySubTree(root);
+    root = buildBalanced(items, 0, items.size());
+}
+
+// **Public** //
+// serialize()
+//
+// Writes the elements in sorted order (see Serialization.hpp). Loading
+// them back gives a balanced tree, whatever shape this one had.
+template<class T>
+void BinarySearchTree<T>::serialize(std::ostream &output) const {
+    
+    uint64_t count = 0;
+    visit(IN_ORDER, [&](const T &) { count++; });
+    writeSerialized<T>(output, SerializedKind::BINARY_SEARCH_TREE, count, 0, 0,
+                       [&](auto &&writeItem) { visit(IN_ORDER, writeItem); });
+}
+
+// **Public** //
+// deserialize()
+template<class T>
+void BinarySearchTree<T>::deserialize(std::istream &input) {
+    
+    BinaryReader reader(input);
+    load(reader);
+}
+
+template<class T>
+void BinarySearchTree<T>::deserialize(const MappedFile &file) {
+    
+    BinaryReader reader(file.data(), file.size());
+    load(reader);
+}
+
 #endif /* BinarySearchTree.hpp */
@@ -0,0 +1,437 @@
+//
+//  BlockingQueue.hpp
+//  CustomLibraries
+//
+//  Description
+//
+//  A bounded Queue for handing data between threads. Instead of
+//  dropping data when the queue is full, push() waits for room, and
+//  pop() waits for data when it is empty. This gives producers
+//  backpressure instead of data loss.
+//
+//  Waiting threads sleep on a condition variable and are woken one at
+//  a time, and only when a thread is actually waiting. An uncontended
+//  push or pop costs one lock and no wake-up calls. Timed variants
+//  (push_for, pop_until, ...) give up after a deadline.
+//
+//  close() stops new pushes. Items already in the queue can still be
+//  popped, and pop() starts returning false once they are gone.
+//
+//  With C++20 coroutines a consumer can also write
+//
+//      std::optional<T> item = co_await queue.pop();
+//
+//  which suspends the coroutine instead of the thread. The next push
+//  hands its item straight to the oldest suspended coroutine and
+//  resumes it on the pushing thread. An empty optional means the queue
+//  was closed and drained.
+//
+
+#ifndef BlockingQueue_hpp
+#define BlockingQueue_hpp
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+#include "Queue.hpp"
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#include <optional>
+#define BLOCKING_QUEUE_COROUTINES 1
+#endif
+
+template <class T>
+class BlockingQueue {
+private:
+    Queue<T> items;
+
+    mutable std::mutex      lock;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+    int  waitingPoppers;
+    int  waitingPushers;
+    bool closed;
+
+#ifdef BLOCKING_QUEUE_COROUTINES
+    struct PopAwaiter;
+    PopAwaiter *awaitFront;
+    PopAwaiter *awaitRear;
+
+    PopAwaiter *takeAwaiter();
+#endif
+
+    template <class U>
+    bool pushLocked(std::unique_lock<std::mutex> &, U &&);
+    void popLocked(T &);
+
+public:
+    // Constructor
+    explicit BlockingQueue(int=10);
+    BlockingQueue(const BlockingQueue &) = delete;
+    BlockingQueue &operator=(const BlockingQueue &) = delete;
+
+    // Destructor
+    ~BlockingQueue();
+
+    // Blocking Functions
+    bool push(const T &);
+    bool push(T &&);
+    bool pop(T &);
+
+    // Non-Blocking Functions
+    bool try_push(const T &);
+    bool try_push(T &&);
+    bool try_pop(T &);
+
+    // Timed Functions
+    template <class U, class Clock, class Duration>
+    bool push_until(U &&, const std::chrono::time_point<Clock, Duration> &);
+    template <class Clock, class Duration>
+    bool pop_until(T &, const std::chrono::time_point<Clock, Duration> &);
+    template <class U, class Rep, class Period>
+    bool push_for(U &&, const std::chrono::duration<Rep, Period> &);
+    template <class Rep, class Period>
+    bool pop_for(T &, const std::chrono::duration<Rep, Period> &);
+
+#ifdef BLOCKING_QUEUE_COROUTINES
+    // Coroutine Functions
+    [[nodiscard]] PopAwaiter pop();
+#endif
+
+    void close();
+    bool isClosed() const;
+    bool isEmpty() const;
+    bool isFull() const;
+    int  getSize() const;
+    int  getNumItems() const;
+};
+
+#ifdef BLOCKING_QUEUE_COROUTINES
+// Awaitable returned by pop(). While the coroutine is suspended the
+// awaiter sits in the queue's list of waiting coroutines.
+template <class T>
+struct BlockingQueue<T>::PopAwaiter {
+    BlockingQueue          *queue;
+    std::optional<T>        result;
+    std::coroutine_handle<> handle;
+    PopAwaiter             *next;
+
+    explicit PopAwaiter(BlockingQueue *q) : queue{q}, next{nullptr} {}
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> h) {
+        std::unique_lock<std::mutex> guard(queue->lock);
+
+        if (!queue->items.isEmpty()) {
+            result.emplace(std::move(queue->items.getFront()));
+            queue->items.dequeue();
+            if (queue->waitingPushers > 0) {
+                queue->notFull.notify_one();
+            }
+            return false;
+        }
+        if (queue->closed) {
+            return false;
+        }
+
+        handle = h;
+        if (queue->awaitRear) {
+            queue->awaitRear->next = this;
+        }
+        else {
+            queue->awaitFront = this;
+        }
+        queue->awaitRear = this;
+        return true;
+    }
+
+    std::optional<T> await_resume() { return std::move(result); }
+};
+#endif
+
+// Constructor
+template <class T>
+BlockingQueue<T>::BlockingQueue(int s)
+    : items(s), waitingPoppers{0}, waitingPushers{0}, closed{false} {
+#ifdef BLOCKING_QUEUE_COROUTINES
+    awaitFront = awaitRear = nullptr;
+#endif
+}
+
+// Destructor
+//
+// Closing first resumes any coroutines still waiting in pop().
+template <class T>
+BlockingQueue<T>::~BlockingQueue() {
+    close();
+}
+
+#ifdef BLOCKING_QUEUE_COROUTINES
+// **Private** //
+// takeAwaiter()
+//
+// Unlinks the oldest suspended coroutine. Caller holds the lock.
+template <class T>
+typename BlockingQueue<T>::PopAwaiter *BlockingQueue<T>::takeAwaiter() {
+    PopAwaiter *awaiter = awaitFront;
+    if (awaiter) {
+        awaitFront = awaiter->next;
+        if (awaitFront == nullptr) {
+            awaitRear = nullptr;
+        }
+    }
+    return awaiter;
+}
+#endif
+
+// **Private** //
+// pushLocked()
+//
+// Adds newData to a queue the caller has checked is open and not full.
+// Releases the lock before returning.
+template <class T>
+template <class U>
+bool BlockingQueue<T>::pushLocked(std::unique_lock<std::mutex> &guard, U &&newData) {
+#ifdef BLOCKING_QUEUE_COROUTINES
+    if (PopAwaiter *awaiter = takeAwaiter()) {
+        awaiter->result.emplace(std::forward<U>(newData));
+        guard.unlock();
+        awaiter->handle.resume();
+        return true;
+    }
+#endif
+    items.enqueue(std::forward<U>(newData));
+    bool wake = waitingPoppers > 0;
+    guard.unlock();
+
+    if (wake) {
+        notEmpty.notify_one();
+    }
+    return true;
+}
+
+// **Private** //
+// popLocked()
+//
+// Moves the front item into out. Caller holds the lock and has
+// checked the queue is not empty.
+template <class T>
+void BlockingQueue<T>::popLocked(T &out) {
+    out = std::move(items.getFront());
+    items.dequeue();
+    if (waitingPushers > 0) {
+        notFull.notify_one();
+    }
+}
+
+// **Public** //
+// push()
+//
+// Waits until there is room. Returns false if the queue is closed.
+template <class T>
+bool BlockingQueue<T>::push(const T &newData) {
+    return push_until(newData, std::chrono::steady_clock::time_point::max());
+}
+
+template <class T>
+bool BlockingQueue<T>::push(T &&newData) {
+    return push_until(std::move(newData), std::chrono::steady_clock::time_point::max());
+}
+
+// **Public** //
+// pop()
+//
+// Waits until there is data. Returns false once the queue is closed
+// and every remaining item has been popped.
+template <class T>
+bool BlockingQueue<T>::pop(T &out) {
+    return pop_until(out, std::chrono::steady_clock::time_point::max());
+}
+
+// **Public** //
+// try_push()
+//
+// Returns false immediately if the queue is full or closed.
+template <class T>
+bool BlockingQueue<T>::try_push(const T &newData) {
+    std::unique_lock<std::mutex> guard(lock);
+    if (closed || items.isFull()) {
+        return false;
+    }
+    return pushLocked(guard, newData);
+}
+
+template <class T>
+bool BlockingQueue<T>::try_push(T &&newData) {
+    std::unique_lock<std::mutex> guard(lock);
+    if (closed || items.isFull()) {
+        return false;
+    }
+    return pushLocked(guard, std::move(newData));
+}
+
+// **Public** //
+// try_pop()
+//
+// Returns false immediately if the queue is empty.
+template <class T>
+bool BlockingQueue<T>::try_pop(T &out) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (items.isEmpty()) {
+        return false;
+    }
+    popLocked(out);
+    return true;
+}
+
+// **Public** //
+// push_until()
+//
+// Like push(), but gives up and returns false at the deadline.
+template <class T>
+template <class U, class Clock, class Duration>
+bool BlockingQueue<T>::push_until(U &&newData, const std::chrono::time_point<Clock, Duration> &deadline) {
+    std::unique_lock<std::mutex> guard(lock);
+
+    if (!closed && items.isFull()) {
+        ++waitingPushers;
+        auto ready = [this] { return closed || !items.isFull(); };
+        if (deadline == Clock::time_point::max()) {
+            notFull.wait(guard, ready);
+        }
+        else {
+            notFull.wait_until(guard, deadline, ready);
+        }
+        --waitingPushers;
+    }
+    if (closed || items.isFull()) {
+        return false;
+    }
+    return pushLocked(guard, std::forward<U>(newData));
+}
+
+// **Public** //
+// pop_until()
+//
+// Like pop(), but gives up and returns false at the deadline.
+template <class T>
+template <class Clock, class Duration>
+bool BlockingQueue<T>::pop_until(T &out, const std::chrono::time_point<Clock, Duration> &deadline) {
+    std::unique_lock<std::mutex> guard(lock);
+
+    if (!closed && items.isEmpty()) {
+        ++waitingPoppers;
+        auto ready = [this] { return closed || !items.isEmpty(); };
+        if (deadline == Clock::time_point::max()) {
+            notEmpty.wait(guard, ready);
+        }
+        else {
+            notEmpty.wait_until(guard, deadline, ready);
+        }
+        --waitingPoppers;
+    }
+    if (items.isEmpty()) {
+        return false;
+    }
+    popLocked(out);
+    return true;
+}
+
+// **Public** //
+// push_for()
+template <class T>
+template <class U, class Rep, class Period>
+bool BlockingQueue<T>::push_for(U &&newData, const std::chrono::duration<Rep, Period> &timeout) {
+    return push_until(std::forward<U>(newData), std::chrono::steady_clock::now() + timeout);
+}
+
+// **Public** //
+// pop_for()
+template <class T>
+template <class Rep, class Period>
+bool BlockingQueue<T>::pop_for(T &out, const std::chrono::duration<Rep, Period> &timeout) {
+    return pop_until(out, std::chrono::steady_clock::now() + timeout);
+}
+
+#ifdef BLOCKING_QUEUE_COROUTINES
+// **Public** //
+// pop()
+//
+// co_await queue.pop() yields the next item, or an empty optional
+// once the queue is closed and drained.
+template <class T>
+typename BlockingQueue<T>::PopAwaiter BlockingQueue<T>::pop() {
+    return PopAwaiter(this);
+}
+#endif
+
+// **Public** //
+// close()
+//
+// Rejects further pushes and wakes everything that is waiting.
+template <class T>
+void BlockingQueue<T>::close() {
+    std::unique_lock<std::mutex> guard(lock);
+    closed = true;
+#ifdef BLOCKING_QUEUE_COROUTINES
+    PopAwaiter *awaiters = awaitFront;
+    awaitFront = awaitRear = nullptr;
+#endif
+    guard.unlock();
+
+    notEmpty.notify_all();
+    notFull.notify_all();
+
+#ifdef BLOCKING_QUEUE_COROUTINES
+    while (awaiters) {
+        PopAwaiter *next = awaiters->next;
+        awaiters->handle.resume();
+        awaiters = next;
+    }
+#endif
+}
+
+// **Public** //
+// isClosed()
+template <class T>
+bool BlockingQueue<T>::isClosed() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return closed;
+}
+
+// **Public** //
+// isEmpty()
+template <class T>
+bool BlockingQueue<T>::isEmpty() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return items.isEmpty();
+}
+
+// **Public** //
+// isFull()
+template <class T>
+bool BlockingQueue<T>::isFull() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return items.isFull();
+}
+
+// **Public** //
+// getSize()
+template <class T>
+int BlockingQueue<T>::getSize() const {
+    return items.getSize();
+}
+
+// **Public** //
+// getNumItems()
+template <class T>
+int BlockingQueue<T>::getNumItems() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return items.getNumItems();
+}
+
+#endif /* BlockingQueue.hpp */
@@ -0,0 +1,254 @@
+//
+//  ConcurrentLinkedList.hpp
+//  CustomLibraries
+//
+//  Description
+//
+//  A lock-free sorted singly linked list that any number of threads
+//  can insert into, erase from and search at the same time. It holds a
+//  set of T kept in Compare order (duplicates are rejected), which
+//  makes it a building block for lock-free hash buckets and small
+//  ordered sets.
+//
+//  This is the Harris-Michael algorithm. Erasing a node is done in two
+//  steps: the low bit of the node's own next pointer is set first,
+//  which logically deletes it and stops anyone from linking after it,
+//  and then the node is unlinked from its predecessor. Any traversal
+//  that comes across a marked node finishes the unlink for it.
+//
+//  Unlinked nodes are handed to EpochDomain, which deletes them once
+//  no thread can still be reading them. Every public operation takes
+//  its own EpochGuard, so callers do not need to.
+//
+
+#ifndef ConcurrentLinkedList_hpp
+#define ConcurrentLinkedList_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+#include "EpochReclamation.hpp"
+
+template <class T, class Compare = std::less<T>>
+class ConcurrentLinkedList {
+private:
+    struct Node {
+        T data;
+        std::atomic<uintptr_t> next;    // Low bit set: this node is erased
+
+        template <class U>
+        explicit Node(U &&d) : data{std::forward<U>(d)}, next{0} {}
+    };
+
+    static constexpr uintptr_t MARK = 1;
+
+    std::atomic<uintptr_t> head;
+    Compare comp;
+
+    static Node *pointer(uintptr_t word) { return reinterpret_cast<Node *>(word & ~MARK); }
+    static bool  marked(uintptr_t word)  { return (word & MARK) != 0; }
+    static uintptr_t word(Node *n)       { return reinterpret_cast<uintptr_t>(n); }
+
+    bool find(const T &, std::atomic<uintptr_t> *&, Node *&);
+
+public:
+    // Constructor
+    explicit ConcurrentLinkedList(const Compare & = Compare());
+    ConcurrentLinkedList(const ConcurrentLinkedList &) = delete;
+    ConcurrentLinkedList &operator=(const ConcurrentLinkedList &) = delete;
+
+    // Destructor
+    ~ConcurrentLinkedList();
+
+    // Functions
+    bool insert(const T &);
+    bool insert(T &&);
+    bool erase(const T &);
+    bool contains(const T &) const;
+    bool isEmpty() const;
+    template <class Visitor>
+    void forEach(Visitor) const;
+};
+
+// Constructor
+template <class T, class Compare>
+ConcurrentLinkedList<T, Compare>::ConcurrentLinkedList(const Compare &c)
+    : head{0}, comp{c} { }
+
+// Destructor
+//
+// No other thread may be using the list any more.
+template <class T, class Compare>
+ConcurrentLinkedList<T, Compare>::~ConcurrentLinkedList() {
+    Node *n = pointer(head.load(std::memory_order_relaxed));
+    while (n) {
+        Node *next = pointer(n->next.load(std::memory_order_relaxed));
+        delete n;
+        n = next;
+    }
+}
+
+// **Private** //
+// find()
+//
+// Positions prev at the link pointing to the first node not ordered
+// before key, and curr at that node (nullptr at the end of the list).
+// Marked nodes met on the way are unlinked and retired. Returns true
+// if curr holds key. The caller must hold an EpochGuard.
+template <class T, class Compare>
+bool ConcurrentLinkedList<T, Compare>::find(const T &key, std::atomic<uintptr_t> *&prev, Node *&curr) {
+retry:
+    prev = &head;
+    curr = pointer(prev->load(std::memory_order_acquire));
+
+    while (curr) {
+        uintptr_t nextWord = curr->next.load(std::memory_order_acquire);
+        Node *next = pointer(nextWord);
+
+        // prev was erased or changed under us
+        if (prev->load(std::memory_order_acquire) != word(curr)) {
+            goto retry;
+        }
+        if (!marked(nextWord)) {
+            if (!comp(curr->data, key)) {
+                return !comp(key, curr->data);
+            }
+            prev = &curr->next;
+        }
+        else {
+            uintptr_t expected = word(curr);
+            if (!prev->compare_exchange_strong(expected, word(next), std::memory_order_acq_rel)) {
+                goto retry;
+            }
+            EpochDomain::global().retire(curr);
+        }
+        curr = next;
+    }
+    return false;
+}
+
+// **Public** //
+// insert()
+//
+// Returns false if an equal item is already in the list.
+template <class T, class Compare>
+bool ConcurrentLinkedList<T, Compare>::insert(const T &item) {
+    return insert(T(item));
+}
+
+template <class T, class Compare>
+bool ConcurrentLinkedList<T, Compare>::insert(T &&item) {
+    EpochGuard guard;
+    Node *newNode = nullptr;
+    std::atomic<uintptr_t> *prev;
+    Node *curr;
+
+    for (;;) {
+        if (find(newNode ? newNode->data : item, prev, curr)) {
+            delete newNode;
+            return false;
+        }
+        if (newNode == nullptr) {
+            newNode = new Node(std::move(item));
+        }
+        newNode->next.store(word(curr), std::memory_order_relaxed);
+
+        uintptr_t expected = word(curr);
+        if (prev->compare_exchange_strong(expected, word(newNode), std::memory_order_release,
+                                          std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+}
+
+// **Public** //
+// erase()
+//
+// Returns false if the item is not in the list.
+template <class T, class Compare>
+bool ConcurrentLinkedList<T, Compare>::erase(const T &item) {
+    EpochGuard guard;
+    std::atomic<uintptr_t> *prev;
+    Node *curr;
+
+    for (;;) {
+        if (!find(item, prev, curr)) {
+            return false;
+        }
+        uintptr_t nextWord = curr->next.load(std::memory_order_acquire);
+        if (marked(nextWord)) {
+            continue;
+        }
+        // Logical deletion: whoever sets the mark owns the erase
+        if (!curr->next.compare_exchange_strong(nextWord, nextWord | MARK,
+                                                std::memory_order_acq_rel)) {
+            continue;
+        }
+        uintptr_t expected = word(curr);
+        if (prev->compare_exchange_strong(expected, nextWord, std::memory_order_acq_rel)) {
+            EpochDomain::global().retire(curr);
+        }
+        else {
+            find(item, prev, curr);
+        }
+        return true;
+    }
+}
+
+// **Public** //
+// contains()
+//
+// Wait-free: walks past marked nodes instead of unlinking them.
+template <class T, class Compare>
+bool ConcurrentLinkedList<T, Compare>::contains(const T &item) const {
+    EpochGuard guard;
+    Node *curr = pointer(head.load(std::memory_order_acquire));
+
+    while (curr && comp(curr->data, item)) {
+        curr = pointer(curr->next.load(std::memory_order_acquire));
+    }
+    return curr && !comp(item, curr->data) &&
+           !marked(curr->next.load(std::memory_order_acquire));
+}
+
+// **Public** //
+// isEmpty()
+template <class T, class Compare>
+bool ConcurrentLinkedList<T, Compare>::isEmpty() const {
+    EpochGuard guard;
+    Node *curr = pointer(head.load(std::memory_order_acquire));
+
+    while (curr) {
+        uintptr_t nextWord = curr->next.load(std::memory_order_acquire);
+        if (!marked(nextWord)) {
+            return false;
+        }
+        curr = pointer(nextWord);
+    }
+    return true;
+}
+
+// **Public** //
+// forEach()
+//
+// Calls visitor(item) on the items in order. Items inserted or erased
+// while the walk is under way may or may not be seen.
+template <class T, class Compare>
+template <class Visitor>
+void ConcurrentLinkedList<T, Compare>::forEach(Visitor visitor) const {
+    EpochGuard guard;
+    Node *curr = pointer(head.load(std::memory_order_acquire));
+
+    while (curr) {
+        uintptr_t nextWord = curr->next.load(std::memory_order_acquire);
+        if (!marked(nextWord)) {
+            visitor(curr->data);
+        }
+        curr = pointer(nextWord);
+    }
+}
+
+#endif /* ConcurrentLinkedList.hpp */
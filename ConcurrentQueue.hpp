@@ -0,0 +1,440 @@
+//
+//  ConcurrentQueue.hpp
+//  CustomLibraries
+//
+//  Description
+//
+//  Lock-free, fixed capacity counterparts to Queue that can be shared
+//  between threads without a mutex. Both use the same vocabulary as
+//  Queue (enqueue, dequeue, isEmpty, isFull, getSize, getNumItems) and
+//  the same meaning for the size constructor argument: the most items
+//  the queue will hold at once.
+//
+//  SPSCQueue   Exactly one producer thread and one consumer thread.
+//              Every operation is wait-free. Each side keeps a private
+//              copy of the other side's index and only rereads the
+//              shared one when that copy says the queue is full/empty.
+//
+//  MPMCQueue   Any number of producers and consumers. Each slot carries
+//              a sequence number that tells a thread whether the slot
+//              is ready for it (Dmitry Vyukov's bounded MPMC queue), so
+//              producers and consumers only contend on their own index.
+//
+//  The indices written by producers and by consumers are kept on
+//  separate cache lines so the two sides do not false share.
+//  isEmpty(), isFull() and getNumItems() are snapshots and may already
+//  be stale when they return if other threads are active.
+//
+
+#ifndef ConcurrentQueue_hpp
+#define ConcurrentQueue_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Size used to keep producer and consumer state on separate lines
+static constexpr size_t QUEUE_CACHE_LINE_SIZE = 64;
+
+
+// Single Producer, Single Consumer Queue
+template <class T>
+class SPSCQueue {
+private:
+    // Consumer State
+    alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> head;
+    size_t cachedTail;
+
+    // Producer State
+    alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> tail;
+    size_t cachedHead;
+
+    // Shared, read-only after construction
+    alignas(QUEUE_CACHE_LINE_SIZE) T *buffer;
+    size_t capacity;    // Slots in buffer, always a power of two
+    size_t mask;
+    size_t size;
+
+    std::allocator<T> alloc;
+
+    T *slot(size_t index) const { return buffer + (index & mask); }
+
+public:
+    // Constructor
+    explicit SPSCQueue(int=10);
+    SPSCQueue(const SPSCQueue &) = delete;
+    SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+    // Destructor
+    ~SPSCQueue();
+
+    // Producer Functions
+    bool enqueue(const T &);
+    bool enqueue(T &&);
+    template <class... Args>
+    bool emplace(Args &&...);
+
+    // Consumer Functions
+    bool dequeue(T &);
+    bool dequeue();
+    T   *getFront();
+
+    bool isEmpty() const;
+    bool isFull() const;
+    int  getSize() const;
+    int  getNumItems() const;
+};
+
+// Constructor
+template <class T>
+SPSCQueue<T>::SPSCQueue(int s)
+    : head{0}, cachedTail{0}, tail{0}, cachedHead{0} {
+    size     = (s > 0) ? s : 1;
+    capacity = 1;
+    while (capacity < size) {
+        capacity <<= 1;
+    }
+    mask   = capacity - 1;
+    buffer = alloc.allocate(capacity);
+}
+
+// Destructor
+template <class T>
+SPSCQueue<T>::~SPSCQueue() {
+    while (dequeue()) { }
+    alloc.deallocate(buffer, capacity);
+}
+
+// **Producer** //
+// enqueue()
+//
+// Returns false when the queue is full.
+template <class T>
+bool SPSCQueue<T>::enqueue(const T &newData) {
+    return emplace(newData);
+}
+
+template <class T>
+bool SPSCQueue<T>::enqueue(T &&newData) {
+    return emplace(std::move(newData));
+}
+
+// **Producer** //
+// emplace()
+template <class T>
+template <class... Args>
+bool SPSCQueue<T>::emplace(Args &&...args) {
+    size_t t = tail.load(std::memory_order_relaxed);
+
+    if (t - cachedHead >= size) {
+        cachedHead = head.load(std::memory_order_acquire);
+        if (t - cachedHead >= size) {
+            return false;
+        }
+    }
+    ::new (static_cast<void *>(slot(t))) T(std::forward<Args>(args)...);
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+// **Consumer** //
+// getFront()
+//
+// Returns the front item, or nullptr when the queue is empty. Only
+// valid until the consumer next dequeues.
+template <class T>
+T *SPSCQueue<T>::getFront() {
+    size_t h = head.load(std::memory_order_relaxed);
+
+    if (h == cachedTail) {
+        cachedTail = tail.load(std::memory_order_acquire);
+        if (h == cachedTail) {
+            return nullptr;
+        }
+    }
+    return slot(h);
+}
+
+// **Consumer** //
+// dequeue()
+//
+// Moves the front item into out. Returns false when the queue is empty.
+template <class T>
+bool SPSCQueue<T>::dequeue(T &out) {
+    T *item = getFront();
+    if (item == nullptr) {
+        return false;
+    }
+    out = std::move(*item);
+    return dequeue();
+}
+
+template <class T>
+bool SPSCQueue<T>::dequeue() {
+    T *item = getFront();
+    if (item == nullptr) {
+        return false;
+    }
+    item->~T();
+    head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    return true;
+}
+
+// **Public** //
+// isEmpty()
+template <class T>
+bool SPSCQueue<T>::isEmpty() const {
+    return getNumItems() <= 0;
+}
+
+// **Public** //
+// isFull()
+template <class T>
+bool SPSCQueue<T>::isFull() const {
+    return static_cast<size_t>(getNumItems()) >= size;
+}
+
+// **Public** //
+// getSize()
+template <class T>
+int SPSCQueue<T>::getSize() const {
+    return static_cast<int>(size);
+}
+
+// **Public** //
+// getNumItems()
+template <class T>
+int SPSCQueue<T>::getNumItems() const {
+    size_t h = head.load(std::memory_order_acquire);
+    size_t t = tail.load(std::memory_order_acquire);
+    return (t > h) ? static_cast<int>(t - h) : 0;
+}
+
+
+// Multiple Producer, Multiple Consumer Queue
+template <class T>
+class MPMCQueue {
+private:
+    // A slot is free for the producer claiming position pos when its
+    // sequence equals pos, and holds data for the consumer claiming
+    // pos when its sequence equals pos + 1.
+    struct Cell {
+        std::atomic<size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T *data() { return reinterpret_cast<T *>(&storage); }
+    };
+
+    // Shared, read-only after construction
+    alignas(QUEUE_CACHE_LINE_SIZE) Cell *cells;
+    size_t numCells;
+    size_t size;
+
+    // Producer State
+    alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> enqueuePos;
+
+    // Consumer State
+    alignas(QUEUE_CACHE_LINE_SIZE) std::atomic<size_t> dequeuePos;
+
+    Cell *claimEnqueue();
+    Cell *claimDequeue(size_t &);
+
+public:
+    // Constructor
+    explicit MPMCQueue(int=10);
+    MPMCQueue(const MPMCQueue &) = delete;
+    MPMCQueue &operator=(const MPMCQueue &) = delete;
+
+    // Destructor
+    ~MPMCQueue();
+
+    // Functions
+    bool enqueue(const T &);
+    bool enqueue(T &&);
+    template <class... Args>
+    bool emplace(Args &&...);
+    bool dequeue(T &);
+
+    bool isEmpty() const;
+    bool isFull() const;
+    int  getSize() const;
+    int  getNumItems() const;
+};
+
+// Constructor
+//
+// The slots are indexed modulo the cell count rather than a power of
+// two so the queue holds exactly the requested number of items. A
+// single cell cannot tell full from empty by its sequence alone, so a
+// queue of size 1 gets two cells and claimEnqueue() enforces the size.
+template <class T>
+MPMCQueue<T>::MPMCQueue(int s)
+    : enqueuePos{0}, dequeuePos{0} {
+    size     = (s > 0) ? s : 1;
+    numCells = (size > 1) ? size : 2;
+    cells    = new Cell[numCells];
+    for (size_t i = 0; i < numCells; ++i) {
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+// Destructor
+template <class T>
+MPMCQueue<T>::~MPMCQueue() {
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    size_t end = enqueuePos.load(std::memory_order_relaxed);
+
+    for (; pos != end; ++pos) {
+        cells[pos % numCells].data()->~T();
+    }
+    delete [] cells;
+}
+
+// **Private** //
+// claimEnqueue()
+//
+// Reserves the next producer slot, or returns nullptr when full.
+template <class T>
+typename MPMCQueue<T>::Cell *MPMCQueue<T>::claimEnqueue() {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+
+    for (;;) {
+        if (size < numCells) {
+            // pos may be stale and already behind dequeuePos; reload it
+            // rather than reading the wrapped difference as full
+            intptr_t used = static_cast<intptr_t>(pos - dequeuePos.load(std::memory_order_acquire));
+            if (used < 0) {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (static_cast<size_t>(used) >= size) {
+                return nullptr;
+            }
+        }
+        Cell *cell = &cells[pos % numCells];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                return cell;
+            }
+        }
+        else if (diff < 0) {
+            return nullptr;
+        }
+        else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// **Private** //
+// claimDequeue()
+//
+// Reserves the next consumer slot, or returns nullptr when empty.
+// pos receives the position that was claimed.
+template <class T>
+typename MPMCQueue<T>::Cell *MPMCQueue<T>::claimDequeue(size_t &pos) {
+    pos = dequeuePos.load(std::memory_order_relaxed);
+
+    for (;;) {
+        Cell *cell = &cells[pos % numCells];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+
+        if (diff == 0) {
+            if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                return cell;
+            }
+        }
+        else if (diff < 0) {
+            return nullptr;
+        }
+        else {
+            pos = dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// **Public** //
+// enqueue()
+//
+// Returns false when the queue is full.
+template <class T>
+bool MPMCQueue<T>::enqueue(const T &newData) {
+    return emplace(newData);
+}
+
+template <class T>
+bool MPMCQueue<T>::enqueue(T &&newData) {
+    return emplace(std::move(newData));
+}
+
+// **Public** //
+// emplace()
+template <class T>
+template <class... Args>
+bool MPMCQueue<T>::emplace(Args &&...args) {
+    Cell *cell = claimEnqueue();
+    if (cell == nullptr) {
+        return false;
+    }
+    size_t pos = cell->sequence.load(std::memory_order_relaxed);
+    ::new (static_cast<void *>(cell->data())) T(std::forward<Args>(args)...);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+// **Public** //
+// dequeue()
+//
+// Moves the front item into out. Returns false when the queue is empty.
+template <class T>
+bool MPMCQueue<T>::dequeue(T &out) {
+    size_t pos;
+    Cell *cell = claimDequeue(pos);
+    if (cell == nullptr) {
+        return false;
+    }
+    out = std::move(*cell->data());
+    cell->data()->~T();
+    cell->sequence.store(pos + numCells, std::memory_order_release);
+    return true;
+}
+
+// **Public** //
+// isEmpty()
+template <class T>
+bool MPMCQueue<T>::isEmpty() const {
+    return getNumItems() <= 0;
+}
+
+// **Public** //
+// isFull()
+template <class T>
+bool MPMCQueue<T>::isFull() const {
+    return static_cast<size_t>(getNumItems()) >= size;
+}
+
+// **Public** //
+// getSize()
+template <class T>
+int MPMCQueue<T>::getSize() const {
+    return static_cast<int>(size);
+}
+
+// **Public** //
+// getNumItems()
+template <class T>
+int MPMCQueue<T>::getNumItems() const {
+    size_t d = dequeuePos.load(std::memory_order_acquire);
+    size_t e = enqueuePos.load(std::memory_order_acquire);
+    return (e > d) ? static_cast<int>(e - d) : 0;
+}
+
+#endif /* ConcurrentQueue.hpp */
@@ -0,0 +1,540 @@
+//
+//  ConcurrentSkipList.hpp
+//  CustomLibraries
+//
+//  Description
+//
+//  A lock-free ordered map built on a skip list, the concurrent
+//  counterpart to AVLTree. Any number of threads can insert, remove and
+//  look up keys at the same time, and the map can be walked in key
+//  order or scanned over a key range while that is going on. It is
+//  meant for write-heavy ordered indexes such as an LSM memtable.
+//
+//  Each key lives in one node with a tower of 1 to MAX_HEIGHT forward
+//  links. Removing a node marks its links from the top down (the level
+//  0 mark is what actually removes the key), and traversals unlink any
+//  marked node they pass, as in ConcurrentLinkedList.
+//
+//  Nodes are carved out of an arena of large chunks with an atomic bump
+//  pointer, so an insert never calls into the general allocator. Nodes
+//  are not freed when removed, only when the map is destroyed. This is
+//  what makes lock-free readers safe without any reclamation scheme,
+//  and it suits the memtable pattern of filling the map, flushing it
+//  and dropping it whole. Pointers returned by find() stay valid for
+//  the life of the map.
+//
+
+#ifndef ConcurrentSkipList_hpp
+#define ConcurrentSkipList_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <utility>
+
+template <class K, class V, class Compare = std::less<K>>
+class ConcurrentSkipList {
+public:
+    typedef std::pair<const K, V> value_type;
+
+private:
+    static constexpr int       MAX_HEIGHT  = 16;        // Enough for 4^16 keys at p = 1/4
+    static constexpr size_t    CHUNK_BYTES = 64 * 1024;
+    static constexpr uintptr_t MARK        = 1;
+
+    struct Node {
+        value_type             entry;
+        Node                  *removedNext;     // Chain of removed nodes, for the destructor
+        int                    height;
+        std::atomic<uintptr_t> next[1];         // height links, the rest follow the node
+
+        template <class Key, class Value>
+        Node(Key &&k, Value &&v, int h)
+            : entry(std::forward<Key>(k), std::forward<Value>(v)), removedNext{nullptr}, height{h} {
+            next[0].store(0, std::memory_order_relaxed);
+            for (int i = 1; i < h; ++i) {
+                new (&next[i]) std::atomic<uintptr_t>(0);
+            }
+        }
+    };
+
+    struct Chunk {
+        Chunk              *prev;
+        size_t              capacity;
+        std::atomic<size_t> used;
+    };
+
+    static constexpr size_t ALIGN        = alignof(Node) > alignof(Chunk) ? alignof(Node) : alignof(Chunk);
+    static constexpr size_t CHUNK_HEADER = (sizeof(Chunk) + ALIGN - 1) & ~(ALIGN - 1);
+
+    alignas(64) std::atomic<uintptr_t> head[MAX_HEIGHT];
+    alignas(64) std::atomic<Chunk *>   chunks;
+    alignas(64) std::atomic<Node *>    removed;
+    alignas(64) std::atomic<size_t>    numItems;
+    Compare comp;
+
+    static Node *pointer(uintptr_t word) { return reinterpret_cast<Node *>(word & ~MARK); }
+    static bool  marked(uintptr_t word)  { return (word & MARK) != 0; }
+    static uintptr_t word(Node *n)       { return reinterpret_cast<uintptr_t>(n); }
+    static char *chunkData(Chunk *c)     { return reinterpret_cast<char *>(c) + CHUNK_HEADER; }
+
+    void *allocate(size_t);
+    static int randomHeight();
+    template <class Key, class Value>
+    bool insertNode(Key &&, Value &&);
+    bool find(const K &, std::atomic<uintptr_t> **, Node **);
+    Node *seek(const K &) const;
+    static Node *nextLive(Node *);
+
+public:
+    class const_iterator {
+    private:
+        friend class ConcurrentSkipList;
+        Node *node;
+        explicit const_iterator(Node *n) : node{n} {}
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::pair<const K, V>     value_type;
+        typedef std::ptrdiff_t            difference_type;
+        typedef const value_type *        pointer;
+        typedef const value_type &        reference;
+
+        const_iterator() : node{nullptr} {}
+
+        reference operator*() const { return node->entry; }
+        pointer operator->() const { return &node->entry; }
+
+        const_iterator &operator++() { node = nextLive(node); return *this; }
+        const_iterator operator++(int) { const_iterator t = *this; node = nextLive(node); return t; }
+
+        bool operator==(const const_iterator &other) const { return node == other.node; }
+        bool operator!=(const const_iterator &other) const { return node != other.node; }
+    };
+
+    // Constructor
+    explicit ConcurrentSkipList(const Compare & = Compare());
+    ConcurrentSkipList(const ConcurrentSkipList &) = delete;
+    ConcurrentSkipList &operator=(const ConcurrentSkipList &) = delete;
+
+    // Destructor
+    ~ConcurrentSkipList();
+
+    // Iterators
+    //
+    // Weakly consistent: a walk sees every key that was present for the
+    // whole walk, and may or may not see keys inserted or removed
+    // while it is under way.
+    const_iterator begin() const;
+    const_iterator end() const { return const_iterator(); }
+    const_iterator lowerBound(const K &) const;
+
+    // Functions
+    bool insert(const K &, const V &);
+    bool insert(K &&, V &&);
+    bool remove(const K &);
+    bool contains(const K &) const;
+    const V *find(const K &) const;
+    bool isEmpty() const;
+    size_t getNumItems() const;
+    size_t getMemoryUsage() const;
+    template <class Visitor>
+    void forEach(Visitor) const;
+    template <class Visitor>
+    void scan(const K &, const K &, Visitor) const;
+};
+
+// Constructor
+template <class K, class V, class Compare>
+ConcurrentSkipList<K, V, Compare>::ConcurrentSkipList(const Compare &c)
+    : chunks{nullptr}, removed{nullptr}, numItems{0}, comp{c} {
+    for (int i = 0; i < MAX_HEIGHT; ++i) {
+        head[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+// Destructor
+//
+// No other thread may be using the map any more. Live nodes are still
+// on level 0, removed ones are on the removed chain, and nodes that
+// lost an insert race were destroyed on the spot; then the chunks go.
+template <class K, class V, class Compare>
+ConcurrentSkipList<K, V, Compare>::~ConcurrentSkipList() {
+    Node *n = pointer(head[0].load(std::memory_order_relaxed));
+    while (n) {
+        uintptr_t nextWord = n->next[0].load(std::memory_order_relaxed);
+        if (!marked(nextWord)) {
+            n->~Node();
+        }
+        n = pointer(nextWord);
+    }
+    for (n = removed.load(std::memory_order_relaxed); n; ) {
+        Node *next = n->removedNext;
+        n->~Node();
+        n = next;
+    }
+
+    Chunk *c = chunks.load(std::memory_order_relaxed);
+    while (c) {
+        Chunk *prev = c->prev;
+        c->~Chunk();
+        ::operator delete(c, std::align_val_t(ALIGN));
+        c = prev;
+    }
+}
+
+// **Private** //
+// allocate()
+//
+// Bumps the current chunk, or installs a new one when it is full.
+// Oversized requests get a chunk of their own.
+template <class K, class V, class Compare>
+void *ConcurrentSkipList<K, V, Compare>::allocate(size_t bytes) {
+    bytes = (bytes + ALIGN - 1) & ~(ALIGN - 1);
+    Chunk *c = chunks.load(std::memory_order_acquire);
+
+    for (;;) {
+        if (c) {
+            size_t used = c->used.load(std::memory_order_relaxed);
+            while (used + bytes <= c->capacity) {
+                if (c->used.compare_exchange_weak(used, used + bytes, std::memory_order_relaxed)) {
+                    return chunkData(c) + used;
+                }
+            }
+        }
+
+        size_t capacity = CHUNK_BYTES - CHUNK_HEADER;
+        if (bytes > capacity) {
+            capacity = bytes;
+        }
+        void *raw = ::operator new(CHUNK_HEADER + capacity, std::align_val_t(ALIGN));
+        Chunk *fresh = new (raw) Chunk{c, capacity, {bytes}};
+
+        if (chunks.compare_exchange_strong(c, fresh, std::memory_order_acq_rel,
+                                           std::memory_order_acquire)) {
+            return chunkData(fresh);
+        }
+        // Someone else installed a chunk first, c now points at it
+        fresh->~Chunk();
+        ::operator delete(raw, std::align_val_t(ALIGN));
+    }
+}
+
+// **Private** //
+// randomHeight()
+//
+// Geometric with p = 1/4, from a per-thread xorshift generator.
+template <class K, class V, class Compare>
+int ConcurrentSkipList<K, V, Compare>::randomHeight() {
+    static thread_local uint64_t state = 0;
+    if (state == 0) {
+        state = reinterpret_cast<uintptr_t>(&state) | 1;
+    }
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+
+    int h = 1;
+    uint64_t bits = state;
+    while (h < MAX_HEIGHT && (bits & 3) == 0) {
+        ++h;
+        bits >>= 2;
+    }
+    return h;
+}
+
+// **Private** //
+// find()
+//
+// Fills preds[i] with the level i link of the last node ordered before
+// key (or of the head) and succs[i] with the node after it, unlinking
+// marked nodes on the way. Returns true if succs[0] holds key.
+template <class K, class V, class Compare>
+bool ConcurrentSkipList<K, V, Compare>::find(const K &key, std::atomic<uintptr_t> **preds, Node **succs) {
+retry:
+    std::atomic<uintptr_t> *links = head;
+
+    for (int level = MAX_HEIGHT - 1; level >= 0; --level) {
+        Node *curr = pointer(links[level].load(std::memory_order_acquire));
+
+        while (curr) {
+            uintptr_t nextWord = curr->next[level].load(std::memory_order_acquire);
+            if (marked(nextWord)) {
+                uintptr_t expected = word(curr);
+                if (!links[level].compare_exchange_strong(expected, nextWord & ~MARK,
+                                                          std::memory_order_acq_rel)) {
+                    goto retry;
+                }
+                curr = pointer(nextWord);
+                continue;
+            }
+            if (!comp(curr->entry.first, key)) {
+                break;
+            }
+            links = curr->next;
+            curr = pointer(nextWord);
+        }
+        preds[level] = &links[level];
+        succs[level] = curr;
+    }
+    return succs[0] && !comp(key, succs[0]->entry.first);
+}
+
+// **Private** //
+// seek()
+//
+// The first node not ordered before key that is not removed, or
+// nullptr. Never writes, so readers do not contend with each other.
+template <class K, class V, class Compare>
+typename ConcurrentSkipList<K, V, Compare>::Node *
+ConcurrentSkipList<K, V, Compare>::seek(const K &key) const {
+    const std::atomic<uintptr_t> *links = head;
+    Node *curr = nullptr;
+
+    for (int level = MAX_HEIGHT - 1; level >= 0; --level) {
+        curr = pointer(links[level].load(std::memory_order_acquire));
+
+        while (curr) {
+            uintptr_t nextWord = curr->next[level].load(std::memory_order_acquire);
+            if (!marked(nextWord)) {
+                if (!comp(curr->entry.first, key)) {
+                    break;
+                }
+                links = curr->next;
+            }
+            curr = pointer(nextWord);
+        }
+    }
+    return curr;
+}
+
+// **Private** //
+// nextLive()
+//
+// The first node after n on level 0 that is not removed.
+template <class K, class V, class Compare>
+typename ConcurrentSkipList<K, V, Compare>::Node *
+ConcurrentSkipList<K, V, Compare>::nextLive(Node *n) {
+    n = pointer(n->next[0].load(std::memory_order_acquire));
+    while (n && marked(n->next[0].load(std::memory_order_acquire))) {
+        n = pointer(n->next[0].load(std::memory_order_acquire));
+    }
+    return n;
+}
+
+// **Private** //
+// insertNode()
+//
+// Links the node on level 0 first, which is the point the key becomes
+// visible, then builds the rest of its tower one level at a time. If
+// the node is removed while the tower is going up, building stops.
+template <class K, class V, class Compare>
+template <class Key, class Value>
+bool ConcurrentSkipList<K, V, Compare>::insertNode(Key &&key, Value &&value) {
+    std::atomic<uintptr_t> *preds[MAX_HEIGHT];
+    Node *succs[MAX_HEIGHT];
+
+    if (find(key, preds, succs)) {
+        return false;
+    }
+
+    int h = randomHeight();
+    Node *node = new (allocate(sizeof(Node) + (h - 1) * sizeof(std::atomic<uintptr_t>)))
+        Node(std::forward<Key>(key), std::forward<Value>(value), h);
+    const K &k = node->entry.first;
+
+    for (;;) {
+        for (int i = 0; i < h; ++i) {
+            node->next[i].store(word(succs[i]), std::memory_order_relaxed);
+        }
+        uintptr_t expected = word(succs[0]);
+        if (preds[0]->compare_exchange_strong(expected, word(node), std::memory_order_release,
+                                              std::memory_order_relaxed)) {
+            break;
+        }
+        if (find(k, preds, succs)) {
+            // Lost to an insert of the same key; the arena space is dropped
+            node->~Node();
+            return false;
+        }
+    }
+    numItems.fetch_add(1, std::memory_order_relaxed);
+
+    for (int level = 1; level < h; ++level) {
+        for (;;) {
+            uintptr_t link = node->next[level].load(std::memory_order_acquire);
+            if (marked(link)) {
+                return true;
+            }
+            if (pointer(link) != succs[level] &&
+                !node->next[level].compare_exchange_strong(link, word(succs[level]),
+                                                           std::memory_order_acq_rel)) {
+                continue;
+            }
+            uintptr_t expected = word(succs[level]);
+            if (preds[level]->compare_exchange_strong(expected, word(node), std::memory_order_release,
+                                                      std::memory_order_relaxed)) {
+                break;
+            }
+            find(k, preds, succs);
+            if (succs[0] != node) {
+                return true;
+            }
+        }
+    }
+    return true;
+}
+
+// **Public** //
+// begin()
+template <class K, class V, class Compare>
+typename ConcurrentSkipList<K, V, Compare>::const_iterator
+ConcurrentSkipList<K, V, Compare>::begin() const {
+    Node *n = pointer(head[0].load(std::memory_order_acquire));
+    while (n && marked(n->next[0].load(std::memory_order_acquire))) {
+        n = pointer(n->next[0].load(std::memory_order_acquire));
+    }
+    return const_iterator(n);
+}
+
+// **Public** //
+// lowerBound()
+//
+// Iterator to the first key not ordered before key.
+template <class K, class V, class Compare>
+typename ConcurrentSkipList<K, V, Compare>::const_iterator
+ConcurrentSkipList<K, V, Compare>::lowerBound(const K &key) const {
+    return const_iterator(seek(key));
+}
+
+// **Public** //
+// insert()
+//
+// Returns false, leaving the map unchanged, if key is already present.
+template <class K, class V, class Compare>
+bool ConcurrentSkipList<K, V, Compare>::insert(const K &key, const V &value) {
+    return insertNode(key, value);
+}
+
+template <class K, class V, class Compare>
+bool ConcurrentSkipList<K, V, Compare>::insert(K &&key, V &&value) {
+    return insertNode(std::move(key), std::move(value));
+}
+
+// **Public** //
+// remove()
+//
+// Returns false if key is not present, or another thread removed it
+// first.
+template <class K, class V, class Compare>
+bool ConcurrentSkipList<K, V, Compare>::remove(const K &key) {
+    std::atomic<uintptr_t> *preds[MAX_HEIGHT];
+    Node *succs[MAX_HEIGHT];
+
+    if (!find(key, preds, succs)) {
+        return false;
+    }
+    Node *node = succs[0];
+
+    for (int level = node->height - 1; level > 0; --level) {
+        uintptr_t link = node->next[level].load(std::memory_order_acquire);
+        while (!marked(link) &&
+               !node->next[level].compare_exchange_weak(link, link | MARK, std::memory_order_acq_rel)) {
+        }
+    }
+
+    // Whoever marks level 0 owns the removal
+    uintptr_t link = node->next[0].load(std::memory_order_acquire);
+    do {
+        if (marked(link)) {
+            return false;
+        }
+    } while (!node->next[0].compare_exchange_weak(link, link | MARK, std::memory_order_acq_rel));
+    numItems.fetch_sub(1, std::memory_order_relaxed);
+
+    Node *top = removed.load(std::memory_order_relaxed);
+    do {
+        node->removedNext = top;
+    } while (!removed.compare_exchange_weak(top, node, std::memory_order_release,
+                                            std::memory_order_relaxed));
+
+    // Unlink it from every level
+    find(key, preds, succs);
+    return true;
+}
+
+// **Public** //
+// contains()
+template <class K, class V, class Compare>
+bool ConcurrentSkipList<K, V, Compare>::contains(const K &key) const {
+    Node *n = seek(key);
+    return n && !comp(key, n->entry.first);
+}
+
+// **Public** //
+// find()
+//
+// Pointer to the value stored under key, or nullptr.
+template <class K, class V, class Compare>
+const V *ConcurrentSkipList<K, V, Compare>::find(const K &key) const {
+    Node *n = seek(key);
+    return (n && !comp(key, n->entry.first)) ? &n->entry.second : nullptr;
+}
+
+// **Public** //
+// isEmpty()
+template <class K, class V, class Compare>
+bool ConcurrentSkipList<K, V, Compare>::isEmpty() const {
+    return begin() == end();
+}
+
+// **Public** //
+// getNumItems()
+//
+// Exact once writers are quiet, approximate while they are running.
+template <class K, class V, class Compare>
+size_t ConcurrentSkipList<K, V, Compare>::getNumItems() const {
+    return numItems.load(std::memory_order_relaxed);
+}
+
+// **Public** //
+// getMemoryUsage()
+//
+// Bytes held by the arena, removed nodes included.
+template <class K, class V, class Compare>
+size_t ConcurrentSkipList<K, V, Compare>::getMemoryUsage() const {
+    size_t bytes = 0;
+    for (Chunk *c = chunks.load(std::memory_order_acquire); c; c = c->prev) {
+        bytes += CHUNK_HEADER + c->capacity;
+    }
+    return bytes;
+}
+
+// **Public** //
+// forEach()
+//
+// Calls visitor(key, value) in key order.
+template <class K, class V, class Compare>
+template <class Visitor>
+void ConcurrentSkipList<K, V, Compare>::forEach(Visitor visitor) const {
+    for (const_iterator it = begin(); it != end(); ++it) {
+        visitor(it->first, it->second);
+    }
+}
+
+// **Public** //
+// scan()
+//
+// Calls visitor(key, value) in key order for every key in [lo, hi).
+template <class K, class V, class Compare>
+template <class Visitor>
+void ConcurrentSkipList<K, V, Compare>::scan(const K &lo, const K &hi, Visitor visitor) const {
+    for (const_iterator it = lowerBound(lo); it != end() && comp(it->first, hi); ++it) {
+        visitor(it->first, it->second);
+    }
+}
+
+#endif /* ConcurrentSkipList.hpp */
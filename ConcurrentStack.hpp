@@ -0,0 +1,328 @@
+//
+// ConcurrentStack.hpp
+// CustomLibraries
+//
+// Description
+//
+// Lock-free counterparts to Stack for sharing between threads.
+//
+// LockFreeFreeList  An intrusive Treiber stack of nodes. Any type with a
+//                   std::atomic<Node *> next member can be pushed, which
+//                   makes it usable directly as the free list of an
+//                   object pool. It never allocates.
+//
+// ConcurrentStack   A Treiber stack of T values built from two free
+//                   lists: one holding the items and one holding spare
+//                   nodes, so steady state push/pop never calls new or
+//                   delete. When the head is contended, a push and a pop
+//                   can meet in an elimination array and hand the item
+//                   over directly without touching the head at all.
+//
+// ABA is prevented by packing a 16 bit version tag next to the 48 bit
+// pointer in the head word, so a head that was popped and pushed back
+// in between fails the compare-and-swap. Because a popping thread may
+// still read the next field of a node another thread just popped,
+// nodes must stay allocated while the list is in use. ConcurrentStack
+// only frees its nodes in its destructor.
+//
+
+#ifndef ConcurrentStack_hpp
+#define ConcurrentStack_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+static_assert(sizeof(void *) == 8, "ConcurrentStack packs tags into 64 bit pointers");
+
+
+// Intrusive Lock-Free Free List
+template<class Node>
+class LockFreeFreeList {
+private:
+    static constexpr uint64_t POINTER_MASK = (uint64_t(1) << 48) - 1;
+    static constexpr int      TAG_SHIFT    = 48;
+
+    alignas(64) std::atomic<uint64_t> head;
+
+    static uint64_t pack(Node *n, uint64_t tag) {
+        return (tag << TAG_SHIFT) | (reinterpret_cast<uintptr_t>(n) & POINTER_MASK);
+    }
+    static Node *pointer(uint64_t word) {
+        return reinterpret_cast<Node *>(static_cast<uintptr_t>(word & POINTER_MASK));
+    }
+    static uint64_t nextTag(uint64_t word) {
+        return (word >> TAG_SHIFT) + 1;
+    }
+
+public:
+    // Constructor
+    LockFreeFreeList() : head{0} { }
+    LockFreeFreeList(const LockFreeFreeList &) = delete;
+    LockFreeFreeList &operator=(const LockFreeFreeList &) = delete;
+
+    // Functions
+    void  push(Node *);
+    Node *pop();
+    bool  tryPush(Node *);
+    bool  tryPop(Node *&);
+    bool  isEmpty() const;
+};
+
+// **Public** //
+// tryPush()
+//
+// Makes a single attempt to push n. Returns false if another thread
+// changed the head first.
+template<class Node>
+bool LockFreeFreeList<Node>::tryPush(Node *n) {
+    uint64_t old = head.load(std::memory_order_relaxed);
+    n->next.store(pointer(old), std::memory_order_relaxed);
+    return head.compare_exchange_weak(old, pack(n, nextTag(old)),
+                                      std::memory_order_release,
+                                      std::memory_order_relaxed);
+}
+
+// **Public** //
+// tryPop()
+//
+// Makes a single attempt to pop into out. Returns false if another
+// thread changed the head first. On success out is nullptr if the
+// list was empty.
+template<class Node>
+bool LockFreeFreeList<Node>::tryPop(Node *&out) {
+    uint64_t old = head.load(std::memory_order_acquire);
+    Node *n = pointer(old);
+
+    if (n == nullptr) {
+        out = nullptr;
+        return true;
+    }
+    Node *next = n->next.load(std::memory_order_relaxed);
+    if (head.compare_exchange_weak(old, pack(next, nextTag(old)),
+                                   std::memory_order_acquire,
+                                   std::memory_order_relaxed)) {
+        out = n;
+        return true;
+    }
+    return false;
+}
+
+// **Public** //
+// push()
+template<class Node>
+void LockFreeFreeList<Node>::push(Node *n) {
+    while (!tryPush(n)) { }
+}
+
+// **Public** //
+// pop()
+//
+// Returns nullptr if the list is empty.
+template<class Node>
+Node *LockFreeFreeList<Node>::pop() {
+    Node *n;
+    while (!tryPop(n)) { }
+    return n;
+}
+
+// **Public** //
+// isEmpty()
+template<class Node>
+bool LockFreeFreeList<Node>::isEmpty() const {
+    return pointer(head.load(std::memory_order_acquire)) == nullptr;
+}
+
+
+// Lock-Free Stack
+template<class T>
+class ConcurrentStack {
+private:
+    struct Node {
+        std::atomic<Node *> next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+
+        T *data() { return reinterpret_cast<T *>(&storage); }
+    };
+
+    // A push parks its node in a slot for a short while. A pop that
+    // finds it there takes it, and neither touches the stack head.
+    struct alignas(64) EliminationSlot {
+        std::atomic<Node *> node;
+    };
+
+    static constexpr int ELIMINATION_SLOTS = 8;
+    static constexpr int ELIMINATION_SPINS = 128;
+
+    LockFreeFreeList<Node> items;
+    LockFreeFreeList<Node> spare;
+    EliminationSlot        slots[ELIMINATION_SLOTS];
+
+    Node *acquireNode();
+    bool  eliminatePush(Node *);
+    Node *eliminatePop();
+    static EliminationSlot &pickSlot(EliminationSlot *);
+
+public:
+    // Constructor
+    ConcurrentStack();
+    ConcurrentStack(const ConcurrentStack &) = delete;
+    ConcurrentStack &operator=(const ConcurrentStack &) = delete;
+
+    // Destructor
+    ~ConcurrentStack();
+
+    // Functions
+    bool push(const T &);
+    bool push(T &&);
+    template<class... Args>
+    bool emplace(Args &&...);
+    bool pop(T &);
+    bool isEmpty() const;
+};
+
+// Constructor
+template<class T>
+ConcurrentStack<T>::ConcurrentStack() {
+    for (EliminationSlot &slot : slots) {
+        slot.node.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+// Destructor
+template<class T>
+ConcurrentStack<T>::~ConcurrentStack() {
+    while (Node *n = items.pop()) {
+        n->data()->~T();
+        delete n;
+    }
+    while (Node *n = spare.pop()) {
+        delete n;
+    }
+}
+
+// **Private** //
+// acquireNode()
+//
+// Reuses a spare node if there is one.
+template<class T>
+typename ConcurrentStack<T>::Node *ConcurrentStack<T>::acquireNode() {
+    Node *n = spare.pop();
+    return n ? n : new Node;
+}
+
+// **Private** //
+// pickSlot()
+//
+// A per-thread xorshift spreads threads across the slots.
+template<class T>
+typename ConcurrentStack<T>::EliminationSlot &ConcurrentStack<T>::pickSlot(EliminationSlot *table) {
+    static thread_local uint32_t seed =
+        static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&seed) >> 4) | 1;
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return table[seed % ELIMINATION_SLOTS];
+}
+
+// **Private** //
+// eliminatePush()
+//
+// Offers n to a concurrent pop. Returns true if a pop took it.
+template<class T>
+bool ConcurrentStack<T>::eliminatePush(Node *n) {
+    EliminationSlot &slot = pickSlot(slots);
+    Node *expected = nullptr;
+
+    if (!slot.node.compare_exchange_strong(expected, n, std::memory_order_release,
+                                           std::memory_order_relaxed)) {
+        return false;
+    }
+    for (int i = 0; i < ELIMINATION_SPINS; ++i) {
+        if (slot.node.load(std::memory_order_relaxed) != n) {
+            return true;
+        }
+    }
+    expected = n;
+    return !slot.node.compare_exchange_strong(expected, nullptr, std::memory_order_relaxed);
+}
+
+// **Private** //
+// eliminatePop()
+//
+// Takes a node parked by a concurrent push, or returns nullptr.
+template<class T>
+typename ConcurrentStack<T>::Node *ConcurrentStack<T>::eliminatePop() {
+    EliminationSlot &slot = pickSlot(slots);
+    Node *n = slot.node.load(std::memory_order_acquire);
+
+    if (n && slot.node.compare_exchange_strong(n, nullptr, std::memory_order_acquire,
+                                               std::memory_order_relaxed)) {
+        return n;
+    }
+    return nullptr;
+}
+
+// **Public** //
+// push()
+template<class T>
+bool ConcurrentStack<T>::push(const T &item) {
+    return emplace(item);
+}
+
+template<class T>
+bool ConcurrentStack<T>::push(T &&item) {
+    return emplace(std::move(item));
+}
+
+// **Public** //
+// emplace()
+//
+// Never fails; returns true to match Stack.
+template<class T>
+template<class... Args>
+bool ConcurrentStack<T>::emplace(Args &&...args) {
+    Node *n = acquireNode();
+    ::new (static_cast<void *>(n->data())) T(std::forward<Args>(args)...);
+
+    while (!items.tryPush(n)) {
+        if (eliminatePush(n)) {
+            break;
+        }
+    }
+    return true;
+}
+
+// **Public** //
+// pop()
+//
+// Moves the top item into out. Returns false if the stack is empty.
+template<class T>
+bool ConcurrentStack<T>::pop(T &out) {
+    Node *n;
+
+    while (!items.tryPop(n)) {
+        if ((n = eliminatePop()) != nullptr) {
+            break;
+        }
+    }
+    if (n == nullptr) {
+        return false;
+    }
+    out = std::move(*n->data());
+    n->data()->~T();
+    spare.push(n);
+    return true;
+}
+
+// **Public** //
+// isEmpty()
+template<class T>
+bool ConcurrentStack<T>::isEmpty() const {
+    return items.isEmpty();
+}
+
+#endif /* ConcurrentStack.hpp */
@@ -0,0 +1,263 @@
+//
+//  EpochReclamation.hpp
+//  CustomLibraries
+//
+//  Description
+//
+//  Epoch based memory reclamation for the lock-free containers. A
+//  lock-free structure cannot delete a node the moment it unlinks it,
+//  because another thread may still be reading it. Instead the node is
+//  retired, and deleted once every thread has moved past the point
+//  where it could have seen it.
+//
+//  Threads wrap every operation on a shared structure in an EpochGuard:
+//
+//      {
+//          EpochGuard guard;
+//          ... read/unlink nodes, EpochDomain::global().retire(node) ...
+//      }
+//
+//  A guard announces the global epoch the thread saw. The global epoch
+//  only advances once every thread inside a guard has announced the
+//  current one, so anything retired two epochs ago can no longer be
+//  referenced by anyone and is deleted.
+//
+//  Guards nest and are cheap (a store and a fence). A thread that stays
+//  inside a guard indefinitely holds up reclamation for everyone.
+//
+
+#ifndef EpochReclamation_hpp
+#define EpochReclamation_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class EpochDomain {
+private:
+    struct Retired {
+        void *pointer;
+        void (*deleter)(void *);
+    };
+
+    // One record per thread that has ever entered the domain. Records
+    // are never freed while the domain lives, a thread that exits
+    // hands its record (and anything still retired in it) to the next
+    // thread that needs one.
+    struct alignas(64) ThreadRecord {
+        std::atomic<uint64_t> state;        // (epoch << 1) | active
+        std::atomic<bool>     inUse;
+        ThreadRecord         *next;
+        int                   nesting;
+        size_t                retiresSinceScan;
+        uint64_t              bucketEpoch[3];
+        std::vector<Retired>  bucket[3];    // Retired in epoch e go in bucket e % 3
+
+        ThreadRecord() : state{0}, inUse{true}, next{nullptr}, nesting{0}, retiresSinceScan{0} {
+            bucketEpoch[0] = bucketEpoch[1] = bucketEpoch[2] = 0;
+        }
+    };
+
+    // Releases the calling thread's record when the thread exits
+    struct RecordHolder {
+        ThreadRecord *record = nullptr;
+        ~RecordHolder() {
+            if (record) {
+                record->inUse.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    static constexpr size_t RETIRES_PER_SCAN = 64;
+
+    alignas(64) std::atomic<uint64_t>       globalEpoch;
+    alignas(64) std::atomic<ThreadRecord *> records;
+
+    EpochDomain() : globalEpoch{2}, records{nullptr} { }
+    ~EpochDomain();
+
+    ThreadRecord *localRecord();
+    ThreadRecord *acquireRecord();
+    void freeBucket(ThreadRecord *, int);
+    void reclaim(ThreadRecord *, uint64_t);
+    bool tryAdvance();
+
+public:
+    EpochDomain(const EpochDomain &) = delete;
+    EpochDomain &operator=(const EpochDomain &) = delete;
+
+    static EpochDomain &global();
+
+    void enter();
+    void exit();
+    void retire(void *, void (*)(void *));
+    void collect();
+
+    template <class T>
+    void retire(T *pointer) {
+        retire(static_cast<void *>(pointer), [](void *p) { delete static_cast<T *>(p); });
+    }
+};
+
+// Scoped critical section
+class EpochGuard {
+public:
+    EpochGuard() { EpochDomain::global().enter(); }
+    ~EpochGuard() { EpochDomain::global().exit(); }
+
+    EpochGuard(const EpochGuard &) = delete;
+    EpochGuard &operator=(const EpochGuard &) = delete;
+};
+
+// **Public** //
+// global()
+inline EpochDomain &EpochDomain::global() {
+    static EpochDomain domain;
+    return domain;
+}
+
+// Destructor
+//
+// Runs at process exit, when no other thread can be inside a guard.
+inline EpochDomain::~EpochDomain() {
+    ThreadRecord *record = records.load(std::memory_order_acquire);
+    while (record) {
+        ThreadRecord *next = record->next;
+        for (int i = 0; i < 3; ++i) {
+            freeBucket(record, i);
+        }
+        delete record;
+        record = next;
+    }
+}
+
+// **Private** //
+// localRecord()
+inline EpochDomain::ThreadRecord *EpochDomain::localRecord() {
+    static thread_local RecordHolder holder;
+    if (holder.record == nullptr) {
+        holder.record = acquireRecord();
+    }
+    return holder.record;
+}
+
+// **Private** //
+// acquireRecord()
+//
+// Reuses a record left by an exited thread, or adds a new one.
+inline EpochDomain::ThreadRecord *EpochDomain::acquireRecord() {
+    for (ThreadRecord *r = records.load(std::memory_order_acquire); r; r = r->next) {
+        bool expected = false;
+        if (!r->inUse.load(std::memory_order_relaxed) &&
+            r->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return r;
+        }
+    }
+
+    ThreadRecord *r = new ThreadRecord;
+    ThreadRecord *head = records.load(std::memory_order_relaxed);
+    do {
+        r->next = head;
+    } while (!records.compare_exchange_weak(head, r, std::memory_order_release,
+                                            std::memory_order_relaxed));
+    return r;
+}
+
+// **Private** //
+// freeBucket()
+inline void EpochDomain::freeBucket(ThreadRecord *record, int index) {
+    std::vector<Retired> &bucket = record->bucket[index];
+    for (const Retired &r : bucket) {
+        r.deleter(r.pointer);
+    }
+    bucket.clear();
+}
+
+// **Private** //
+// reclaim()
+//
+// With the global epoch at e, the bucket for e + 1 (== e - 2 mod 3)
+// only holds nodes retired two or more epochs ago, which are safe.
+inline void EpochDomain::reclaim(ThreadRecord *record, uint64_t epoch) {
+    int index = static_cast<int>((epoch + 1) % 3);
+    if (record->bucketEpoch[index] + 2 <= epoch) {
+        freeBucket(record, index);
+    }
+}
+
+// **Private** //
+// tryAdvance()
+//
+// Moves the global epoch forward if every active thread has seen it.
+inline bool EpochDomain::tryAdvance() {
+    uint64_t epoch = globalEpoch.load(std::memory_order_seq_cst);
+
+    for (ThreadRecord *r = records.load(std::memory_order_acquire); r; r = r->next) {
+        uint64_t state = r->state.load(std::memory_order_seq_cst);
+        if ((state & 1) && (state >> 1) != epoch) {
+            return false;
+        }
+    }
+    return globalEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst);
+}
+
+// **Public** //
+// enter()
+inline void EpochDomain::enter() {
+    ThreadRecord *record = localRecord();
+    if (record->nesting++ > 0) {
+        return;
+    }
+    uint64_t epoch = globalEpoch.load(std::memory_order_relaxed);
+    record->state.store((epoch << 1) | 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+// **Public** //
+// exit()
+inline void EpochDomain::exit() {
+    ThreadRecord *record = localRecord();
+    if (--record->nesting > 0) {
+        return;
+    }
+    record->state.store(record->state.load(std::memory_order_relaxed) & ~uint64_t(1),
+                        std::memory_order_release);
+}
+
+// **Public** //
+// retire()
+//
+// Hands pointer to the domain, which calls deleter(pointer) once no
+// thread can still be reading it. Call after pointer is unreachable.
+inline void EpochDomain::retire(void *pointer, void (*deleter)(void *)) {
+    ThreadRecord *record = localRecord();
+    uint64_t epoch = globalEpoch.load(std::memory_order_acquire);
+    int index = static_cast<int>(epoch % 3);
+
+    // The bucket still holds an older epoch; that epoch is at least
+    // three behind, so its contents are safe to free now.
+    if (record->bucketEpoch[index] != epoch) {
+        freeBucket(record, index);
+        record->bucketEpoch[index] = epoch;
+    }
+    record->bucket[index].push_back(Retired{pointer, deleter});
+
+    if (++record->retiresSinceScan >= RETIRES_PER_SCAN) {
+        record->retiresSinceScan = 0;
+        collect();
+    }
+}
+
+// **Public** //
+// collect()
+//
+// Tries to advance the epoch and frees what the calling thread has
+// retired that is now safe.
+inline void EpochDomain::collect() {
+    ThreadRecord *record = localRecord();
+    tryAdvance();
+    reclaim(record, globalEpoch.load(std::memory_order_acquire));
+}
+
+#endif /* EpochReclamation.hpp */
@@ -0,0 +1,375 @@
+//
+//  ExternalSort.hpp
+//  CustomLibraries
+//
+//  Description
+//
+//  Sorts a file of fixed-size binary records that is too big to fit in
+//  memory. Record is any trivially copyable type, stored in the file
+//  exactly as it is laid out in memory, one after another:
+//
+//      struct Entry { uint64_t timestamp; uint32_t host; uint32_t code; };
+//      externalSort<Entry>("extract.bin", "sorted.bin", size_t(48) << 30,
+//                          std::less<>(), &Entry::timestamp);
+//
+//  The sort is done in two phases:
+//
+//  1. The input is read in chunks of up to memoryBytes. Each chunk is
+//     sorted with quickSort and written out as a sorted run.
+//  2. The runs are merged with a loser tree, so each record output
+//     costs about log2(runs) comparisons. Each run is read through its
+//     own large block buffer, and output goes through one more. If
+//     there are more runs than the buffers that fit in memoryBytes,
+//     groups of runs are first merged into longer runs.
+//
+//  Input that fits in one chunk is sorted and written straight to the
+//  output. All file access is done in whole blocks with stdio
+//  buffering turned off, so the disk sees long sequential reads and
+//  writes. Records that compare equal keep the order of their runs.
+//  The sort within a chunk is not stable.
+//
+//  Run files are named after tempPrefix (the output path by default)
+//  and are removed when the sort finishes or fails. Errors are thrown
+//  as std::runtime_error.
+//
+
+#ifndef ExternalSort_hpp
+#define ExternalSort_hpp
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Sorting.hpp"
+
+// Size of the buffer behind each run while merging
+static const size_t EXTERNAL_SORT_BLOCK_BYTES = size_t(4) << 20;
+
+namespace sorting_detail {
+
+    //**BINARY FILE**//
+    //
+    // An unbuffered stdio file that reads and writes whole blocks and
+    // throws on failure.
+    class BinaryFile {
+    private:
+        std::FILE  *file;
+        std::string path;
+
+        [[noreturn]] void fail(const char *what) const {
+            throw std::runtime_error(std::string(what) + " " + path + ": " + std::strerror(errno));
+        }
+
+    public:
+        BinaryFile(const std::string &p, const char *mode) : file{std::fopen(p.c_str(), mode)}, path{p} {
+            if (file == nullptr) {
+                fail("cannot open");
+            }
+            std::setvbuf(file, nullptr, _IONBF, 0);
+        }
+        // Errors closing here are dropped, as this can run while
+        // unwinding; the success paths call close() themselves
+        ~BinaryFile() {
+            if (file != nullptr) {
+                std::fclose(file);
+            }
+        }
+        BinaryFile(BinaryFile &&other) noexcept : file{other.file}, path{std::move(other.path)} {
+            other.file = nullptr;
+        }
+        BinaryFile(const BinaryFile &) = delete;
+        BinaryFile &operator=(const BinaryFile &) = delete;
+
+        // Reads up to bytes, returning fewer only at the end of the file
+        size_t read(void *data, size_t bytes) {
+            size_t got = std::fread(data, 1, bytes, file);
+            if (got < bytes && std::ferror(file)) {
+                fail("cannot read");
+            }
+            return got;
+        }
+
+        void write(const void *data, size_t bytes) {
+            if (bytes != 0 && std::fwrite(data, 1, bytes, file) != bytes) {
+                fail("cannot write");
+            }
+        }
+
+        void close() {
+            if (file != nullptr) {
+                bool failed = std::fclose(file) != 0;
+                file = nullptr;
+                if (failed) {
+                    fail("cannot close");
+                }
+            }
+        }
+
+        const std::string &getPath() const { return path; }
+    };
+
+    // Reads up to count records, throwing on a partial record at the end
+    template <typename Record>
+    size_t readRecords(BinaryFile &file, Record *data, size_t count) {
+        size_t bytes = file.read(data, count * sizeof(Record));
+        if (bytes % sizeof(Record) != 0) {
+            throw std::runtime_error(file.getPath() + " does not hold a whole number of records");
+        }
+        return bytes / sizeof(Record);
+    }
+
+    //**RUN READER**//
+    //
+    // Walks a sorted run one record at a time, a block at a time.
+    template <typename Record>
+    class RunReader {
+    private:
+        BinaryFile          file;
+        std::vector<Record> block;
+        size_t              position, count;
+
+    public:
+        RunReader(const std::string &path, size_t blockRecords)
+            : file(path, "rb"), block(blockRecords), position{0}, count{0} {
+            advance();
+        }
+
+        bool isEmpty() const { return position == count; }
+        const Record &current() const { return block[position]; }
+
+        void advance() {
+            if (++position < count) {
+                return;
+            }
+            count    = readRecords(file, block.data(), block.size());
+            position = 0;
+        }
+    };
+
+    //**RUN WRITER**//
+    template <typename Record>
+    class RunWriter {
+    private:
+        BinaryFile          file;
+        std::vector<Record> block;
+        size_t              count;
+
+    public:
+        RunWriter(const std::string &path, size_t blockRecords)
+            : file(path, "wb"), block(blockRecords), count{0} { }
+
+        void push(const Record &record) {
+            block[count++] = record;
+            if (count == block.size()) {
+                file.write(block.data(), count * sizeof(Record));
+                count = 0;
+            }
+        }
+
+        void finish() {
+            file.write(block.data(), count * sizeof(Record));
+            count = 0;
+            file.close();
+        }
+    };
+
+    //**LOSER TREE**//
+    //
+    // Picks the smallest current record among k runs. The runs are the
+    // leaves of a complete binary tree (leaf i is node k + i); every
+    // inner node holds the run that lost the match played there and
+    // node 0 holds the overall winner. After the winner advances only
+    // the matches on its path to the root are replayed. Runs that have
+    // ended lose to everything, and ties go to the lower run number.
+    template <typename Record, typename Less>
+    class LoserTree {
+    private:
+        std::vector<RunReader<Record>> &runs;
+        Less                           &less;
+        std::vector<size_t>             tree;
+
+        bool beats(size_t a, size_t b) const {
+            if (runs[a].isEmpty() || runs[b].isEmpty()) {
+                return runs[b].isEmpty() && (!runs[a].isEmpty() || a < b);
+            }
+            if (less(runs[a].current(), runs[b].current())) {
+                return true;
+            }
+            return !less(runs[b].current(), runs[a].current()) && a < b;
+        }
+
+        size_t build(size_t node) {
+            size_t k = runs.size();
+            if (node >= k) {
+                return node - k;
+            }
+            size_t left = build(2 * node), right = build(2 * node + 1);
+            if (beats(left, right)) {
+                tree[node] = right;
+                return left;
+            }
+            tree[node] = left;
+            return right;
+        }
+
+    public:
+        LoserTree(std::vector<RunReader<Record>> &r, Less &l) : runs(r), less(l), tree(r.size()) {
+            tree[0] = build(1);
+        }
+
+        bool isEmpty() const { return runs[tree[0]].isEmpty(); }
+        const Record &top() const { return runs[tree[0]].current(); }
+
+        // Advances the winning run and finds the new winner
+        void pop() {
+            size_t winner = tree[0];
+            runs[winner].advance();
+            for (size_t node = (winner + runs.size()) / 2; node > 0; node /= 2) {
+                if (beats(tree[node], winner)) {
+                    std::swap(tree[node], winner);
+                }
+            }
+            tree[0] = winner;
+        }
+    };
+
+    //**MERGE RUN FILES**//
+    template <typename Record, typename Less>
+    void mergeRunFiles(const std::vector<std::string> &inputs, const std::string &output,
+                       size_t blockRecords, Less &less) {
+        std::vector<RunReader<Record>> runs;
+        runs.reserve(inputs.size());
+        for (const std::string &path : inputs) {
+            runs.emplace_back(path, blockRecords);
+        }
+        RunWriter<Record> writer(output, blockRecords);
+        LoserTree<Record, Less> tree(runs, less);
+        while (!tree.isEmpty()) {
+            writer.push(tree.top());
+            tree.pop();
+        }
+        writer.finish();
+    }
+
+    // Deletes the run files it names when it goes out of scope
+    struct TempFiles {
+        std::vector<std::string> paths;
+        std::string              prefix;
+        size_t                   created = 0;
+
+        std::string create() {
+            paths.push_back(prefix + ".run" + std::to_string(created++));
+            return paths.back();
+        }
+        // Deletes the first count files and drops them from paths
+        void remove(size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                if (!paths[i].empty()) {
+                    std::remove(paths[i].c_str());
+                }
+            }
+            paths.erase(paths.begin(), paths.begin() + count);
+        }
+        // Deletes paths[first, first + count) now, leaving their
+        // entries in place (emptied) so later indices do not move
+        void removeFiles(size_t first, size_t count) {
+            for (size_t i = first; i < first + count; ++i) {
+                std::remove(paths[i].c_str());
+                paths[i].clear();
+            }
+        }
+        ~TempFiles() { remove(paths.size()); }
+    };
+
+} // namespace sorting_detail
+
+//**EXTERNAL SORT**//
+/* *
+ *  Description: Sorts the records in the file inputPath into the file
+ *               outputPath, using about memoryBytes of memory. The two
+ *               paths may be the same. Record must be trivially
+ *               copyable, and the comparator and projection work as in
+ *               the in-memory sorts.
+ *
+ *               Run files go next to tempPrefix, or outputPath if it is
+ *               empty, and need as much free space as the input.
+ *
+ *               Sorting time: O(n log n) comparisons, reading and
+ *               writing the data twice (more if the runs do not fit
+ *               in one merge)
+ */
+template <typename Record, typename Compare = std::less<>, typename Projection = SortIdentity>
+void externalSort(const std::string &inputPath, const std::string &outputPath, size_t memoryBytes,
+                  Compare comp = Compare(), Projection proj = Projection(), const std::string &tempPrefix = "") {
+    static_assert(std::is_trivially_copyable<Record>::value, "externalSort needs trivially copyable records");
+    using namespace sorting_detail;
+    auto less = makeLess(comp, proj);
+
+    size_t blockBytes   = std::min(EXTERNAL_SORT_BLOCK_BYTES, memoryBytes / 4);
+    size_t blockRecords = std::max<size_t>(blockBytes / sizeof(Record), 1);
+    size_t chunkRecords = std::max<size_t>(memoryBytes / sizeof(Record), 2);
+    size_t maxFanIn     = std::max<size_t>(memoryBytes / (blockRecords * sizeof(Record)), 3) - 1;
+
+    TempFiles temp;
+    temp.prefix = tempPrefix.empty() ? outputPath : tempPrefix;
+
+    // 1. Sorted runs
+    {
+        std::vector<Record> chunk(chunkRecords);
+        BinaryFile input(inputPath, "rb");
+        for (;;) {
+            size_t count = readRecords(input, chunk.data(), chunkRecords);
+            if (count == 0 && temp.created != 0) {
+                break;
+            }
+            quickSort(chunk.begin(), chunk.begin() + count, comp, proj);
+
+            if (count < chunkRecords && temp.created == 0) {
+                input.close();
+                BinaryFile output(outputPath, "wb");
+                output.write(chunk.data(), count * sizeof(Record));
+                output.close();
+                return;
+            }
+            BinaryFile run(temp.create(), "wb");
+            run.write(chunk.data(), count * sizeof(Record));
+            run.close();
+            if (count < chunkRecords) {
+                break;
+            }
+        }
+    }
+
+    // 2. Merge passes, until one merge can take every run. A pass merges
+    //    consecutive groups of the current runs into new runs, in order,
+    //    so equal records keep the order of the runs they came from.
+    while (temp.paths.size() > maxFanIn) {
+        size_t runs = temp.paths.size();
+        for (size_t first = 0; first < runs; first += maxFanIn) {
+            size_t count = std::min(maxFanIn, runs - first);
+            std::string merged = temp.create();
+            if (count == 1) {
+                if (std::rename(temp.paths[first].c_str(), merged.c_str()) != 0) {
+                    throw std::runtime_error("externalSort: cannot rename " + temp.paths[first] + ": " +
+                                             std::strerror(errno));
+                }
+                temp.paths[first].clear();
+                continue;
+            }
+            std::vector<std::string> inputs(temp.paths.begin() + first, temp.paths.begin() + first + count);
+            mergeRunFiles<Record>(inputs, merged, blockRecords, less);
+            temp.removeFiles(first, count);
+        }
+        temp.remove(runs);
+    }
+    mergeRunFiles<Record>(temp.paths, outputPath, blockRecords, less);
+}
+
+#endif /* ExternalSort.hpp */
@@ -5,11 +5,14 @@
 #include <iostream>
 #include <vector>
 #include <list>
+#include <memory_resource>
 #include <stdexcept>
 #include <algorithm>
+#include <climits>
 
 // Custom project includes
-#include "hash.h"
+#include "hash.hpp"
+#include "../Serialization.hpp"
 
 
 // Separate chaining based hash table - derived from Hash
@@ -30,7 +33,8 @@ private:
 				) : item{std::move(i)} { }
 	};
 
-	std::vector<std::list<hashed_item>> list;
+	// The bucket array and every list node come from one memory resource
+	std::pmr::vector<std::pmr::list<hashed_item>> list;
 	int current_size;
 	float LOAD_FACTOR_MAX = 0.75;
 
@@ -61,24 +65,49 @@ private:
         return key % this->list.size(); 
     }
 
+	// Swaps in a fresh bucket array on the same memory resource (a
+	// copy of the old one would land on the default resource) and
+	// reinserts the entries.
 	void rehash() {
-		std::vector<std::list<hashed_item>> copy_list = this->list;
-		this->list.resize(next_prime(2*this->list.size()));
-		for (auto& l : this->list) {
-			l.clear();
-		}
+		std::pmr::vector<std::pmr::list<hashed_item>> old_list(
+				next_prime(2*this->list.size()), this->list.get_allocator());
+		this->list.swap(old_list);
 
 		this->current_size = 0;
-		for (auto& l : copy_list) {
+		for (auto& l : old_list) {
 			for (auto& entry : l) {
 				insert(std::move(entry.item));
 			}
 		}
 	}
 
+	// Replaces the table, bucket count included, with the one stored
+	// in reader, once all of it has been read and checked.
+	void load(BinaryReader& reader) {
+		std::vector<std::pair<K,V>> items;
+		SerializedHeader header = readSerialized<std::pair<K,V>>(reader, SerializedKind::CHAINING_HASH,
+				[&](std::pair<K,V>&& item) { items.push_back(std::move(item)); });
+		if (header.capacity == 0 || header.capacity > INT_MAX) {
+			throw std::runtime_error("deserialize: bucket count is invalid");
+		}
+
+		ChainingHash loaded(1, get_resource());
+		loaded.list.resize(header.capacity);
+		for (auto& item : items) {
+			if (!loaded.insert(item)) {
+				throw std::runtime_error("deserialize: duplicate key");
+			}
+		}
+		this->list.swap(loaded.list);
+		this->current_size = loaded.current_size;
+	}
+
 public:
-    explicit ChainingHash(int n = 11)
-		: list(next_prime(n)) { clear(); }
+	// Buckets and entries are allocated from resource, which must
+	// outlive the table
+    explicit ChainingHash(int n = 11,
+			std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		: list(next_prime(n), resource) { clear(); }
 
     ~ChainingHash() {
         this->clear();
@@ -145,6 +174,10 @@ public:
         return (float)this->current_size / this->list.size();
     }
 
+	std::pmr::memory_resource* get_resource() const {
+		return this->list.get_allocator().resource();
+	}
+
     V operator[](const K& key) const {
 		auto& l = this->list[hash(key)];
 		auto itr = std::find_if(std::begin(l), std::end(l),
@@ -156,6 +189,28 @@ public:
 		}
 		return itr->item.second;
     }
+
+	// Writes the (key, value) pairs bucket by bucket (see Serialization.hpp)
+	void serialize(std::ostream& output) const {
+		writeSerialized<std::pair<K,V>>(output, SerializedKind::CHAINING_HASH, this->current_size, 0,
+				this->list.size(), [&](auto&& writeItem) {
+					for (auto& l : this->list) {
+						for (auto& entry : l) {
+							writeItem(entry.item);
+						}
+					}
+				});
+	}
+
+	void deserialize(std::istream& input) {
+		BinaryReader reader(input);
+		load(reader);
+	}
+
+	void deserialize(const MappedFile& file) {
+		BinaryReader reader(file.data(), file.size());
+		load(reader);
+	}
 };
 
 #endif //__CHAINING_HASH_H
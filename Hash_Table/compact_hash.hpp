@@ -0,0 +1,474 @@
+#ifndef __COMPACT_HASH_H
+#define __COMPACT_HASH_H
+
+// Standard library includes
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Custom project includes
+#include "hash.hpp"
+
+//
+//  Linear probing tables for small, trivially copyable keys such as
+//  integers. Unlike ProbingHash they keep no state field per slot: two
+//  reserved key values (compact_key_traits) mark empty and deleted
+//  slots, so a slot is just the key. A set of 8-byte keys takes 8 bytes
+//  a slot instead of 24, and eight slots share a cache line.
+//
+//  ProbingHashSet<K>    --> a set of keys
+//  ProbingHashMap<K,V>  --> a map that keeps keys and values in two
+//                           separate arrays, so probing only ever
+//                           touches keys and a value is read once the
+//                           key has been found
+//
+//  The reserved keys can still be stored: they are held in flags next
+//  to the array rather than in it. The array size is a power of two,
+//  and keys are run through a mixing step after Hash so that sequential
+//  integer keys do not end up in one long run.
+//
+
+// The key values marking empty and deleted slots. Specialize for key
+// types that are not integers.
+template<typename K, typename = void>
+struct compact_key_traits;
+
+template<typename K>
+struct compact_key_traits<K, typename std::enable_if<std::is_integral<K>::value>::type> {
+	static constexpr K empty_key() { return std::numeric_limits<K>::max(); }
+	static constexpr K deleted_key() { return std::numeric_limits<K>::max() - 1; }
+};
+
+// Finalizer from MurmurHash3
+inline uint64_t compact_mix(uint64_t h) {
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+// Smallest power of two array (at least 16 slots) that holds n keys at
+// half load
+inline size_t compact_capacity_for(size_t n) {
+	size_t capacity = 16;
+	while (capacity / 2 < n) {
+		capacity <<= 1;
+	}
+	return capacity;
+}
+
+
+// Set of keys in a sentinel-keyed linear probing array
+template<typename K, typename HashFn = std::hash<K>, typename Traits = compact_key_traits<K>>
+class ProbingHashSet {
+	static_assert(std::is_trivially_copyable<K>::value, "ProbingHashSet needs trivially copyable keys");
+
+private:
+
+	// Private Vars
+	std::pmr::vector<K> keys;
+	size_t mask;
+	int current_size;		// Keys in the array, not counting the reserved ones
+	int deleted_count;
+	bool has_empty_key;
+	bool has_deleted_key;
+	HashFn hasher;
+	float LOAD_FACTOR_MAX = 0.75;
+
+	// Private Functions
+
+	static bool is_reserved(const K& k) {
+		return k == Traits::empty_key() || k == Traits::deleted_key();
+	}
+
+	size_t hash(const K& k) const {
+		return compact_mix(hasher(k)) & mask;
+	}
+
+	// Slot holding k, or the slot an insert of k should use (the first
+	// deleted slot on the way, if any). found says which.
+	size_t find_position(const K& k, bool& found) const {
+		size_t current_position = hash(k);
+		size_t reusable = SIZE_MAX;
+
+		for (;;) {
+			const K& slot = keys[current_position];
+			if (slot == k) {
+				found = true;
+				return current_position;
+			}
+			if (slot == Traits::empty_key()) {
+				found = false;
+				return (reusable != SIZE_MAX) ? reusable : current_position;
+			}
+			if (slot == Traits::deleted_key() && reusable == SIZE_MAX) {
+				reusable = current_position;
+			}
+			current_position = (current_position + 1) & mask;
+		}
+	}
+
+	// Moves the keys into a fresh array of capacity slots, dropping the
+	// deleted markers.
+	void rebuild(size_t capacity) {
+		std::pmr::vector<K> old_keys(capacity, Traits::empty_key(), keys.get_allocator());
+		keys.swap(old_keys);
+		mask = capacity - 1;
+		deleted_count = 0;
+
+		for (const K& k : old_keys) {
+			if (!is_reserved(k)) {
+				size_t current_position = hash(k);
+				while (!(keys[current_position] == Traits::empty_key())) {
+					current_position = (current_position + 1) & mask;
+				}
+				keys[current_position] = k;
+			}
+		}
+	}
+
+public:
+	// n is the number of keys to make room for up front. The array is
+	// allocated from resource, which must outlive the set.
+	explicit ProbingHashSet(int n = 8,
+			std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+			HashFn h = HashFn())
+		: keys(compact_capacity_for(n > 0 ? n : 0), Traits::empty_key(), resource),
+		  current_size{0}, deleted_count{0}, has_empty_key{false}, has_deleted_key{false},
+		  hasher(std::move(h)) {
+		mask = keys.size() - 1;
+	}
+
+	bool insert(const K& k) {
+		if (k == Traits::empty_key() || k == Traits::deleted_key()) {
+			bool& held = (k == Traits::empty_key()) ? has_empty_key : has_deleted_key;
+			if (held) {
+				return false;
+			}
+			held = true;
+			return true;
+		}
+
+		bool found;
+		size_t current_position = find_position(k, found);
+		if (found) {
+			return false;
+		}
+		if (keys[current_position] == Traits::deleted_key()) {
+			this->deleted_count -= 1;
+		}
+		keys[current_position] = k;
+		this->current_size += 1;
+
+		// Deleted slots lengthen probes as much as keys do, so they
+		// count towards the load; rebuilding sizes for the keys alone
+		if (this->current_size + this->deleted_count > LOAD_FACTOR_MAX * keys.size()) {
+			rebuild(compact_capacity_for(this->current_size));
+		}
+		return true;
+	}
+
+	bool contains(const K& k) const {
+		if (k == Traits::empty_key()) return has_empty_key;
+		if (k == Traits::deleted_key()) return has_deleted_key;
+		bool found;
+		find_position(k, found);
+		return found;
+	}
+
+	bool erase(const K& k) {
+		if (k == Traits::empty_key() || k == Traits::deleted_key()) {
+			bool& held = (k == Traits::empty_key()) ? has_empty_key : has_deleted_key;
+			bool was_held = held;
+			held = false;
+			return was_held;
+		}
+
+		bool found;
+		size_t current_position = find_position(k, found);
+		if (!found) {
+			return false;
+		}
+		keys[current_position] = Traits::deleted_key();
+		this->current_size -= 1;
+		this->deleted_count += 1;
+		return true;
+	}
+
+	void clear() {
+		std::fill(keys.begin(), keys.end(), Traits::empty_key());
+		this->current_size = 0;
+		this->deleted_count = 0;
+		has_empty_key = has_deleted_key = false;
+	}
+
+	// Makes room for n keys without further rebuilding
+	void reserve(int n) {
+		size_t capacity = compact_capacity_for(n > 0 ? n : 0);
+		if (capacity > keys.size()) {
+			rebuild(capacity);
+		}
+	}
+
+	// Calls f(key) for every key, in no particular order
+	template<typename F>
+	void for_each(F f) const {
+		if (has_empty_key) f(Traits::empty_key());
+		if (has_deleted_key) f(Traits::deleted_key());
+		for (const K& k : keys) {
+			if (!is_reserved(k)) {
+				f(k);
+			}
+		}
+	}
+
+	int size() const {
+		return this->current_size + has_empty_key + has_deleted_key;
+	}
+
+	int bucket_count() const {
+		return keys.size();
+	}
+
+	float load_factor() const {
+		return (float)this->current_size / keys.size();
+	}
+
+	std::pmr::memory_resource* get_resource() const {
+		return keys.get_allocator().resource();
+	}
+};
+
+
+// Map with keys and values in separate sentinel-keyed arrays - derived from Hash
+template<typename K, typename V, typename HashFn = std::hash<K>, typename Traits = compact_key_traits<K>>
+class ProbingHashMap : public Hash<K,V> {
+	static_assert(std::is_trivially_copyable<K>::value, "ProbingHashMap needs trivially copyable keys");
+
+private:
+
+	// Private Vars
+	std::pmr::vector<K> keys;
+	std::pmr::vector<V> values;		// values[i] belongs to keys[i]
+	size_t mask;
+	int current_size;		// Keys in the array, not counting the reserved ones
+	int deleted_count;
+	bool has_empty_key;
+	bool has_deleted_key;
+	V empty_key_value;
+	V deleted_key_value;
+	HashFn hasher;
+	float LOAD_FACTOR_MAX = 0.75;
+
+	// Private Functions
+
+	static bool is_reserved(const K& k) {
+		return k == Traits::empty_key() || k == Traits::deleted_key();
+	}
+
+	size_t hash(const K& k) const {
+		return compact_mix(hasher(k)) & mask;
+	}
+
+	// Slot holding k, or the slot an insert of k should use (the first
+	// deleted slot on the way, if any). found says which.
+	size_t find_position(const K& k, bool& found) const {
+		size_t current_position = hash(k);
+		size_t reusable = SIZE_MAX;
+
+		for (;;) {
+			const K& slot = keys[current_position];
+			if (slot == k) {
+				found = true;
+				return current_position;
+			}
+			if (slot == Traits::empty_key()) {
+				found = false;
+				return (reusable != SIZE_MAX) ? reusable : current_position;
+			}
+			if (slot == Traits::deleted_key() && reusable == SIZE_MAX) {
+				reusable = current_position;
+			}
+			current_position = (current_position + 1) & mask;
+		}
+	}
+
+	void rehash() {
+		rebuild(compact_capacity_for(this->current_size));
+	}
+
+	// Moves the entries into fresh arrays of capacity slots, dropping
+	// the deleted markers.
+	void rebuild(size_t capacity) {
+		std::pmr::vector<K> old_keys(capacity, Traits::empty_key(), keys.get_allocator());
+		std::pmr::vector<V> old_values(capacity, values.get_allocator());
+		keys.swap(old_keys);
+		values.swap(old_values);
+		mask = capacity - 1;
+		deleted_count = 0;
+
+		for (size_t i = 0; i < old_keys.size(); ++i) {
+			if (!is_reserved(old_keys[i])) {
+				size_t current_position = hash(old_keys[i]);
+				while (!(keys[current_position] == Traits::empty_key())) {
+					current_position = (current_position + 1) & mask;
+				}
+				keys[current_position] = old_keys[i];
+				values[current_position] = std::move(old_values[i]);
+			}
+		}
+	}
+
+	// The flag and value standing in for a slot of a reserved key
+	bool& reserved_flag(const K& k) {
+		return (k == Traits::empty_key()) ? has_empty_key : has_deleted_key;
+	}
+
+	V& reserved_value(const K& k) {
+		return (k == Traits::empty_key()) ? empty_key_value : deleted_key_value;
+	}
+
+public:
+	// n is the number of entries to make room for up front. The arrays
+	// are allocated from resource, which must outlive the map.
+	explicit ProbingHashMap(int n = 8,
+			std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+			HashFn h = HashFn())
+		: keys(compact_capacity_for(n > 0 ? n : 0), Traits::empty_key(), resource),
+		  values(keys.size(), resource),
+		  current_size{0}, deleted_count{0}, has_empty_key{false}, has_deleted_key{false},
+		  empty_key_value{}, deleted_key_value{}, hasher(std::move(h)) {
+		mask = keys.size() - 1;
+	}
+
+	bool insert(const std::pair<K,V>& pair) {
+		if (is_reserved(pair.first)) {
+			bool& held = reserved_flag(pair.first);
+			if (held) {
+				return false;
+			}
+			reserved_value(pair.first) = pair.second;
+			held = true;
+			return true;
+		}
+
+		bool found;
+		size_t current_position = find_position(pair.first, found);
+		if (found) {
+			return false;
+		}
+		if (keys[current_position] == Traits::deleted_key()) {
+			this->deleted_count -= 1;
+		}
+		keys[current_position] = pair.first;
+		values[current_position] = pair.second;
+		this->current_size += 1;
+
+		// Deleted slots lengthen probes as much as keys do, so they
+		// count towards the load
+		if (this->current_size + this->deleted_count > LOAD_FACTOR_MAX * keys.size()) {
+			rehash();
+		}
+		return true;
+	}
+
+	bool contains(const K& k) const {
+		if (k == Traits::empty_key()) return has_empty_key;
+		if (k == Traits::deleted_key()) return has_deleted_key;
+		bool found;
+		find_position(k, found);
+		return found;
+	}
+
+	bool erase(const K& k) {
+		if (is_reserved(k)) {
+			bool& held = reserved_flag(k);
+			bool was_held = held;
+			held = false;
+			reserved_value(k) = V{};
+			return was_held;
+		}
+
+		bool found;
+		size_t current_position = find_position(k, found);
+		if (!found) {
+			return false;
+		}
+		keys[current_position] = Traits::deleted_key();
+		values[current_position] = V{};
+		this->current_size -= 1;
+		this->deleted_count += 1;
+		return true;
+	}
+
+	void clear() {
+		std::fill(keys.begin(), keys.end(), Traits::empty_key());
+		std::fill(values.begin(), values.end(), V{});
+		this->current_size = 0;
+		this->deleted_count = 0;
+		has_empty_key = has_deleted_key = false;
+		empty_key_value = deleted_key_value = V{};
+	}
+
+	// Makes room for n entries without further rebuilding
+	void reserve(int n) {
+		size_t capacity = compact_capacity_for(n > 0 ? n : 0);
+		if (capacity > keys.size()) {
+			rebuild(capacity);
+		}
+	}
+
+	// Pointer to the value stored for k, or nullptr. Valid until the
+	// next insert.
+	const V* find(const K& k) const {
+		if (k == Traits::empty_key()) return has_empty_key ? &empty_key_value : nullptr;
+		if (k == Traits::deleted_key()) return has_deleted_key ? &deleted_key_value : nullptr;
+		bool found;
+		size_t current_position = find_position(k, found);
+		return found ? &values[current_position] : nullptr;
+	}
+
+	// Calls f(key, value) for every entry, in no particular order
+	template<typename F>
+	void for_each(F f) const {
+		if (has_empty_key) f(Traits::empty_key(), empty_key_value);
+		if (has_deleted_key) f(Traits::deleted_key(), deleted_key_value);
+		for (size_t i = 0; i < keys.size(); ++i) {
+			if (!is_reserved(keys[i])) {
+				f(keys[i], values[i]);
+			}
+		}
+	}
+
+	int size() const {
+		return this->current_size + has_empty_key + has_deleted_key;
+	}
+
+	int bucket_count() const {
+		return keys.size();
+	}
+
+	float load_factor() const {
+		return (float)this->current_size / keys.size();
+	}
+
+	// Returns V{} when k is not in the map, like ChainingHash
+	V operator[](const K& k) const {
+		const V* value = find(k);
+		return value ? *value : V{};
+	}
+
+	std::pmr::memory_resource* get_resource() const {
+		return keys.get_allocator().resource();
+	}
+};
+
+#endif //__COMPACT_HASH_H
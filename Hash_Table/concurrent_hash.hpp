@@ -0,0 +1,498 @@
+#ifndef __CONCURRENT_HASH_H
+#define __CONCURRENT_HASH_H
+
+// Standard library includes
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+
+// Custom project includes
+#include "hash.hpp"
+#include "../EpochReclamation.hpp"
+
+//
+//  ConcurrentChainingHash is the thread safe counterpart to ChainingHash:
+//  any number of threads can insert, erase and look up keys in one table
+//  at the same time, and the table grows while they do.
+//
+//  Each bucket is a single word holding the head of its chain, with the
+//  low bit doubling as a spinlock. Writers lock just the bucket they
+//  change. Readers never lock: a chain only ever changes by one atomic
+//  pointer store under the bucket lock (the bucket word on insert, the
+//  previous node's next on erase), so a reader walking it sees it either
+//  before or after. Unlinked nodes keep their own next and are handed to
+//  EpochDomain, so a reader can keep walking a node that was just erased.
+//
+//  Growing allocates a second, larger bucket array and every thread that
+//  comes in to write helps move buckets across, a stride at a time. A
+//  moved bucket is left holding MOVED, which sends both readers and
+//  writers on to the new array; the thread that moves the last bucket
+//  makes the new array current. Entries are copied across rather than
+//  relinked, so K and V must be copyable.
+//
+//  The entry count is split across cache line sized stripes so that
+//  inserts from different threads do not all hit one counter. size() adds
+//  them up and is only exact when no one is writing, and clear() is not
+//  atomic with respect to concurrent inserts.
+//
+
+// Chaining hash with per-bucket locks and lock-free lookups - derived from Hash
+template<typename K, typename V, typename HashFn = std::hash<K>>
+class ConcurrentChainingHash : public Hash<K,V> {
+private:
+
+	// Private Vars
+	struct hashed_node {
+		const std::pair<K,V> item;
+		std::atomic<hashed_node*> next;
+
+		hashed_node(const std::pair<K,V>& i, hashed_node* n = nullptr)
+			: item{i}, next{n} { }
+	};
+
+	// A bucket word is a chain head with LOCKED possibly set, or MOVED
+	static constexpr uintptr_t LOCKED = 1;
+	static constexpr uintptr_t MOVED = 2;
+
+	struct table {
+		size_t mask;
+		std::unique_ptr<std::atomic<uintptr_t>[]> buckets;
+		std::atomic<table*> next;				// Array being grown into, if any
+		std::atomic<size_t> transfer_index;		// Next bucket to hand out for moving
+		std::atomic<size_t> moved_count;
+		std::atomic<bool> abandoned;			// A mover threw, leaving buckets behind
+
+		explicit table(size_t n)
+			: mask{n - 1}, buckets{new std::atomic<uintptr_t>[n]}, next{nullptr},
+			  transfer_index{0}, moved_count{0}, abandoned{false} {
+			for (size_t i = 0; i < n; ++i) {
+				buckets[i].store(0, std::memory_order_relaxed);
+			}
+		}
+
+		size_t size() const { return mask + 1; }
+	};
+
+	struct alignas(64) counter_stripe {
+		std::atomic<long> count{0};
+	};
+
+	static constexpr int COUNTER_STRIPES = 32;
+	static constexpr long RESIZE_CHECK_INTERVAL = 16;	// Inserts per stripe between load checks
+	static constexpr size_t TRANSFER_STRIDE = 64;		// Buckets a helper moves at a time
+	static constexpr int SPINS_BEFORE_YIELD = 64;
+
+	alignas(64) std::atomic<table*> current;
+	counter_stripe counts[COUNTER_STRIPES];
+	HashFn hasher;
+	float LOAD_FACTOR_MAX = 0.75;
+
+	// Private Functions
+
+	static hashed_node* chain(uintptr_t word) {
+		return reinterpret_cast<hashed_node*>(word & ~LOCKED);
+	}
+
+	static uintptr_t word(hashed_node* n) {
+		return reinterpret_cast<uintptr_t>(n);
+	}
+
+	// Smallest power of two (at least 16) that holds n entries under
+	// LOAD_FACTOR_MAX
+	size_t bucket_count_for(size_t n) const {
+		size_t count = 16;
+		while (count * LOAD_FACTOR_MAX < n) {
+			count <<= 1;
+		}
+		return count;
+	}
+
+	// Finalizer from MurmurHash3, so that keys differing only in their
+	// high bits do not all share a bucket
+	size_t hash(const K& key) const {
+		uint64_t h = hasher(key);
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+	counter_stripe& local_stripe() {
+		static std::atomic<unsigned> next_stripe{0};
+		static thread_local unsigned stripe = next_stripe.fetch_add(1, std::memory_order_relaxed);
+		return counts[stripe % COUNTER_STRIPES];
+	}
+
+	// Locks the bucket and returns its chain head, or returns MOVED
+	// (leaving the bucket alone) if it has been moved to the next array
+	static uintptr_t lock_bucket(std::atomic<uintptr_t>& bucket) {
+		int spins = 0;
+		for (;;) {
+			// Acquire, so that a MOVED seen here makes the copied
+			// entries in the next array visible
+			uintptr_t w = bucket.load(std::memory_order_acquire);
+			if (w == MOVED) {
+				return MOVED;
+			}
+			if (!(w & LOCKED) &&
+					bucket.compare_exchange_weak(w, w | LOCKED,
+						std::memory_order_acquire, std::memory_order_relaxed)) {
+				return w;
+			}
+			if (++spins == SPINS_BEFORE_YIELD) {
+				spins = 0;
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	// Publishes head as the bucket's chain and releases the lock
+	static void unlock_bucket(std::atomic<uintptr_t>& bucket, hashed_node* head) {
+		bucket.store(word(head), std::memory_order_release);
+	}
+
+	// Locks the bucket for hash h, following MOVED buckets through
+	// to the array that now holds it. Helps any move in progress on the
+	// way. The caller must hold an EpochGuard.
+	std::atomic<uintptr_t>& lock_bucket_for(size_t h, hashed_node*& head) {
+		table* t = current.load(std::memory_order_acquire);
+		if (t->next.load(std::memory_order_acquire)) {
+			help_transfer(t);
+		}
+		for (;;) {
+			std::atomic<uintptr_t>& bucket = t->buckets[h & t->mask];
+			uintptr_t w = lock_bucket(bucket);
+			if (w != MOVED) {
+				head = chain(w);
+				return bucket;
+			}
+			t = t->next.load(std::memory_order_acquire);
+		}
+	}
+
+	// Chain head for h, without locking. The caller must hold an EpochGuard.
+	hashed_node* find_chain(size_t h) const {
+		table* t = current.load(std::memory_order_acquire);
+		for (;;) {
+			uintptr_t w = t->buckets[h & t->mask].load(std::memory_order_acquire);
+			if (w != MOVED) {
+				return chain(w);
+			}
+			t = t->next.load(std::memory_order_acquire);
+		}
+	}
+
+	static hashed_node* find_in_chain(hashed_node* n, const K& key) {
+		while (n && !(n->item.first == key)) {
+			n = n->next.load(std::memory_order_acquire);
+		}
+		return n;
+	}
+
+	// Starts growing t if it is current, not already growing and over
+	// the load factor
+	void check_load(table* t) {
+		if (t != current.load(std::memory_order_acquire) ||
+				t->next.load(std::memory_order_acquire) ||
+				size() <= LOAD_FACTOR_MAX * t->size()) {
+			return;
+		}
+		start_transfer(t, bucket_count_for(size()));
+	}
+
+	void start_transfer(table* t, size_t n) {
+		table* next = new table(n > 2 * t->size() ? n : 2 * t->size());
+		table* expected = nullptr;
+		if (!t->next.compare_exchange_strong(expected, next, std::memory_order_acq_rel)) {
+			delete next;
+		}
+		help_transfer(t);
+	}
+
+	// Moves strides of t's buckets into t->next until none are left to
+	// hand out. The caller must hold an EpochGuard.
+	void help_transfer(table* t) {
+		table* next = t->next.load(std::memory_order_acquire);
+		for (;;) {
+			size_t begin = t->transfer_index.fetch_add(TRANSFER_STRIDE, std::memory_order_relaxed);
+			if (begin >= t->size()) {
+				if (t->abandoned.load(std::memory_order_acquire)) {
+					transfer_range(t, next, 0, t->size());
+				}
+				return;
+			}
+			size_t end = (begin + TRANSFER_STRIDE < t->size()) ? begin + TRANSFER_STRIDE : t->size();
+			transfer_range(t, next, begin, end);
+		}
+	}
+
+	// Moves buckets [begin, end) of t that are not moved yet. If a copy
+	// throws, the rest are left for the next helper to pick up.
+	void transfer_range(table* t, table* next, size_t begin, size_t end) {
+		size_t moved = 0;
+		try {
+			for (size_t i = begin; i < end; ++i) {
+				moved += transfer_bucket(t, next, i);
+			}
+		}
+		catch (...) {
+			t->abandoned.store(true, std::memory_order_release);
+			count_moved(t, next, moved);
+			throw;
+		}
+		count_moved(t, next, moved);
+	}
+
+	// The thread that moves the last bucket makes the new array current
+	void count_moved(table* t, table* next, size_t moved) {
+		if (moved && t->moved_count.fetch_add(moved, std::memory_order_acq_rel) + moved == t->size()) {
+			current.store(next, std::memory_order_release);
+			EpochDomain::global().retire(t);
+		}
+	}
+
+	// Copies bucket i of t into next and leaves MOVED behind. Returns
+	// false if it had already been moved. Every bucket of next that
+	// bucket i maps to is only reachable through it, so nothing else
+	// touches those until MOVED is published. If a copy throws they are
+	// emptied again and bucket i is unlocked as it was.
+	bool transfer_bucket(table* t, table* next, size_t i) {
+		std::atomic<uintptr_t>& bucket = t->buckets[i];
+		uintptr_t w = lock_bucket(bucket);
+		if (w == MOVED) {
+			return false;
+		}
+		hashed_node* head = chain(w);
+
+		try {
+			for (hashed_node* n = head; n; n = n->next.load(std::memory_order_relaxed)) {
+				std::atomic<uintptr_t>& target = next->buckets[hash(n->item.first) & next->mask];
+				hashed_node* copy = new hashed_node(n->item, chain(target.load(std::memory_order_relaxed)));
+				target.store(word(copy), std::memory_order_relaxed);
+			}
+		}
+		catch (...) {
+			for (size_t j = i; j < next->size(); j += t->size()) {
+				delete_chain(chain(next->buckets[j].load(std::memory_order_relaxed)));
+				next->buckets[j].store(0, std::memory_order_relaxed);
+			}
+			unlock_bucket(bucket, head);
+			throw;
+		}
+		bucket.store(MOVED, std::memory_order_release);
+
+		while (head) {
+			hashed_node* n = head;
+			head = head->next.load(std::memory_order_relaxed);
+			EpochDomain::global().retire(n);
+		}
+		return true;
+	}
+
+	// Deletes a chain no reader can reach
+	static void delete_chain(hashed_node* n) {
+		while (n) {
+			hashed_node* next = n->next.load(std::memory_order_relaxed);
+			delete n;
+			n = next;
+		}
+	}
+
+	// Empties bucket i of t, or the buckets it was moved to. Returns the
+	// number of entries removed. The caller must hold an EpochGuard.
+	long clear_bucket(table* t, size_t i) {
+		std::atomic<uintptr_t>& bucket = t->buckets[i];
+		uintptr_t w = lock_bucket(bucket);
+		if (w == MOVED) {
+			table* next = t->next.load(std::memory_order_acquire);
+			long removed = 0;
+			for (size_t j = i; j < next->size(); j += t->size()) {
+				removed += clear_bucket(next, j);
+			}
+			return removed;
+		}
+
+		unlock_bucket(bucket, nullptr);
+		long removed = 0;
+		for (hashed_node* n = chain(w); n; ++removed) {
+			hashed_node* next = n->next.load(std::memory_order_relaxed);
+			EpochDomain::global().retire(n);
+			n = next;
+		}
+		return removed;
+	}
+
+	// Calls f on each entry of bucket i of t, or of the buckets it was
+	// moved to. The caller must hold an EpochGuard.
+	template<typename F>
+	void visit_bucket(table* t, size_t i, F& f) const {
+		uintptr_t w = t->buckets[i].load(std::memory_order_acquire);
+		if (w == MOVED) {
+			table* next = t->next.load(std::memory_order_acquire);
+			for (size_t j = i; j < next->size(); j += t->size()) {
+				visit_bucket(next, j, f);
+			}
+			return;
+		}
+		for (hashed_node* n = chain(w); n; n = n->next.load(std::memory_order_acquire)) {
+			f(n->item.first, n->item.second);
+		}
+	}
+
+	void rehash() {
+		EpochGuard guard;
+		table* t = current.load(std::memory_order_acquire);
+		start_transfer(t, 2 * t->size());
+	}
+
+public:
+	// n is the number of entries to make room for up front
+	explicit ConcurrentChainingHash(int n = 11, HashFn h = HashFn())
+		: current{nullptr}, hasher(std::move(h)) {
+		current.store(new table(bucket_count_for(n > 0 ? n : 0)), std::memory_order_release);
+	}
+
+	ConcurrentChainingHash(const ConcurrentChainingHash&) = delete;
+	ConcurrentChainingHash& operator=(const ConcurrentChainingHash&) = delete;
+
+	// No other thread may be using the table any more. A move cut short
+	// by a throwing copy can still be half done: entries are then in the
+	// current array's unmoved buckets or in the next array, never both.
+	~ConcurrentChainingHash() {
+		table* t = current.load(std::memory_order_acquire);
+		for (size_t i = 0; i < t->size(); ++i) {
+			uintptr_t w = t->buckets[i].load(std::memory_order_relaxed);
+			if (w != MOVED) {
+				delete_chain(chain(w));
+			}
+		}
+		if (table* next = t->next.load(std::memory_order_relaxed)) {
+			for (size_t i = 0; i < next->size(); ++i) {
+				delete_chain(chain(next->buckets[i].load(std::memory_order_relaxed)));
+			}
+			delete next;
+		}
+		delete t;
+	}
+
+	// Returns false if key is already present, leaving its value as is
+	bool insert(const std::pair<K,V>& pair) {
+		EpochGuard guard;
+		size_t h = hash(pair.first);
+		// Owned until linked, since helping a move along can throw
+		std::unique_ptr<hashed_node> n(new hashed_node(pair));
+
+		hashed_node* head;
+		std::atomic<uintptr_t>& bucket = lock_bucket_for(h, head);
+		if (find_in_chain(head, pair.first)) {
+			unlock_bucket(bucket, head);
+			return false;
+		}
+		n->next.store(head, std::memory_order_relaxed);
+		unlock_bucket(bucket, n.release());
+
+		long count = local_stripe().count.fetch_add(1, std::memory_order_relaxed) + 1;
+		if (count % RESIZE_CHECK_INTERVAL == 0) {
+			check_load(current.load(std::memory_order_acquire));
+		}
+		return true;
+	}
+
+	bool erase(const K& key) {
+		EpochGuard guard;
+		hashed_node* head;
+		std::atomic<uintptr_t>& bucket = lock_bucket_for(hash(key), head);
+
+		hashed_node* prev = nullptr;
+		hashed_node* n = head;
+		while (n && !(n->item.first == key)) {
+			prev = n;
+			n = n->next.load(std::memory_order_relaxed);
+		}
+		if (n == nullptr) {
+			unlock_bucket(bucket, head);
+			return false;
+		}
+
+		hashed_node* next = n->next.load(std::memory_order_relaxed);
+		if (prev) {
+			prev->next.store(next, std::memory_order_release);
+			unlock_bucket(bucket, head);
+		}
+		else {
+			unlock_bucket(bucket, next);
+		}
+		EpochDomain::global().retire(n);
+		local_stripe().count.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	bool contains(const K& key) const {
+		EpochGuard guard;
+		return find_in_chain(find_chain(hash(key)), key) != nullptr;
+	}
+
+	// Copies the value for key into value. Returns false if key is absent.
+	bool find(const K& key, V& value) const {
+		EpochGuard guard;
+		hashed_node* n = find_in_chain(find_chain(hash(key)), key);
+		if (n == nullptr) {
+			return false;
+		}
+		value = n->item.second;
+		return true;
+	}
+
+	// Removes every entry present when each bucket is reached
+	void clear() {
+		EpochGuard guard;
+		table* t = current.load(std::memory_order_acquire);
+		long removed = 0;
+		for (size_t i = 0; i < t->size(); ++i) {
+			removed += clear_bucket(t, i);
+		}
+		local_stripe().count.fetch_sub(removed, std::memory_order_relaxed);
+	}
+
+	// Calls f(key, value) on every entry. Entries inserted or erased
+	// during the walk may or may not be seen.
+	template<typename F>
+	void for_each(F f) const {
+		EpochGuard guard;
+		table* t = current.load(std::memory_order_acquire);
+		for (size_t i = 0; i < t->size(); ++i) {
+			visit_bucket(t, i, f);
+		}
+	}
+
+	int size() const {
+		long total = 0;
+		for (const counter_stripe& stripe : counts) {
+			total += stripe.count.load(std::memory_order_relaxed);
+		}
+		return total > 0 ? total : 0;
+	}
+
+	int bucket_count() const {
+		EpochGuard guard;
+		return current.load(std::memory_order_acquire)->size();
+	}
+
+	float load_factor() const {
+		return (float)size() / bucket_count();
+	}
+
+	V operator[](const K& key) const {
+		V value{};
+		find(key, value);
+		return value;
+	}
+};
+
+#endif //__CONCURRENT_HASH_H
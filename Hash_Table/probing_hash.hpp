@@ -2,9 +2,12 @@
 #define __PROBING_HASH_H
 
 #include <vector>
+#include <memory_resource>
 #include <stdexcept>
+#include <climits>
 
 #include "hash.hpp"
+#include "../Serialization.hpp"
 
 enum EntryState {EMPTY=0,ACTIVE=1,DELETED=2};
 
@@ -30,8 +33,9 @@ private:
 
 	};
 
-	std::vector<hashed_item> array;
+	std::pmr::vector<hashed_item> array;
 	int current_size;
+	int deleted_count;
 	float LOAD_FACTOR_MAX = 0.75;
 
 	// Private Functions
@@ -49,7 +53,7 @@ private:
 			current_position += offset;
 			// Uncomment for quadratic probing
 			// offset += 2;
-			if ((int)array.size() > current_position) {
+			if (current_position >= (int)array.size()) {
 				current_position -= array.size();
 			}
 		}
@@ -57,14 +61,18 @@ private:
 	}
 
 	void rehash() {
-		std::vector<hashed_item> old_array = array;
+		rebuild(next_prime(2*array.size()));
+	}
 
-		array.resize(next_prime(2*old_array.size()));
-		for (auto& entry : array) {
-			entry.state = EMPTY;
-		}
+	// Swaps in a fresh, empty array of n slots on the same memory
+	// resource and reinserts the active entries, dropping the DELETED
+	// markers along the way.
+	void rebuild(int n) {
+		std::pmr::vector<hashed_item> old_array(n, array.get_allocator());
+		array.swap(old_array);
 
-		this->current_size = 0; 
+		this->current_size = 0;
+		this->deleted_count = 0;
 		for (auto& entry : old_array) {
 			if (entry.state == ACTIVE) {
 				insert(std::move(entry.item));
@@ -94,10 +102,35 @@ private:
 		return true;
     }
 
+	// Replaces the table, size included, with the one stored in
+	// reader, once all of it has been read and checked.
+	void load(BinaryReader& reader) {
+		std::vector<std::pair<K,V>> items;
+		SerializedHeader header = readSerialized<std::pair<K,V>>(reader, SerializedKind::PROBING_HASH,
+				[&](std::pair<K,V>&& item) { items.push_back(std::move(item)); });
+		if (header.capacity == 0 || header.capacity > INT_MAX) {
+			throw std::runtime_error("deserialize: table size is invalid");
+		}
+
+		ProbingHash loaded(1, get_resource());
+		loaded.array.resize(header.capacity);
+		loaded.clear();
+		for (auto& item : items) {
+			if (!loaded.insert(item)) {
+				throw std::runtime_error("deserialize: duplicate key");
+			}
+		}
+		this->array.swap(loaded.array);
+		this->current_size = loaded.current_size;
+		this->deleted_count = loaded.deleted_count;
+	}
+
 public:
 
-    explicit ProbingHash(int n = 11)
-		: array(next_prime(n)) { clear(); }
+	// The array is allocated from resource, which must outlive the table
+    explicit ProbingHash(int n = 11,
+			std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		: array(next_prime(n), resource) { clear(); }
 
     ~ProbingHash() {
 	   clear();
@@ -113,6 +146,9 @@ public:
 		if (is_active(current_position)) {
 			return false;
 		}
+		if (array[current_position].state == DELETED) {
+			this->deleted_count -= 1;
+		}
 		array[current_position].item = p;
 		array[current_position].state = ACTIVE;
 
@@ -120,6 +156,11 @@ public:
 		if (load_factor() > LOAD_FACTOR_MAX) {
 			rehash();
 		}
+		// DELETED slots end probes no more than active ones do; once
+		// they would leave no EMPTY slot behind, clear them out
+		else if ((float)(this->current_size + this->deleted_count) / array.size() > LOAD_FACTOR_MAX) {
+			rebuild(array.size());
+		}
         return true;
     }
 
@@ -129,12 +170,14 @@ public:
 			return false;
 		}
 		this->current_size -= 1;
+		this->deleted_count += 1;
 		array[current_position].state = DELETED;
 		return true;
     }
 
 	void clear() {
 		this->current_size = 0;
+		this->deleted_count = 0;
 		for(auto& entry : array) {
 			entry.state = EMPTY;
 		}
@@ -152,9 +195,35 @@ public:
         return (float)this->current_size / array.size();
     }
 
+	std::pmr::memory_resource* get_resource() const {
+		return array.get_allocator().resource();
+	}
+
     V operator[](const K& key) const {
         return array[find_position(key)].item.second;
     }
+
+	// Writes the (key, value) pairs in table order (see Serialization.hpp)
+	void serialize(std::ostream& output) const {
+		writeSerialized<std::pair<K,V>>(output, SerializedKind::PROBING_HASH, this->current_size, 0,
+				array.size(), [&](auto&& writeItem) {
+					for (auto& entry : array) {
+						if (entry.state == ACTIVE) {
+							writeItem(entry.item);
+						}
+					}
+				});
+	}
+
+	void deserialize(std::istream& input) {
+		BinaryReader reader(input);
+		load(reader);
+	}
+
+	void deserialize(const MappedFile& file) {
+		BinaryReader reader(file.data(), file.size());
+		load(reader);
+	}
 };
 
 #endif //__PROBING_HASH_H
@@ -0,0 +1,316 @@
+//
+//  IntrusiveList.hpp
+//  CustomLibraries
+//
+//  Description
+//
+//  A doubly linked list whose links live inside the elements
+//  themselves. An element type opts in by deriving from
+//  IntrusiveListHook, after which it can be linked into and unlinked
+//  from an IntrusiveList in O(1) without the list ever allocating.
+//  The list does not own its elements: it never copies, moves or
+//  deletes them, and the caller must unlink an element before
+//  destroying it.
+//
+//  An element can be in several lists at once by deriving from one
+//  hook per list, told apart by a tag type:
+//
+//      struct Job : IntrusiveListHook<ReadyTag>, IntrusiveListHook<AllTag> { ... };
+//      IntrusiveList<Job, ReadyTag> ready;
+//      IntrusiveList<Job, AllTag>   all;
+//
+
+#ifndef IntrusiveList_hpp
+#define IntrusiveList_hpp
+
+#include <cstddef>
+#include <iterator>
+
+template <class Tag = void>
+struct IntrusiveListHook {
+    IntrusiveListHook *next;
+    IntrusiveListHook *prev;
+
+    IntrusiveListHook() : next{nullptr}, prev{nullptr} {}
+
+    // Copying an element does not copy its links
+    IntrusiveListHook(const IntrusiveListHook &) : next{nullptr}, prev{nullptr} {}
+    IntrusiveListHook &operator=(const IntrusiveListHook &) { return *this; }
+
+    bool isLinked() const { return next != nullptr; }
+};
+
+template <class T, class Tag = void>
+class IntrusiveList {
+private:
+    typedef IntrusiveListHook<Tag> Hook;
+
+    Hook   head;        // Sentinel, the list is circular through it
+    size_t numItems;
+
+    static Hook *hookOf(T &item) { return static_cast<Hook *>(&item); }
+    static T    *ownerOf(Hook *h) { return static_cast<T *>(h); }
+
+    void linkBefore(Hook *, Hook *);
+    void unlink(Hook *);
+    void takeFrom(IntrusiveList &);
+
+    template <class V>
+    class basic_iterator {
+    private:
+        friend class IntrusiveList;
+        Hook *node;
+        explicit basic_iterator(Hook *n) : node{n} {}
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T              value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef V *            pointer;
+        typedef V &            reference;
+
+        basic_iterator() : node{nullptr} {}
+
+        reference operator*() const { return *ownerOf(node); }
+        pointer operator->() const { return ownerOf(node); }
+
+        basic_iterator &operator++() { node = node->next; return *this; }
+        basic_iterator &operator--() { node = node->prev; return *this; }
+        basic_iterator operator++(int) { basic_iterator t = *this; node = node->next; return t; }
+        basic_iterator operator--(int) { basic_iterator t = *this; node = node->prev; return t; }
+
+        bool operator==(const basic_iterator &other) const { return node == other.node; }
+        bool operator!=(const basic_iterator &other) const { return node != other.node; }
+    };
+
+public:
+    typedef basic_iterator<T>       iterator;
+    typedef basic_iterator<const T> const_iterator;
+
+    // Constructor
+    IntrusiveList();
+    IntrusiveList(const IntrusiveList &) = delete;
+    IntrusiveList(IntrusiveList &&) noexcept;
+
+    // Destructor
+    ~IntrusiveList();
+
+    // Operators
+    IntrusiveList &operator=(const IntrusiveList &) = delete;
+    IntrusiveList &operator=(IntrusiveList &&) noexcept;
+
+    // Iterators
+    iterator       begin()       { return iterator(head.next); }
+    iterator       end()         { return iterator(&head); }
+    const_iterator begin() const { return const_iterator(head.next); }
+    const_iterator end()   const { return const_iterator(const_cast<Hook *>(&head)); }
+    iterator       iteratorTo(T &item) { return iterator(hookOf(item)); }
+
+    // Functions
+    bool   isEmpty() const;
+    size_t getSize() const;
+    T     &getFront();
+    T     &getRear();
+
+    void insertFront(T &);
+    void insertRear(T &);
+    void insertBefore(T &, T &);
+    void remove(T &);
+    T   *removeFront();
+    T   *removeRear();
+    void moveToFront(T &);
+    void moveToRear(T &);
+    void clear();
+};
+
+// **Constructor** //
+template <class T, class Tag>
+IntrusiveList<T, Tag>::IntrusiveList() : numItems{0} {
+    head.next = head.prev = &head;
+}
+
+template <class T, class Tag>
+IntrusiveList<T, Tag>::IntrusiveList(IntrusiveList &&other) noexcept : IntrusiveList() {
+    takeFrom(other);
+}
+
+// **Destructor** //
+//
+// Unlinks every element so none is left pointing at the sentinel.
+template <class T, class Tag>
+IntrusiveList<T, Tag>::~IntrusiveList() {
+    clear();
+}
+
+// **Operator** //
+template <class T, class Tag>
+IntrusiveList<T, Tag> &IntrusiveList<T, Tag>::operator=(IntrusiveList &&other) noexcept {
+    if (this != &other) {
+        clear();
+        takeFrom(other);
+    }
+    return *this;
+}
+
+// **Private** //
+// linkBefore()
+template <class T, class Tag>
+void IntrusiveList<T, Tag>::linkBefore(Hook *pos, Hook *h) {
+    h->next = pos;
+    h->prev = pos->prev;
+    pos->prev->next = h;
+    pos->prev = h;
+    ++numItems;
+}
+
+// **Private** //
+// unlink()
+template <class T, class Tag>
+void IntrusiveList<T, Tag>::unlink(Hook *h) {
+    h->prev->next = h->next;
+    h->next->prev = h->prev;
+    h->next = h->prev = nullptr;
+    --numItems;
+}
+
+// **Private** //
+// takeFrom()
+//
+// Moves the chain of an other list (this one is empty) onto our sentinel.
+template <class T, class Tag>
+void IntrusiveList<T, Tag>::takeFrom(IntrusiveList &other) {
+    if (other.isEmpty()) {
+        return;
+    }
+    head.next = other.head.next;
+    head.prev = other.head.prev;
+    head.next->prev = &head;
+    head.prev->next = &head;
+    numItems = other.numItems;
+
+    other.head.next = other.head.prev = &other.head;
+    other.numItems = 0;
+}
+
+// **Public** //
+// isEmpty()
+template <class T, class Tag>
+bool IntrusiveList<T, Tag>::isEmpty() const {
+    return head.next == &head;
+}
+
+// **Public** //
+// getSize()
+template <class T, class Tag>
+size_t IntrusiveList<T, Tag>::getSize() const {
+    return numItems;
+}
+
+// **Public** //
+// getFront()
+template <class T, class Tag>
+T &IntrusiveList<T, Tag>::getFront() {
+    return *ownerOf(head.next);
+}
+
+// **Public** //
+// getRear()
+template <class T, class Tag>
+T &IntrusiveList<T, Tag>::getRear() {
+    return *ownerOf(head.prev);
+}
+
+// **Public** //
+// insertFront()
+template <class T, class Tag>
+void IntrusiveList<T, Tag>::insertFront(T &item) {
+    linkBefore(head.next, hookOf(item));
+}
+
+// **Public** //
+// insertRear()
+template <class T, class Tag>
+void IntrusiveList<T, Tag>::insertRear(T &item) {
+    linkBefore(&head, hookOf(item));
+}
+
+// **Public** //
+// insertBefore()
+//
+// Links item in front of pos, which must already be in this list.
+template <class T, class Tag>
+void IntrusiveList<T, Tag>::insertBefore(T &pos, T &item) {
+    linkBefore(hookOf(pos), hookOf(item));
+}
+
+// **Public** //
+// remove()
+//
+// Unlinks item, which must be in this list.
+template <class T, class Tag>
+void IntrusiveList<T, Tag>::remove(T &item) {
+    unlink(hookOf(item));
+}
+
+// **Public** //
+// removeFront()
+//
+// Unlinks and returns the front element, or nullptr if empty.
+template <class T, class Tag>
+T *IntrusiveList<T, Tag>::removeFront() {
+    if (isEmpty()) {
+        return nullptr;
+    }
+    Hook *h = head.next;
+    unlink(h);
+    return ownerOf(h);
+}
+
+// **Public** //
+// removeRear()
+//
+// Unlinks and returns the rear element, or nullptr if empty.
+template <class T, class Tag>
+T *IntrusiveList<T, Tag>::removeRear() {
+    if (isEmpty()) {
+        return nullptr;
+    }
+    Hook *h = head.prev;
+    unlink(h);
+    return ownerOf(h);
+}
+
+// **Public** //
+// moveToFront()
+template <class T, class Tag>
+void IntrusiveList<T, Tag>::moveToFront(T &item) {
+    Hook *h = hookOf(item);
+    if (head.next != h) {
+        unlink(h);
+        linkBefore(head.next, h);
+    }
+}
+
+// **Public** //
+// moveToRear()
+template <class T, class Tag>
+void IntrusiveList<T, Tag>::moveToRear(T &item) {
+    Hook *h = hookOf(item);
+    if (head.prev != h) {
+        unlink(h);
+        linkBefore(&head, h);
+    }
+}
+
+// **Public** //
+// clear()
+//
+// Unlinks every element. The elements themselves are untouched.
+template <class T, class Tag>
+void IntrusiveList<T, Tag>::clear() {
+    while (!isEmpty()) {
+        unlink(head.next);
+    }
+}
+
+#endif /* IntrusiveList.hpp */
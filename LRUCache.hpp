@@ -0,0 +1,452 @@
+//
+//  LRUCache.hpp
+//  CustomLibraries
+//
+//  Description
+//
+//  A least-recently-used cache with O(1) get, put and eviction.
+//
+//  Every entry is a single allocation that carries both of its links:
+//  an IntrusiveListHook for the recency list and the next pointer of
+//  its hash chain. The index is the separate chaining scheme of
+//  ChainingHash, except the chains run through the entries instead of
+//  through std::list nodes, so a put allocates at most once. Evicted
+//  and erased entries are kept for reuse, so a full cache allocates
+//  nothing at all.
+//
+//  The capacity is measured by a Weigher, called as weigher(key, value)
+//  when an entry is stored. The default counts every entry as 1 (a
+//  capacity in entries); pass one that returns a byte size to get a
+//  capacity in bytes.
+//
+//  LRUCache is not thread safe. ShardedLRUCache splits the capacity
+//  over several independently locked LRUCaches chosen by key hash, so
+//  threads working on different keys rarely wait for each other.
+//
+
+#ifndef LRUCache_hpp
+#define LRUCache_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "IntrusiveList.hpp"
+
+// Default Weigher: capacity is a number of entries
+struct LRUUnitWeight {
+    template <class K, class V>
+    size_t operator()(const K &, const V &) const { return 1; }
+};
+
+template <class K, class V, class Hash = std::hash<K>, class Weigher = LRUUnitWeight>
+class LRUCache {
+private:
+    struct Entry : IntrusiveListHook<> {
+        K      key;
+        V      value;
+        size_t hash;
+        size_t weight;
+        Entry *chainNext;
+
+        Entry(const K &k, V &&v, size_t h) : key{k}, value{std::move(v)}, hash{h}, weight{0}, chainNext{nullptr} {}
+    };
+
+    std::vector<Entry *> buckets;       // Power of two, chains through chainNext
+    IntrusiveList<Entry> recency;       // Front is the most recently used
+    std::vector<Entry *> spareEntries;
+    size_t  capacity;
+    size_t  currentWeight;
+    int     bucketShift;
+    Hash    hasher;
+    Weigher weigher;
+
+    // Functions
+    size_t  bucketFor(size_t) const;
+    Entry **findSlot(const K &, size_t);
+    Entry  *newEntry(const K &, V &&, size_t);
+    void    unlinkEntry(Entry **);
+    void    evictUntilFits();
+    void    grow();
+
+public:
+    // Constructor
+    explicit LRUCache(size_t, const Hash & = Hash(), const Weigher & = Weigher());
+    LRUCache(const LRUCache &) = delete;
+    LRUCache &operator=(const LRUCache &) = delete;
+
+    // Destructor
+    ~LRUCache();
+
+    // Functions
+    V     *find(const K &);
+    bool   get(const K &, V &);
+    bool   put(const K &, V);
+    bool   erase(const K &);
+    bool   contains(const K &) const;
+    void   clear();
+    size_t size() const;
+    size_t weight() const;
+    size_t getCapacity() const;
+};
+
+// Constructor
+template <class K, class V, class Hash, class Weigher>
+LRUCache<K, V, Hash, Weigher>::LRUCache(size_t cap, const Hash &h, const Weigher &w)
+    : buckets(16, nullptr), capacity{cap}, currentWeight{0}, bucketShift{64 - 4},
+      hasher{h}, weigher{w} { }
+
+// Destructor
+template <class K, class V, class Hash, class Weigher>
+LRUCache<K, V, Hash, Weigher>::~LRUCache() {
+    clear();
+    for (Entry *e : spareEntries) {
+        ::operator delete(e);
+    }
+}
+
+// **Private** //
+// bucketFor()
+//
+// Fibonacci hashing: the multiply spreads hashes like std::hash<int>
+// (the identity) over the high bits, which pick the bucket.
+template <class K, class V, class Hash, class Weigher>
+size_t LRUCache<K, V, Hash, Weigher>::bucketFor(size_t h) const {
+    return static_cast<size_t>((static_cast<uint64_t>(h) * 0x9E3779B97F4A7C15ull) >> bucketShift);
+}
+
+// **Private** //
+// findSlot()
+//
+// Returns the link that points at the entry for key, or at the
+// nullptr ending its chain if there is no such entry.
+template <class K, class V, class Hash, class Weigher>
+typename LRUCache<K, V, Hash, Weigher>::Entry **
+LRUCache<K, V, Hash, Weigher>::findSlot(const K &key, size_t h) {
+    Entry **slot = &buckets[bucketFor(h)];
+    while (*slot && !((*slot)->hash == h && (*slot)->key == key)) {
+        slot = &(*slot)->chainNext;
+    }
+    return slot;
+}
+
+// **Private** //
+// newEntry()
+//
+// Builds an entry, reusing the memory of an evicted one if possible.
+template <class K, class V, class Hash, class Weigher>
+typename LRUCache<K, V, Hash, Weigher>::Entry *
+LRUCache<K, V, Hash, Weigher>::newEntry(const K &key, V &&value, size_t h) {
+    void *memory;
+    if (!spareEntries.empty()) {
+        memory = spareEntries.back();
+        spareEntries.pop_back();
+    }
+    else {
+        memory = ::operator new(sizeof(Entry));
+    }
+    try {
+        return ::new (memory) Entry(key, std::move(value), h);
+    }
+    catch (...) {
+        ::operator delete(memory);
+        throw;
+    }
+}
+
+// **Private** //
+// unlinkEntry()
+//
+// Removes the entry *slot points at from the index and the recency
+// list, destroys it and keeps its memory for reuse.
+template <class K, class V, class Hash, class Weigher>
+void LRUCache<K, V, Hash, Weigher>::unlinkEntry(Entry **slot) {
+    Entry *e = *slot;
+    *slot = e->chainNext;
+    recency.remove(*e);
+    currentWeight -= e->weight;
+
+    e->~Entry();
+    spareEntries.push_back(e);
+}
+
+// **Private** //
+// evictUntilFits()
+template <class K, class V, class Hash, class Weigher>
+void LRUCache<K, V, Hash, Weigher>::evictUntilFits() {
+    while (currentWeight > capacity && !recency.isEmpty()) {
+        Entry &victim = recency.getRear();
+        unlinkEntry(findSlot(victim.key, victim.hash));
+    }
+}
+
+// **Private** //
+// grow()
+//
+// Doubles the bucket count once there are more entries than buckets.
+// Entries are relinked, never copied.
+template <class K, class V, class Hash, class Weigher>
+void LRUCache<K, V, Hash, Weigher>::grow() {
+    std::vector<Entry *> old(buckets.size() * 2, nullptr);
+    old.swap(buckets);
+    --bucketShift;
+
+    for (Entry *chain : old) {
+        while (chain) {
+            Entry *next = chain->chainNext;
+            Entry *&head = buckets[bucketFor(chain->hash)];
+            chain->chainNext = head;
+            head = chain;
+            chain = next;
+        }
+    }
+}
+
+// **Public** //
+// find()
+//
+// Returns a pointer to the cached value and marks it most recently
+// used, or nullptr on a miss. The pointer is valid until the entry
+// is evicted or erased.
+template <class K, class V, class Hash, class Weigher>
+V *LRUCache<K, V, Hash, Weigher>::find(const K &key) {
+    Entry *e = *findSlot(key, hasher(key));
+    if (e == nullptr) {
+        return nullptr;
+    }
+    recency.moveToFront(*e);
+    return &e->value;
+}
+
+// **Public** //
+// get()
+//
+// Copies the cached value into out. Returns false on a miss.
+template <class K, class V, class Hash, class Weigher>
+bool LRUCache<K, V, Hash, Weigher>::get(const K &key, V &out) {
+    V *value = find(key);
+    if (value == nullptr) {
+        return false;
+    }
+    out = *value;
+    return true;
+}
+
+// **Public** //
+// put()
+//
+// Inserts or replaces the value for key, then evicts least recently
+// used entries until the cache is back under capacity. Returns false
+// if the entry alone is heavier than the whole capacity, in which
+// case it is not kept.
+template <class K, class V, class Hash, class Weigher>
+bool LRUCache<K, V, Hash, Weigher>::put(const K &key, V value) {
+    size_t h = hasher(key);
+    size_t w = weigher(key, value);
+    Entry **slot = findSlot(key, h);
+
+    if (*slot) {
+        unlinkEntry(slot);
+    }
+    if (w > capacity) {
+        return false;
+    }
+
+    Entry *e = newEntry(key, std::move(value), h);
+    e->weight = w;
+    e->chainNext = *slot;
+    *slot = e;
+    recency.insertFront(*e);
+    currentWeight += w;
+
+    evictUntilFits();
+    if (recency.getSize() > buckets.size()) {
+        grow();
+    }
+    return true;
+}
+
+// **Public** //
+// erase()
+template <class K, class V, class Hash, class Weigher>
+bool LRUCache<K, V, Hash, Weigher>::erase(const K &key) {
+    Entry **slot = findSlot(key, hasher(key));
+    if (*slot == nullptr) {
+        return false;
+    }
+    unlinkEntry(slot);
+    return true;
+}
+
+// **Public** //
+// contains()
+//
+// Does not count as a use.
+template <class K, class V, class Hash, class Weigher>
+bool LRUCache<K, V, Hash, Weigher>::contains(const K &key) const {
+    size_t h = hasher(key);
+    for (Entry *e = buckets[bucketFor(h)]; e; e = e->chainNext) {
+        if (e->hash == h && e->key == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// **Public** //
+// clear()
+template <class K, class V, class Hash, class Weigher>
+void LRUCache<K, V, Hash, Weigher>::clear() {
+    while (Entry *e = recency.removeFront()) {
+        e->~Entry();
+        spareEntries.push_back(e);
+    }
+    for (Entry *&head : buckets) {
+        head = nullptr;
+    }
+    currentWeight = 0;
+}
+
+// **Public** //
+// size()
+template <class K, class V, class Hash, class Weigher>
+size_t LRUCache<K, V, Hash, Weigher>::size() const {
+    return recency.getSize();
+}
+
+// **Public** //
+// weight()
+template <class K, class V, class Hash, class Weigher>
+size_t LRUCache<K, V, Hash, Weigher>::weight() const {
+    return currentWeight;
+}
+
+// **Public** //
+// getCapacity()
+template <class K, class V, class Hash, class Weigher>
+size_t LRUCache<K, V, Hash, Weigher>::getCapacity() const {
+    return capacity;
+}
+
+
+// Sharded LRU Cache
+template <class K, class V, class Hash = std::hash<K>, class Weigher = LRUUnitWeight>
+class ShardedLRUCache {
+private:
+    struct alignas(64) Shard {
+        std::mutex lock;
+        LRUCache<K, V, Hash, Weigher> cache;
+
+        Shard(size_t cap, const Hash &h, const Weigher &w) : cache(cap, h, w) {}
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    Hash hasher;
+
+    Shard &shardFor(const K &) const;
+
+public:
+    // Constructor
+    //
+    // capacity is split evenly over numShards, rounded up to a power of two.
+    ShardedLRUCache(size_t, size_t = 16, const Hash & = Hash(), const Weigher & = Weigher());
+
+    // Functions
+    bool   get(const K &, V &);
+    bool   put(const K &, V);
+    bool   erase(const K &);
+    bool   contains(const K &) const;
+    void   clear();
+    size_t size() const;
+};
+
+// Constructor
+template <class K, class V, class Hash, class Weigher>
+ShardedLRUCache<K, V, Hash, Weigher>::ShardedLRUCache(size_t capacity, size_t numShards,
+                                                      const Hash &h, const Weigher &w)
+    : hasher{h} {
+    size_t count = 1;
+    while (count < numShards) {
+        count <<= 1;
+    }
+    size_t perShard = (capacity + count - 1) / count;
+    for (size_t i = 0; i < count; ++i) {
+        shards.emplace_back(new Shard(perShard, h, w));
+    }
+}
+
+// **Private** //
+// shardFor()
+//
+// Uses different hash bits than the shard's own bucket choice so keys
+// in one shard still spread over all of its buckets.
+template <class K, class V, class Hash, class Weigher>
+typename ShardedLRUCache<K, V, Hash, Weigher>::Shard &
+ShardedLRUCache<K, V, Hash, Weigher>::shardFor(const K &key) const {
+    uint64_t h = static_cast<uint64_t>(hasher(key)) * 0xC2B2AE3D27D4EB4Full;
+    return *shards[(h >> 32) & (shards.size() - 1)];
+}
+
+// **Public** //
+// get()
+template <class K, class V, class Hash, class Weigher>
+bool ShardedLRUCache<K, V, Hash, Weigher>::get(const K &key, V &out) {
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    return shard.cache.get(key, out);
+}
+
+// **Public** //
+// put()
+template <class K, class V, class Hash, class Weigher>
+bool ShardedLRUCache<K, V, Hash, Weigher>::put(const K &key, V value) {
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    return shard.cache.put(key, std::move(value));
+}
+
+// **Public** //
+// erase()
+template <class K, class V, class Hash, class Weigher>
+bool ShardedLRUCache<K, V, Hash, Weigher>::erase(const K &key) {
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    return shard.cache.erase(key);
+}
+
+// **Public** //
+// contains()
+template <class K, class V, class Hash, class Weigher>
+bool ShardedLRUCache<K, V, Hash, Weigher>::contains(const K &key) const {
+    Shard &shard = shardFor(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+    return shard.cache.contains(key);
+}
+
+// **Public** //
+// clear()
+template <class K, class V, class Hash, class Weigher>
+void ShardedLRUCache<K, V, Hash, Weigher>::clear() {
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> guard(shard->lock);
+        shard->cache.clear();
+    }
+}
+
+// **Public** //
+// size()
+template <class K, class V, class Hash, class Weigher>
+size_t ShardedLRUCache<K, V, Hash, Weigher>::size() const {
+    size_t total = 0;
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> guard(shard->lock);
+        total += shard->cache.size();
+    }
+    return total;
+}
+
+#endif /* LRUCache.hpp */
@@ -6,125 +6,708 @@
 //
 //  Description
 //
-//  This file is still in production, but main functionality
-//  to insert a node at the front or rear of the linked list
-//  is currently working. For inserting, my plan is to create
-//  more insert variants in which one can insert after or before
-//  other data.
+//  An unrolled doubly linked list. Each node holds a small array of
+//  elements (about two cache lines worth) instead of a single one, so
+//  walking the list touches far fewer nodes and far fewer pointers.
+//  Inserting into a full node splits it in half, and erasing from a
+//  node that has become sparse pulls in the next node's elements.
 //
-//  TODO:
-//  1. Destructor needs to delete dynamically allocated memory.
-//  2. Insert variants
-//  3. Delete variants
-//  4. Sorting?
+//  Emptied nodes are kept in a pool and reused by later inserts, so a
+//  list whose size goes up and down does not keep calling new and
+//  delete. releaseSpareNodes() gives the pool back to the system.
+//
+//  Nodes come from the memory resource given to the constructor. A
+//  copy uses the default resource unless told otherwise, and moving
+//  or splicing between lists on different resources moves the
+//  elements one at a time instead of relinking nodes.
+//
+//  Iterators refer to an (node, index) position. Like std::vector,
+//  inserting or erasing invalidates iterators into the node that
+//  changed (and the node a split or merge moved elements into); use
+//  the iterator returned by insert()/erase() to keep going.
+//
+//  The list has no sort() of its own, and its iterators are only
+//  bidirectional, so the Sorting.hpp algorithms do not apply to it
+//  directly; copy the elements into a vector to sort them.
 //
 
 #ifndef LinkedList_h
 #define LinkedList_h
 
-#include <iostream>
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 template <class T>
 class LinkedList {
 private:
+    static constexpr size_t NODE_BYTES    = 128;
+    static constexpr int    NODE_CAPACITY =
+        (sizeof(T) * 4 <= NODE_BYTES) ? static_cast<int>(NODE_BYTES / sizeof(T)) : 4;
+
     struct Node {
-        T data;
         struct Node *next;
         struct Node *prev;
+        int count;
+        alignas(T) unsigned char storage[NODE_CAPACITY * sizeof(T)];
+
+        T *data() { return reinterpret_cast<T *>(storage); }
     };
     Node *front;
     Node *rear;
-    
+    Node *spareNodes;   // Pool of unused nodes, linked through next
+    size_t numItems;
+    std::pmr::polymorphic_allocator<Node> alloc;
+
+    // Node Management
+    Node *acquireNode();
+    void  releaseNode(Node *);
+    Node *linkAfter(Node *);
+    void  unlink(Node *);
+    Node *split(Node *, int);
+    void  mergeNext(Node *);
+    void  moveItemsFrom(LinkedList &);
+
+    template <class V>
+    class basic_iterator {
+    private:
+        friend class LinkedList;
+        template <class> friend class basic_iterator;
+
+        Node *node;
+        int   index;
+        const LinkedList *list;
+
+        basic_iterator(Node *n, int i, const LinkedList *l) : node{n}, index{i}, list{l} {}
+
+    public:
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef T              value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef V *            pointer;
+        typedef V &            reference;
+
+        basic_iterator() : node{nullptr}, index{0}, list{nullptr} {}
+
+        // iterator converts to const_iterator
+        template <class U, class = typename std::enable_if<
+                  std::is_const<V>::value && std::is_same<U, T>::value>::type>
+        basic_iterator(const basic_iterator<U> &other)
+            : node{other.node}, index{other.index}, list{other.list} {}
+
+        reference operator*() const { return node->data()[index]; }
+        pointer operator->() const { return node->data() + index; }
+
+        basic_iterator &operator++() {
+            if (++index == node->count) {
+                node  = node->next;
+                index = 0;
+            }
+            return *this;
+        }
+        basic_iterator operator++(int) {
+            basic_iterator temp = *this;
+            ++(*this);
+            return temp;
+        }
+        basic_iterator &operator--() {
+            if (node == nullptr) {
+                node  = list->rear;
+                index = node->count - 1;
+            }
+            else if (index == 0) {
+                node  = node->prev;
+                index = node->count - 1;
+            }
+            else {
+                --index;
+            }
+            return *this;
+        }
+        basic_iterator operator--(int) {
+            basic_iterator temp = *this;
+            --(*this);
+            return temp;
+        }
+
+        bool operator==(const basic_iterator &other) const {
+            return node == other.node && index == other.index;
+        }
+        bool operator!=(const basic_iterator &other) const {
+            return !(*this == other);
+        }
+    };
+
 public:
+    typedef basic_iterator<T>       iterator;
+    typedef basic_iterator<const T> const_iterator;
+
     // Constructor
-    LinkedList();
-    
+    explicit LinkedList(std::pmr::memory_resource * = std::pmr::get_default_resource());
+    LinkedList(const LinkedList &, std::pmr::memory_resource * = std::pmr::get_default_resource());
+    LinkedList(LinkedList &&) noexcept;
+
     // Destructor
     ~LinkedList();
-    
+
+    // Operators
+    LinkedList &operator=(const LinkedList &);
+    LinkedList &operator=(LinkedList &&);
+
+    // Iterators
+    iterator       begin()       { return iterator(front, 0, this); }
+    iterator       end()         { return iterator(nullptr, 0, this); }
+    const_iterator begin() const { return const_iterator(front, 0, this); }
+    const_iterator end()   const { return const_iterator(nullptr, 0, this); }
+
     // Functions
-    bool isEmpty();
-    void insertFront(T);
-    void insertRear(T);
-    void insertAfterThis(T, T);
+    bool   isEmpty() const;
+    size_t getSize() const;
+    T       &getFront();
+    const T &getFront() const;
+    T       &getRear();
+    const T &getRear() const;
+
+    // Inserts
+    void insertFront(const T &);
+    void insertFront(T &&);
+    void insertRear(const T &);
+    void insertRear(T &&);
+    bool insertAfterThis(const T &, const T &);
+    iterator insert(const_iterator, const T &);
+    iterator insert(const_iterator, T &&);
+    template <class... Args>
+    iterator emplace(const_iterator, Args &&...);
+
+    // Deletes
+    iterator erase(const_iterator);
+    void removeFront();
+    void removeRear();
+    bool remove(const T &);
+    void clear();
+
+    // Others
+    iterator find(const T &);
+    const_iterator find(const T &) const;
+    void splice(const_iterator, LinkedList &);
+    void releaseSpareNodes();
+    std::pmr::memory_resource *getResource() const;
 };
 
 // Function Definitions
 // **Constructor** //
 // LinkedList()
+//
+// Nodes are allocated from resource, which must outlive the list.
 template <class T>
-void LinkedList<T>::LinkedList() {
-    front = nullptr;
-    rear = nullptr;
+LinkedList<T>::LinkedList(std::pmr::memory_resource *resource) : alloc{resource} {
+    front      = nullptr;
+    rear       = nullptr;
+    spareNodes = nullptr;
+    numItems   = 0;
+}
+
+// **Constructor** //
+// LinkedList(const LinkedList &)
+template <class T>
+LinkedList<T>::LinkedList(const LinkedList &other, std::pmr::memory_resource *resource)
+    : LinkedList(resource) {
+    for (const T &item : other) {
+        insertRear(item);
+    }
+}
+
+// **Constructor** //
+// LinkedList(LinkedList &&)
+//
+// Takes the nodes of other along with its memory resource.
+template <class T>
+LinkedList<T>::LinkedList(LinkedList &&other) noexcept : LinkedList(other.getResource()) {
+    std::swap(front,      other.front);
+    std::swap(rear,       other.rear);
+    std::swap(spareNodes, other.spareNodes);
+    std::swap(numItems,   other.numItems);
 }
 
 // **Destructor** //
 // ~LinkedList()
 template <class T>
-void LinkedList<T>::~LinkedList() {
-    
-    // NEED TO DELETE DYNAMIC MEMORY
+LinkedList<T>::~LinkedList() {
+    clear();
+    releaseSpareNodes();
+}
+
+// **Operator** //
+// operator=()
+template <class T>
+LinkedList<T> &LinkedList<T>::operator=(const LinkedList &other) {
+    if (this != &other) {
+        clear();
+        for (const T &item : other) {
+            insertRear(item);
+        }
+    }
+    return *this;
+}
+
+// The list keeps its own memory resource. Nodes are only taken over
+// when other uses the same one.
+template <class T>
+LinkedList<T> &LinkedList<T>::operator=(LinkedList &&other) {
+    if (this == &other) {
+        return *this;
+    }
+    clear();
+    if (alloc == other.alloc) {
+        std::swap(front,      other.front);
+        std::swap(rear,       other.rear);
+        std::swap(spareNodes, other.spareNodes);
+        std::swap(numItems,   other.numItems);
+    }
+    else {
+        moveItemsFrom(other);
+    }
+    return *this;
+}
+
+// **Private** //
+// acquireNode()
+//
+// Takes a node from the pool, or allocates one if the pool is empty.
+template <class T>
+typename LinkedList<T>::Node *LinkedList<T>::acquireNode() {
+    Node *newNode = spareNodes;
+
+    if (newNode) {
+        spareNodes = newNode->next;
+    }
+    else {
+        newNode = alloc.allocate(1);
+        ::new (static_cast<void *>(newNode)) Node;
+    }
+    newNode->next  = nullptr;
+    newNode->prev  = nullptr;
+    newNode->count = 0;
+    return newNode;
+}
+
+// **Private** //
+// releaseNode()
+//
+// Returns an empty, unlinked node to the pool.
+template <class T>
+void LinkedList<T>::releaseNode(Node *nodePtr) {
+    nodePtr->next = spareNodes;
+    spareNodes = nodePtr;
+}
+
+// **Private** //
+// linkAfter()
+//
+// Links a new empty node after nodePtr, or at the front of the list
+// if nodePtr is nullptr.
+template <class T>
+typename LinkedList<T>::Node *LinkedList<T>::linkAfter(Node *nodePtr) {
+    Node *newNode = acquireNode();
+
+    newNode->prev = nodePtr;
+    newNode->next = nodePtr ? nodePtr->next : front;
+    if (newNode->next) newNode->next->prev = newNode;
+    else               rear = newNode;
+    if (nodePtr) nodePtr->next = newNode;
+    else         front = newNode;
+    return newNode;
+}
+
+// **Private** //
+// unlink()
+template <class T>
+void LinkedList<T>::unlink(Node *nodePtr) {
+    if (nodePtr->prev) nodePtr->prev->next = nodePtr->next;
+    else               front = nodePtr->next;
+    if (nodePtr->next) nodePtr->next->prev = nodePtr->prev;
+    else               rear = nodePtr->prev;
+}
+
+// **Private** //
+// split()
+//
+// Moves the elements from index onwards into a new node linked after
+// nodePtr and returns the new node.
+template <class T>
+typename LinkedList<T>::Node *LinkedList<T>::split(Node *nodePtr, int index) {
+    Node *newNode = linkAfter(nodePtr);
+    T *from = nodePtr->data();
+    T *to   = newNode->data();
+
+    for (int i = index; i < nodePtr->count; ++i) {
+        ::new (static_cast<void *>(to + newNode->count++)) T(std::move(from[i]));
+        from[i].~T();
+    }
+    nodePtr->count = index;
+    return newNode;
+}
+
+// **Private** //
+// mergeNext()
+//
+// Moves every element of the following node into nodePtr (the caller
+// checks they fit) and returns the emptied node to the pool.
+template <class T>
+void LinkedList<T>::mergeNext(Node *nodePtr) {
+    Node *nextNode = nodePtr->next;
+    T *from = nextNode->data();
+    T *to   = nodePtr->data();
+
+    for (int i = 0; i < nextNode->count; ++i) {
+        ::new (static_cast<void *>(to + nodePtr->count++)) T(std::move(from[i]));
+        from[i].~T();
+    }
+    unlink(nextNode);
+    releaseNode(nextNode);
+}
+
+// **Private** //
+// moveItemsFrom()
+//
+// Moves the elements of other, in order, onto the rear of this list
+// and empties other. Used when the two lists cannot share nodes.
+template <class T>
+void LinkedList<T>::moveItemsFrom(LinkedList &other) {
+    for (T &item : other) {
+        insertRear(std::move(item));
+    }
+    other.clear();
 }
 
 // **Public** //
 // isEmpty()
 template <class T>
-void LinkedList<T>::isEmpty() {
+bool LinkedList<T>::isEmpty() const {
     return (front == nullptr);
 }
 
+// **Public** //
+// getSize()
+template <class T>
+size_t LinkedList<T>::getSize() const {
+    return numItems;
+}
+
+// **Public** //
+// getFront()
+template <class T>
+T &LinkedList<T>::getFront() {
+    return front->data()[0];
+}
+
+template <class T>
+const T &LinkedList<T>::getFront() const {
+    return front->data()[0];
+}
+
+// **Public** //
+// getRear()
+template <class T>
+T &LinkedList<T>::getRear() {
+    return rear->data()[rear->count - 1];
+}
+
+template <class T>
+const T &LinkedList<T>::getRear() const {
+    return rear->data()[rear->count - 1];
+}
+
 // **Public** //
 // insertFront()
 template <class T>
-void LinkedList<T>::insertFront(T newItem) {
-    Node *newNode;
-    newNode = new Node;
-    newNode->data = newItem;
-    
-    if (isEmpty()) {
-        front = rear = newNode;
-        newNode->next = nullptr;
-        newNode->prev = nullptr;
+void LinkedList<T>::insertFront(const T &newItem) {
+    emplace(begin(), newItem);
+}
+
+template <class T>
+void LinkedList<T>::insertFront(T &&newItem) {
+    emplace(begin(), std::move(newItem));
+}
+
+// **Public** //
+// insertRear()
+template <class T>
+void LinkedList<T>::insertRear(const T &newItem) {
+    emplace(end(), newItem);
+}
+
+template <class T>
+void LinkedList<T>::insertRear(T &&newItem) {
+    emplace(end(), std::move(newItem));
+}
+
+// **Public** //
+// insertAfterThis()
+//
+// Inserts newItem right after the first element equal to search.
+// Returns false, inserting nothing, if search is not in the list.
+template <class T>
+bool LinkedList<T>::insertAfterThis(const T &search, const T &newItem) {
+    iterator pos = find(search);
+
+    if (pos == end()) {
+        return false;
     }
-    else {
-        newNode->next = front;
-        newNode->prev = nullptr;
-        front->prev = newItem;
-        front = newItem;
+    emplace(++pos, newItem);
+    return true;
+}
+
+// **Public** //
+// insert()
+//
+// Inserts before pos and returns an iterator to the new element.
+template <class T>
+typename LinkedList<T>::iterator LinkedList<T>::insert(const_iterator pos, const T &newItem) {
+    return emplace(pos, newItem);
+}
+
+template <class T>
+typename LinkedList<T>::iterator LinkedList<T>::insert(const_iterator pos, T &&newItem) {
+    return emplace(pos, std::move(newItem));
+}
+
+// **Public** //
+// emplace()
+//
+// Constructs a new element from args before pos.
+template <class T>
+template <class... Args>
+typename LinkedList<T>::iterator LinkedList<T>::emplace(const_iterator pos, Args &&...args) {
+    Node *nodePtr = pos.node;
+    int   index   = pos.index;
+
+    // Build the item before anything moves, args may refer to an
+    // element of this list
+    T item(std::forward<Args>(args)...);
+
+    // Appending goes at the end of the rear node
+    if (nodePtr == nullptr) {
+        nodePtr = rear;
+        if (nodePtr == nullptr || nodePtr->count == NODE_CAPACITY) {
+            nodePtr = linkAfter(rear);
+        }
+        index = nodePtr->count;
+    }
+    // Inserting at the start of a node can use room left in the previous one
+    else if (index == 0 && nodePtr->prev && nodePtr->prev->count < NODE_CAPACITY) {
+        nodePtr = nodePtr->prev;
+        index   = nodePtr->count;
+    }
+    else if (nodePtr->count == NODE_CAPACITY) {
+        if (index == 0) {
+            nodePtr = linkAfter(nodePtr->prev);
+        }
+        else {
+            Node *upper = split(nodePtr, NODE_CAPACITY / 2);
+            if (index > nodePtr->count) {
+                index  -= nodePtr->count;
+                nodePtr = upper;
+            }
+        }
     }
+
+    // Open a gap at index
+    T *items = nodePtr->data();
+    for (int i = nodePtr->count; i > index; --i) {
+        ::new (static_cast<void *>(items + i)) T(std::move(items[i - 1]));
+        items[i - 1].~T();
+    }
+    ::new (static_cast<void *>(items + index)) T(std::move(item));
+    ++nodePtr->count;
+    ++numItems;
+    return iterator(nodePtr, index, this);
 }
 
 // **Public** //
-// insertRear()
+// erase()
+//
+// Removes the element at pos and returns an iterator to the element
+// that followed it.
+template <class T>
+typename LinkedList<T>::iterator LinkedList<T>::erase(const_iterator pos) {
+    Node *nodePtr = pos.node;
+    int   index   = pos.index;
+    T    *items   = nodePtr->data();
+
+    items[index].~T();
+    for (int i = index + 1; i < nodePtr->count; ++i) {
+        ::new (static_cast<void *>(items + i - 1)) T(std::move(items[i]));
+        items[i].~T();
+    }
+    --nodePtr->count;
+    --numItems;
+
+    if (nodePtr->count == 0) {
+        Node *nextNode = nodePtr->next;
+        unlink(nodePtr);
+        releaseNode(nodePtr);
+        return iterator(nextNode, 0, this);
+    }
+
+    // Keep nodes at least a quarter full
+    Node *nextNode = nodePtr->next;
+    if (nodePtr->count < NODE_CAPACITY / 4 && nextNode &&
+        nodePtr->count + nextNode->count <= NODE_CAPACITY) {
+        mergeNext(nodePtr);
+        return iterator(nodePtr, index, this);
+    }
+    if (index == nodePtr->count) {
+        return iterator(nextNode, 0, this);
+    }
+    return iterator(nodePtr, index, this);
+}
+
+// **Public** //
+// removeFront()
+template <class T>
+void LinkedList<T>::removeFront() {
+    if (!isEmpty()) {
+        erase(begin());
+    }
+}
+
+// **Public** //
+// removeRear()
+template <class T>
+void LinkedList<T>::removeRear() {
+    if (!isEmpty()) {
+        erase(--end());
+    }
+}
+
+// **Public** //
+// remove()
+//
+// Removes the first element equal to item. Returns false if there
+// was none.
+template <class T>
+bool LinkedList<T>::remove(const T &item) {
+    iterator pos = find(item);
+
+    if (pos == end()) {
+        return false;
+    }
+    erase(pos);
+    return true;
+}
+
+// **Public** //
+// clear()
+//
+// Destroys every element. The nodes go back to the pool.
+template <class T>
+void LinkedList<T>::clear() {
+    Node *nodePtr = front;
+
+    while (nodePtr) {
+        Node *nextNode = nodePtr->next;
+        T *items = nodePtr->data();
+        for (int i = 0; i < nodePtr->count; ++i) {
+            items[i].~T();
+        }
+        releaseNode(nodePtr);
+        nodePtr = nextNode;
+    }
+    front = rear = nullptr;
+    numItems = 0;
+}
+
+// **Public** //
+// find()
 template <class T>
-void LinkedList<T>::insertRear(T newItem) {
-    Node *newNode;
-    newNode = new Node;
-    newNode->data = newItem;
-    
-    if (isEmpty()) {
-        front = rear = newNode;
-        newNode->next = nullptr;
-        newNode->prev = nullptr;
+typename LinkedList<T>::iterator LinkedList<T>::find(const T &item) {
+    for (Node *nodePtr = front; nodePtr; nodePtr = nodePtr->next) {
+        T *items = nodePtr->data();
+        for (int i = 0; i < nodePtr->count; ++i) {
+            if (items[i] == item) {
+                return iterator(nodePtr, i, this);
+            }
+        }
+    }
+    return end();
+}
+
+template <class T>
+typename LinkedList<T>::const_iterator LinkedList<T>::find(const T &item) const {
+    return const_cast<LinkedList *>(this)->find(item);
+}
+
+// **Public** //
+// splice()
+//
+// Moves every element of other in front of pos in O(1): the node
+// chain is relinked, and at most one node is split so that pos falls
+// on a node boundary. No element is copied or moved between nodes
+// other than by that split.
+//
+// If other allocates from a different memory resource its nodes
+// cannot be adopted, and the elements are moved in one at a time.
+template <class T>
+void LinkedList<T>::splice(const_iterator pos, LinkedList &other) {
+    if (this == &other || other.isEmpty()) {
+        return;
+    }
+    if (alloc != other.alloc) {
+        for (T &item : other) {
+            pos = std::next(insert(pos, std::move(item)));
+        }
+        other.clear();
+        return;
+    }
+
+    Node *before;
+    if (pos.node == nullptr) {
+        before = rear;
+    }
+    else if (pos.index == 0) {
+        before = pos.node->prev;
     }
     else {
-        newNode->prev = rear;
-        rear->next = newNode;
-        newNode->next = nullptr;
-        rear = newNode;
+        split(pos.node, pos.index);
+        before = pos.node;
     }
+    Node *after = before ? before->next : front;
+
+    other.front->prev = before;
+    other.rear->next  = after;
+    if (before) before->next = other.front;
+    else        front = other.front;
+    if (after)  after->prev = other.rear;
+    else        rear = other.rear;
+
+    numItems += other.numItems;
+    other.front = other.rear = nullptr;
+    other.numItems = 0;
 }
 
 // **Public** //
-// insertAfterThis()
+// releaseSpareNodes()
+//
+// Frees the nodes held in the pool.
+template <class T>
+void LinkedList<T>::releaseSpareNodes() {
+    while (spareNodes) {
+        Node *nextNode = spareNodes->next;
+        spareNodes->~Node();
+        alloc.deallocate(spareNodes, 1);
+        spareNodes = nextNode;
+    }
+}
+
+// **Public** //
+// getResource()
 template <class T>
-void LinkedList<T>::insertAfterThis(T search, T newItem) {
-    Node *newNode;
-    newNode = new Node;
-    newNode->data = newItem;
-    
-    std::cout << "This function is not complete" << std::endl;
-    delete newNode;
+std::pmr::memory_resource *LinkedList<T>::getResource() const {
+    return alloc.resource();
 }
 
 #endif /* LinkedList_h */
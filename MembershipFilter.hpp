@@ -0,0 +1,650 @@
+//
+//  MembershipFilter.hpp
+//  CustomLibraries
+//
+//  Description
+//
+//  Approximate set membership filters, used to answer "definitely not
+//  there" without touching the container that holds the real data.
+//  Neither filter ever reports a key it was given as missing; a key it
+//  was not given is reported as possibly present with a small false
+//  positive rate.
+//
+//  BloomFilter is a blocked Bloom filter. A key picks one 64-byte block
+//  (one cache line) and sets 8 bits in it, one in each 64-bit word, so
+//  a lookup costs a single cache miss. On x86-64 with AVX2 the 8 bits
+//  are computed and tested in one go. At the default 10 bits per key
+//  the false positive rate is around 1%. Keys cannot be removed.
+//
+//  CuckooFilter stores a 16-bit fingerprint of each key in one of two
+//  buckets of 4 slots (partial-key cuckoo hashing), so a lookup reads
+//  at most two 8-byte buckets. The false positive rate is about 0.01%
+//  and keys can be removed again, provided they were inserted.
+//
+//  Filtered puts either filter in front of a container, so that
+//  lookups for keys that are not there usually never reach it:
+//
+//      Filtered<ChainingHash<int, Order>, CuckooFilter<int>> orders(
+//          CuckooFilter<int>(100000));
+//      orders.insert({id, order});
+//      if (orders.contains(id)) { ... }
+//
+//  Keys are hashed with Hash (std::hash by default) and then mixed, so
+//  the identity hash std::hash gives integers works fine.
+//
+
+#ifndef MembershipFilter_hpp
+#define MembershipFilter_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#include <immintrin.h>
+#define FILTER_SIMD 1
+#define FILTER_AVX2 __attribute__((target("avx2")))
+#endif
+
+// Default size of a BloomFilter
+static const double BLOOM_BITS_PER_KEY = 10.0;
+
+// Evictions a CuckooFilter insert tries before giving up
+static const int CUCKOO_MAX_KICKS = 500;
+
+namespace filter_detail {
+
+    // Finalizer from MurmurHash3: spreads every input bit over the output
+    inline uint64_t mix64(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // Multipliers that pick the bit set in each word of a Bloom block
+    static const uint32_t BLOOM_SALT[8] = {
+        0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+        0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+    };
+
+    // The key a container item is looked up by: the first member of a
+    // (key, value) pair, or the item itself
+    template <class Item>
+    const Item &keyOf(const Item &item) { return item; }
+
+    template <class K, class V>
+    const K &keyOf(const std::pair<K, V> &item) { return item.first; }
+
+    template <class C, class Key, class = void>
+    struct HasErase : std::false_type { };
+
+    template <class C, class Key>
+    struct HasErase<C, Key, decltype(void(std::declval<C &>().erase(std::declval<const Key &>())))>
+        : std::true_type { };
+
+#ifdef FILTER_SIMD
+    inline bool hasAvx2() {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+#endif
+
+} // namespace filter_detail
+
+template <class K, class Hash = std::hash<K>>
+class BloomFilter {
+private:
+    struct alignas(64) Block {
+        uint64_t words[8];
+    };
+
+    std::vector<Block> blocks;
+    Hash hasher;
+    bool useSimd;
+
+    uint64_t hashOf(const K &key) const { return filter_detail::mix64(hasher(key)); }
+    Block &blockFor(uint64_t);
+    const Block &blockFor(uint64_t) const;
+    static void setBits(Block &, uint32_t);
+    static bool testBits(const Block &, uint32_t);
+#ifdef FILTER_SIMD
+    FILTER_AVX2 static void setBitsAvx2(Block &, uint32_t);
+    FILTER_AVX2 static bool testBitsAvx2(const Block &, uint32_t);
+#endif
+
+public:
+    // Constructor
+    explicit BloomFilter(size_t, double = BLOOM_BITS_PER_KEY, Hash = Hash());
+
+    // Functions
+    bool   insert(const K &);
+    bool   mayContain(const K &) const;
+    void   clear();
+    size_t getNumBlocks() const;
+};
+
+template <class K, class Hash = std::hash<K>>
+class CuckooFilter {
+private:
+    static constexpr int      SLOTS = 4;
+    static constexpr uint64_t LOW_BITS  = 0x0001000100010001ULL;
+    static constexpr uint64_t HIGH_BITS = 0x8000800080008000ULL;
+
+    // Each bucket packs SLOTS 16-bit fingerprints; 0 marks an empty slot
+    std::vector<uint64_t> buckets;
+    size_t   mask;
+    size_t   numItems;
+    uint64_t random;
+
+    // A fingerprint that had nowhere left to go; once it is set the
+    // filter is full
+    uint16_t victim;
+    size_t   victimIndex;
+    bool     hasVictim;
+
+    Hash hasher;
+
+    uint64_t hashOf(const K &key) const { return filter_detail::mix64(hasher(key)); }
+    static uint16_t fingerprintOf(uint64_t);
+    size_t altIndex(size_t, uint16_t) const;
+    static bool hasFingerprint(uint64_t, uint16_t);
+    bool tryPlace(size_t, uint16_t);
+    bool tryRemove(size_t, uint16_t);
+    uint16_t swapRandomSlot(size_t, uint16_t);
+
+public:
+    // Constructor
+    explicit CuckooFilter(size_t, Hash = Hash());
+
+    // Functions
+    bool   insert(const K &);
+    bool   mayContain(const K &) const;
+    bool   erase(const K &);
+    void   clear();
+    bool   isFull() const;
+    size_t getNumItems() const;
+    size_t getCapacity() const;
+};
+
+template <class Container, class Filter>
+class Filtered {
+private:
+    Container container;
+    Filter    filter;
+    bool      bypass;     // Set if the filter ever ran out of room
+
+public:
+    // Constructor
+    template <class... Args>
+    explicit Filtered(Filter, Args &&...);
+
+    // Functions
+    template <class Item>
+    bool insert(const Item &);
+    template <class Key>
+    bool contains(const Key &) const;
+    template <class Key>
+    bool erase(const Key &);
+    void clear();
+    const Container &getContainer() const;
+    const Filter    &getFilter() const;
+};
+
+// **Constructor** //
+//
+// Sized for expectedItems keys at bitsPerKey bits each.
+template <class K, class Hash>
+BloomFilter<K, Hash>::BloomFilter(size_t expectedItems, double bitsPerKey, Hash h)
+    : hasher(std::move(h)), useSimd{false} {
+    size_t numBlocks = static_cast<size_t>(expectedItems * bitsPerKey / 512.0) + 1;
+    blocks.assign(numBlocks, Block{});
+#ifdef FILTER_SIMD
+    useSimd = filter_detail::hasAvx2();
+#endif
+}
+
+// **Private** //
+// blockFor()
+//
+// The high half of the hash picks the block (by multiplying rather
+// than dividing); the low half picks the bits within it.
+template <class K, class Hash>
+typename BloomFilter<K, Hash>::Block &BloomFilter<K, Hash>::blockFor(uint64_t h) {
+    return blocks[((h >> 32) * blocks.size()) >> 32];
+}
+
+template <class K, class Hash>
+const typename BloomFilter<K, Hash>::Block &BloomFilter<K, Hash>::blockFor(uint64_t h) const {
+    return blocks[((h >> 32) * blocks.size()) >> 32];
+}
+
+// **Private** //
+// setBits()
+template <class K, class Hash>
+void BloomFilter<K, Hash>::setBits(Block &block, uint32_t h) {
+    for (int i = 0; i < 8; ++i) {
+        block.words[i] |= uint64_t(1) << ((h * filter_detail::BLOOM_SALT[i]) >> 26);
+    }
+}
+
+// **Private** //
+// testBits()
+template <class K, class Hash>
+bool BloomFilter<K, Hash>::testBits(const Block &block, uint32_t h) {
+    for (int i = 0; i < 8; ++i) {
+        if (!(block.words[i] >> ((h * filter_detail::BLOOM_SALT[i]) >> 26) & 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef FILTER_SIMD
+// **Private** //
+// setBitsAvx2()
+//
+// Same bits as setBits(): the 8 bit positions are computed in 32-bit
+// lanes, widened to 64 bits and turned into masks for the two halves
+// of the block.
+template <class K, class Hash>
+FILTER_AVX2 void BloomFilter<K, Hash>::setBitsAvx2(Block &block, uint32_t h) {
+    const __m256i salt = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(filter_detail::BLOOM_SALT));
+    const __m256i one  = _mm256_set1_epi64x(1);
+    __m256i bits = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(h)), salt), 26);
+    __m256i low  = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(bits)));
+    __m256i high = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(bits, 1)));
+
+    __m256i *words = reinterpret_cast<__m256i *>(block.words);
+    _mm256_store_si256(words,     _mm256_or_si256(_mm256_load_si256(words),     low));
+    _mm256_store_si256(words + 1, _mm256_or_si256(_mm256_load_si256(words + 1), high));
+}
+
+// **Private** //
+// testBitsAvx2()
+template <class K, class Hash>
+FILTER_AVX2 bool BloomFilter<K, Hash>::testBitsAvx2(const Block &block, uint32_t h) {
+    const __m256i salt = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(filter_detail::BLOOM_SALT));
+    const __m256i one  = _mm256_set1_epi64x(1);
+    __m256i bits = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(h)), salt), 26);
+    __m256i low  = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(bits)));
+    __m256i high = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(bits, 1)));
+
+    const __m256i *words = reinterpret_cast<const __m256i *>(block.words);
+    return _mm256_testc_si256(_mm256_load_si256(words), low) &
+           _mm256_testc_si256(_mm256_load_si256(words + 1), high);
+}
+#endif
+
+// **Public** //
+// insert()
+//
+// Always succeeds; the return value matches CuckooFilter::insert().
+template <class K, class Hash>
+bool BloomFilter<K, Hash>::insert(const K &key) {
+    uint64_t h = hashOf(key);
+#ifdef FILTER_SIMD
+    if (useSimd) {
+        setBitsAvx2(blockFor(h), static_cast<uint32_t>(h));
+        return true;
+    }
+#endif
+    setBits(blockFor(h), static_cast<uint32_t>(h));
+    return true;
+}
+
+// **Public** //
+// mayContain()
+//
+// False means key was never inserted.
+template <class K, class Hash>
+bool BloomFilter<K, Hash>::mayContain(const K &key) const {
+    uint64_t h = hashOf(key);
+#ifdef FILTER_SIMD
+    if (useSimd) {
+        return testBitsAvx2(blockFor(h), static_cast<uint32_t>(h));
+    }
+#endif
+    return testBits(blockFor(h), static_cast<uint32_t>(h));
+}
+
+// **Public** //
+// clear()
+template <class K, class Hash>
+void BloomFilter<K, Hash>::clear() {
+    blocks.assign(blocks.size(), Block{});
+}
+
+// **Public** //
+// getNumBlocks()
+template <class K, class Hash>
+size_t BloomFilter<K, Hash>::getNumBlocks() const {
+    return blocks.size();
+}
+
+// **Constructor** //
+//
+// Sized so that expectedItems keys fill the buckets to about 95%,
+// which is as full as a cuckoo table with 4 slots reliably gets.
+template <class K, class Hash>
+CuckooFilter<K, Hash>::CuckooFilter(size_t expectedItems, Hash h)
+    : numItems{0}, random{0x9e3779b97f4a7c15ULL}, victim{0}, victimIndex{0}, hasVictim{false},
+      hasher(std::move(h)) {
+    size_t wanted = static_cast<size_t>(expectedItems / (SLOTS * 0.95)) + 1;
+    size_t count  = 1;
+    while (count < wanted) {
+        count <<= 1;
+    }
+    buckets.assign(count, 0);
+    mask = count - 1;
+}
+
+// **Private** //
+// fingerprintOf()
+//
+// The top 16 bits of the hash, which the bucket index does not use.
+// 0 is taken to mean an empty slot, so it is moved to 1.
+template <class K, class Hash>
+uint16_t CuckooFilter<K, Hash>::fingerprintOf(uint64_t h) {
+    uint16_t fingerprint = static_cast<uint16_t>(h >> 48);
+    return fingerprint ? fingerprint : 1;
+}
+
+// **Private** //
+// altIndex()
+//
+// The other bucket a fingerprint in bucket index may live in. It only
+// depends on the fingerprint, so it can be found again when the key
+// is long gone, and applying it twice gives back index.
+template <class K, class Hash>
+size_t CuckooFilter<K, Hash>::altIndex(size_t index, uint16_t fingerprint) const {
+    return (index ^ filter_detail::mix64(fingerprint)) & mask;
+}
+
+// **Private** //
+// hasFingerprint()
+//
+// Whether any slot of bucket holds fingerprint, checked for all four
+// slots at once: a slot equal to fingerprint becomes zero after the
+// xor, and subtracting 1 from a zero slot is the only way to set its
+// top bit while it was clear.
+template <class K, class Hash>
+bool CuckooFilter<K, Hash>::hasFingerprint(uint64_t bucket, uint16_t fingerprint) {
+    uint64_t x = bucket ^ (LOW_BITS * fingerprint);
+    return ((x - LOW_BITS) & ~x & HIGH_BITS) != 0;
+}
+
+// **Private** //
+// tryPlace()
+template <class K, class Hash>
+bool CuckooFilter<K, Hash>::tryPlace(size_t index, uint16_t fingerprint) {
+    uint64_t &bucket = buckets[index];
+    for (int slot = 0; slot < SLOTS; ++slot) {
+        if (((bucket >> (16 * slot)) & 0xffff) == 0) {
+            bucket |= uint64_t(fingerprint) << (16 * slot);
+            return true;
+        }
+    }
+    return false;
+}
+
+// **Private** //
+// tryRemove()
+//
+// Clears one slot holding fingerprint.
+template <class K, class Hash>
+bool CuckooFilter<K, Hash>::tryRemove(size_t index, uint16_t fingerprint) {
+    uint64_t &bucket = buckets[index];
+    for (int slot = 0; slot < SLOTS; ++slot) {
+        if (((bucket >> (16 * slot)) & 0xffff) == fingerprint) {
+            bucket &= ~(uint64_t(0xffff) << (16 * slot));
+            return true;
+        }
+    }
+    return false;
+}
+
+// **Private** //
+// swapRandomSlot()
+//
+// Puts fingerprint into a random slot of the (full) bucket and returns
+// the fingerprint it evicted.
+template <class K, class Hash>
+uint16_t CuckooFilter<K, Hash>::swapRandomSlot(size_t index, uint16_t fingerprint) {
+    random ^= random << 13;
+    random ^= random >> 7;
+    random ^= random << 17;
+    int shift = 16 * static_cast<int>(random % SLOTS);
+
+    uint64_t &bucket = buckets[index];
+    uint16_t evicted = static_cast<uint16_t>(bucket >> shift);
+    bucket = (bucket & ~(uint64_t(0xffff) << shift)) | (uint64_t(fingerprint) << shift);
+    return evicted;
+}
+
+// **Public** //
+// insert()
+//
+// Places the key's fingerprint in one of its two buckets, evicting
+// fingerprints to their other bucket to make room if both are full.
+// If that goes on for CUCKOO_MAX_KICKS evictions, the fingerprint left
+// over is kept aside and the filter is full: the insert still
+// succeeds, but every later one returns false until something is
+// erased.
+template <class K, class Hash>
+bool CuckooFilter<K, Hash>::insert(const K &key) {
+    if (hasVictim) {
+        return false;
+    }
+    uint64_t h = hashOf(key);
+    uint16_t fingerprint = fingerprintOf(h);
+    size_t index = h & mask;
+    size_t other = altIndex(index, fingerprint);
+
+    ++numItems;
+    if (tryPlace(index, fingerprint) || tryPlace(other, fingerprint)) {
+        return true;
+    }
+    if (random & 1) {
+        index = other;
+    }
+    for (int kick = 0; kick < CUCKOO_MAX_KICKS; ++kick) {
+        fingerprint = swapRandomSlot(index, fingerprint);
+        index = altIndex(index, fingerprint);
+        if (tryPlace(index, fingerprint)) {
+            return true;
+        }
+    }
+    victim      = fingerprint;
+    victimIndex = index;
+    hasVictim   = true;
+    return true;
+}
+
+// **Public** //
+// mayContain()
+//
+// False means key is not in the filter.
+template <class K, class Hash>
+bool CuckooFilter<K, Hash>::mayContain(const K &key) const {
+    uint64_t h = hashOf(key);
+    uint16_t fingerprint = fingerprintOf(h);
+    size_t index = h & mask;
+    size_t other = altIndex(index, fingerprint);
+
+    if (hasFingerprint(buckets[index], fingerprint) || hasFingerprint(buckets[other], fingerprint)) {
+        return true;
+    }
+    return hasVictim && victim == fingerprint && (victimIndex == index || victimIndex == other);
+}
+
+// **Public** //
+// erase()
+//
+// Removes one copy of the key's fingerprint. Only erase keys that were
+// inserted: erasing any other key may remove the fingerprint of a key
+// that was, which would then be reported missing.
+template <class K, class Hash>
+bool CuckooFilter<K, Hash>::erase(const K &key) {
+    uint64_t h = hashOf(key);
+    uint16_t fingerprint = fingerprintOf(h);
+    size_t index = h & mask;
+    size_t other = altIndex(index, fingerprint);
+
+    if (hasVictim && victim == fingerprint && (victimIndex == index || victimIndex == other)) {
+        hasVictim = false;
+        --numItems;
+        return true;
+    }
+    if (!tryRemove(index, fingerprint) && !tryRemove(other, fingerprint)) {
+        return false;
+    }
+    --numItems;
+
+    // A slot has opened up; give the victim another chance at a home
+    if (hasVictim && (tryPlace(victimIndex, victim) || tryPlace(altIndex(victimIndex, victim), victim))) {
+        hasVictim = false;
+    }
+    return true;
+}
+
+// **Public** //
+// clear()
+template <class K, class Hash>
+void CuckooFilter<K, Hash>::clear() {
+    buckets.assign(buckets.size(), 0);
+    numItems  = 0;
+    hasVictim = false;
+}
+
+// **Public** //
+// isFull()
+template <class K, class Hash>
+bool CuckooFilter<K, Hash>::isFull() const {
+    return hasVictim;
+}
+
+// **Public** //
+// getNumItems()
+template <class K, class Hash>
+size_t CuckooFilter<K, Hash>::getNumItems() const {
+    return numItems;
+}
+
+// **Public** //
+// getCapacity()
+//
+// Number of slots. Inserts usually start failing once a little over
+// 95% of them are taken.
+template <class K, class Hash>
+size_t CuckooFilter<K, Hash>::getCapacity() const {
+    return buckets.size() * SLOTS;
+}
+
+// **Constructor** //
+//
+// The container is constructed from args and starts out empty.
+template <class Container, class Filter>
+template <class... Args>
+Filtered<Container, Filter>::Filtered(Filter f, Args &&...args)
+    : container(std::forward<Args>(args)...), filter(std::move(f)), bypass{false} {
+}
+
+// **Public** //
+// insert()
+//
+// Inserts item into the container, and its key into the filter if the
+// container did not already hold it. Returns whether the item was
+// added. Should the filter run out of room it is switched off and
+// every lookup goes to the container from then on.
+template <class Container, class Filter>
+template <class Item>
+bool Filtered<Container, Filter>::insert(const Item &item) {
+    const auto &key = filter_detail::keyOf(item);
+    bool added;
+
+    if constexpr (std::is_same<decltype(container.insert(item)), bool>::value) {
+        added = container.insert(item);
+    }
+    else {
+        // AVLTree::insert() does not say whether the item was new
+        added = !contains(key);
+        container.insert(item);
+    }
+    if (added && !bypass && !filter.insert(key)) {
+        bypass = true;
+    }
+    return added;
+}
+
+// **Public** //
+// contains()
+template <class Container, class Filter>
+template <class Key>
+bool Filtered<Container, Filter>::contains(const Key &key) const {
+    if (!bypass && !filter.mayContain(key)) {
+        return false;
+    }
+    return container.contains(key);
+}
+
+// **Public** //
+// erase()
+//
+// Removes key from the container, and from the filter if the filter
+// supports it. A Bloom filter keeps the key's bits set, which costs
+// nothing but a wasted container lookup later on.
+template <class Container, class Filter>
+template <class Key>
+bool Filtered<Container, Filter>::erase(const Key &key) {
+    if (!contains(key)) {
+        return false;
+    }
+    if constexpr (filter_detail::HasErase<Container, Key>::value) {
+        container.erase(key);
+    }
+    else {
+        container.remove(key);
+    }
+    if constexpr (filter_detail::HasErase<Filter, Key>::value) {
+        if (!bypass) {
+            filter.erase(key);
+        }
+    }
+    return true;
+}
+
+// **Public** //
+// clear()
+//
+// Empties both, which also switches a full filter back on.
+template <class Container, class Filter>
+void Filtered<Container, Filter>::clear() {
+    container.clear();
+    filter.clear();
+    bypass = false;
+}
+
+// **Public** //
+// getContainer()
+//
+// Read-only: changes have to go through Filtered to keep the filter
+// in step.
+template <class Container, class Filter>
+const Container &Filtered<Container, Filter>::getContainer() const {
+    return container;
+}
+
+// **Public** //
+// getFilter()
+template <class Container, class Filter>
+const Filter &Filtered<Container, Filter>::getFilter() const {
+    return filter;
+}
+
+#endif /* MembershipFilter.hpp */
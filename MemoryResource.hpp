@@ -0,0 +1,423 @@
+//
+//  MemoryResource.hpp
+//  CustomLibraries
+//
+//  Description
+//
+//  Two std::pmr::memory_resource implementations for the containers in
+//  this library. Every container takes a memory_resource pointer as its
+//  last constructor argument and allocates its nodes or buffers from it
+//  (std::pmr::get_default_resource(), plain new and delete, when none
+//  is given):
+//
+//      MonotonicArena arena;
+//      AVLTree<int> seen(&arena);
+//      ChainingHash<int, int> counts(11, &arena);
+//      ...
+//      // Everything is freed at once when arena goes out of scope
+//
+//  MonotonicArena hands out memory by bumping a pointer through large
+//  chunks and never reuses anything that is deallocated. Freeing is a
+//  no-op; all of the memory goes back in one go on release() or when
+//  the arena is destroyed. It suits structures that are built, used and
+//  thrown away together, such as the ones belonging to one request.
+//
+//  SizeClassPool keeps a free list for each block size up to
+//  POOL_MAX_BLOCK_BYTES, in steps of 8 bytes, carved out of large
+//  slabs. Tree, list and hash table nodes are all well under that
+//  limit, so a container that keeps inserting and removing reuses the
+//  same few slabs instead of going to the general allocator. Bigger
+//  blocks, such as the buffers behind Queue, Stack and the hash
+//  tables, are passed straight to the upstream resource.
+//
+//  Neither resource is thread safe, and both must outlive the
+//  containers using them. Any other memory_resource, such as the ones
+//  in <memory_resource>, works with the containers just as well.
+//
+
+#ifndef MemoryResource_hpp
+#define MemoryResource_hpp
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+// Size of the first chunk a MonotonicArena allocates; each chunk after
+// it is twice the size of the last, up to ARENA_MAX_CHUNK_BYTES
+static const size_t ARENA_CHUNK_BYTES     = size_t(4) << 10;
+static const size_t ARENA_MAX_CHUNK_BYTES = size_t(1) << 20;
+
+// Largest block SizeClassPool keeps a free list for, and the size of
+// the slabs those blocks are carved from
+static const size_t POOL_MAX_BLOCK_BYTES = 512;
+static const size_t POOL_SLAB_BYTES      = size_t(64) << 10;
+
+class MonotonicArena : public std::pmr::memory_resource {
+private:
+    // Header at the start of every chunk taken from upstream
+    struct alignas(std::max_align_t) Chunk {
+        Chunk *next;
+        size_t bytes;
+    };
+
+    std::pmr::memory_resource *upstream;
+    Chunk  *chunks;
+    char   *initialBuffer;
+    size_t  initialBytes;
+    char   *current;            // Next free byte
+    size_t  remaining;          // Bytes left after current
+    size_t  firstChunkBytes;
+    size_t  nextChunkBytes;
+    size_t  bytesAllocated;
+
+    void addChunk(size_t, size_t);
+
+protected:
+    void *do_allocate(size_t, size_t) override;
+    void  do_deallocate(void *, size_t, size_t) override;
+    bool  do_is_equal(const std::pmr::memory_resource &) const noexcept override;
+
+public:
+    // Constructor
+    explicit MonotonicArena(size_t = ARENA_CHUNK_BYTES,
+                            std::pmr::memory_resource * = std::pmr::get_default_resource());
+    MonotonicArena(void *, size_t, std::pmr::memory_resource * = std::pmr::get_default_resource());
+    MonotonicArena(const MonotonicArena &) = delete;
+    MonotonicArena &operator=(const MonotonicArena &) = delete;
+
+    // Destructor
+    ~MonotonicArena() override;
+
+    // Functions
+    void   release();
+    size_t getBytesAllocated() const;
+    std::pmr::memory_resource *getUpstream() const;
+};
+
+class SizeClassPool : public std::pmr::memory_resource {
+private:
+    static constexpr size_t GRANULE     = 8;
+    static constexpr size_t NUM_CLASSES = POOL_MAX_BLOCK_BYTES / GRANULE;
+
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    // Header at the start of every slab
+    struct alignas(std::max_align_t) Slab {
+        Slab *next;
+    };
+
+    // Header in front of every block passed on to upstream, so that
+    // release() can find them
+    struct alignas(std::max_align_t) LargeBlock {
+        LargeBlock *prev;
+        LargeBlock *next;
+        size_t      bytes;
+        size_t      alignment;
+    };
+
+    struct SizeClass {
+        FreeBlock *freeList = nullptr;
+        char      *next     = nullptr;     // Uncarved part of the newest slab
+        char      *end      = nullptr;
+    };
+
+    std::pmr::memory_resource *upstream;
+    SizeClass   classes[NUM_CLASSES];
+    Slab       *slabs;
+    LargeBlock *largeBlocks;
+
+    static size_t largeHeaderBytes(size_t);
+    void *allocateLarge(size_t, size_t);
+    void  deallocateLarge(void *, size_t, size_t);
+    void  addSlab(SizeClass &, size_t);
+
+protected:
+    void *do_allocate(size_t, size_t) override;
+    void  do_deallocate(void *, size_t, size_t) override;
+    bool  do_is_equal(const std::pmr::memory_resource &) const noexcept override;
+
+public:
+    // Constructor
+    explicit SizeClassPool(std::pmr::memory_resource * = std::pmr::get_default_resource());
+    SizeClassPool(const SizeClassPool &) = delete;
+    SizeClassPool &operator=(const SizeClassPool &) = delete;
+
+    // Destructor
+    ~SizeClassPool() override;
+
+    // Functions
+    void release();
+    std::pmr::memory_resource *getUpstream() const;
+};
+
+// **Constructor** //
+//
+// chunkBytes is the size of the first chunk taken from upstream. No
+// memory is allocated until the first request.
+inline MonotonicArena::MonotonicArena(size_t chunkBytes, std::pmr::memory_resource *up)
+    : upstream{up}, chunks{nullptr}, initialBuffer{nullptr}, initialBytes{0},
+      current{nullptr}, remaining{0}, firstChunkBytes{chunkBytes}, bytesAllocated{0} {
+    if (firstChunkBytes < 2 * sizeof(Chunk)) {
+        firstChunkBytes = 2 * sizeof(Chunk);
+    }
+    nextChunkBytes = firstChunkBytes;
+}
+
+// **Constructor** //
+//
+// Serves requests from buffer, which the caller owns (a local array,
+// say), before taking chunks from upstream. The first chunk is twice
+// the size of buffer.
+inline MonotonicArena::MonotonicArena(void *buffer, size_t bytes, std::pmr::memory_resource *up)
+    : MonotonicArena(2 * bytes, up) {
+    initialBuffer = static_cast<char *>(buffer);
+    initialBytes  = bytes;
+    current       = initialBuffer;
+    remaining     = initialBytes;
+}
+
+// **Destructor** //
+inline MonotonicArena::~MonotonicArena() {
+    release();
+}
+
+// **Private** //
+// addChunk()
+//
+// Takes a chunk big enough for bytes at alignment from upstream and
+// makes it the one allocations are bumped through. Whatever was left
+// of the previous chunk is abandoned.
+inline void MonotonicArena::addChunk(size_t bytes, size_t alignment) {
+    size_t needed = sizeof(Chunk) + bytes + alignment;
+    size_t size   = (nextChunkBytes > needed) ? nextChunkBytes : needed;
+
+    Chunk *chunk = static_cast<Chunk *>(upstream->allocate(size, alignof(Chunk)));
+    chunk->next  = chunks;
+    chunk->bytes = size;
+    chunks       = chunk;
+
+    current   = reinterpret_cast<char *>(chunk + 1);
+    remaining = size - sizeof(Chunk);
+    if (nextChunkBytes < ARENA_MAX_CHUNK_BYTES) {
+        nextChunkBytes *= 2;
+    }
+}
+
+// **Protected** //
+// do_allocate()
+inline void *MonotonicArena::do_allocate(size_t bytes, size_t alignment) {
+    size_t padding = -reinterpret_cast<uintptr_t>(current) & (alignment - 1);
+
+    if (current == nullptr || padding + bytes > remaining) {
+        addChunk(bytes, alignment);
+        padding = -reinterpret_cast<uintptr_t>(current) & (alignment - 1);
+    }
+    char *block = current + padding;
+    current         = block + bytes;
+    remaining      -= padding + bytes;
+    bytesAllocated += bytes;
+    return block;
+}
+
+// **Protected** //
+// do_deallocate()
+//
+// Nothing is reused; the memory is only freed by release().
+inline void MonotonicArena::do_deallocate(void *, size_t, size_t) {
+}
+
+// **Protected** //
+// do_is_equal()
+inline bool MonotonicArena::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+    return this == &other;
+}
+
+// **Public** //
+// release()
+//
+// Gives every chunk back to upstream, invalidating everything the
+// arena has handed out, and starts again from the initial buffer.
+inline void MonotonicArena::release() {
+    while (chunks) {
+        Chunk *next = chunks->next;
+        upstream->deallocate(chunks, chunks->bytes, alignof(Chunk));
+        chunks = next;
+    }
+    nextChunkBytes = firstChunkBytes;
+    current        = initialBuffer;
+    remaining      = initialBytes;
+    bytesAllocated = 0;
+}
+
+// **Public** //
+// getBytesAllocated()
+//
+// Bytes handed out since construction or the last release(), not
+// counting alignment padding.
+inline size_t MonotonicArena::getBytesAllocated() const {
+    return bytesAllocated;
+}
+
+// **Public** //
+// getUpstream()
+inline std::pmr::memory_resource *MonotonicArena::getUpstream() const {
+    return upstream;
+}
+
+// **Constructor** //
+inline SizeClassPool::SizeClassPool(std::pmr::memory_resource *up)
+    : upstream{up}, slabs{nullptr}, largeBlocks{nullptr} {
+}
+
+// **Destructor** //
+inline SizeClassPool::~SizeClassPool() {
+    release();
+}
+
+// **Private** //
+// largeHeaderBytes()
+//
+// Room left in front of a large block for its header, keeping the
+// block itself at the alignment asked for.
+inline size_t SizeClassPool::largeHeaderBytes(size_t alignment) {
+    return (alignment > sizeof(LargeBlock)) ? alignment : sizeof(LargeBlock);
+}
+
+// **Private** //
+// allocateLarge()
+inline void *SizeClassPool::allocateLarge(size_t bytes, size_t alignment) {
+    size_t headerBytes = largeHeaderBytes(alignment);
+    size_t baseAlign   = (alignment > alignof(LargeBlock)) ? alignment : alignof(LargeBlock);
+    char  *base = static_cast<char *>(upstream->allocate(headerBytes + bytes, baseAlign));
+
+    LargeBlock *header = reinterpret_cast<LargeBlock *>(base + headerBytes) - 1;
+    header->prev      = nullptr;
+    header->next      = largeBlocks;
+    header->bytes     = bytes;
+    header->alignment = alignment;
+    if (largeBlocks) {
+        largeBlocks->prev = header;
+    }
+    largeBlocks = header;
+    return base + headerBytes;
+}
+
+// **Private** //
+// deallocateLarge()
+inline void SizeClassPool::deallocateLarge(void *block, size_t bytes, size_t alignment) {
+    size_t headerBytes = largeHeaderBytes(alignment);
+    size_t baseAlign   = (alignment > alignof(LargeBlock)) ? alignment : alignof(LargeBlock);
+    LargeBlock *header = static_cast<LargeBlock *>(block) - 1;
+
+    if (header->prev) header->prev->next = header->next;
+    else              largeBlocks = header->next;
+    if (header->next) header->next->prev = header->prev;
+
+    upstream->deallocate(static_cast<char *>(block) - headerBytes, headerBytes + bytes, baseAlign);
+}
+
+// **Private** //
+// addSlab()
+//
+// Takes a new slab from upstream for blocks of blockBytes. Blocks are
+// carved from it as they are needed rather than all at once, so a
+// class that is barely used only touches the start of its slab.
+inline void SizeClassPool::addSlab(SizeClass &sizeClass, size_t blockBytes) {
+    Slab *slab = static_cast<Slab *>(upstream->allocate(POOL_SLAB_BYTES, alignof(Slab)));
+    slab->next = slabs;
+    slabs      = slab;
+
+    char *data = reinterpret_cast<char *>(slab + 1);
+    sizeClass.next = data;
+    sizeClass.end  = data + (POOL_SLAB_BYTES - sizeof(Slab)) / blockBytes * blockBytes;
+}
+
+// **Protected** //
+// do_allocate()
+//
+// Blocks in a class are a multiple of the alignment asked for apart,
+// starting from an aligned slab, so rounding the size up to the
+// alignment is all it takes to keep them aligned.
+inline void *SizeClassPool::do_allocate(size_t bytes, size_t alignment) {
+    size_t unit = (alignment > GRANULE) ? alignment : GRANULE;
+    size_t blockBytes = (bytes + unit - 1) & ~(unit - 1);
+    if (blockBytes == 0) {
+        blockBytes = unit;
+    }
+    if (blockBytes > POOL_MAX_BLOCK_BYTES || alignment > alignof(Slab)) {
+        return allocateLarge(bytes, alignment);
+    }
+
+    SizeClass &sizeClass = classes[blockBytes / GRANULE - 1];
+    if (sizeClass.freeList) {
+        FreeBlock *block = sizeClass.freeList;
+        sizeClass.freeList = block->next;
+        return block;
+    }
+    if (sizeClass.next == sizeClass.end) {
+        addSlab(sizeClass, blockBytes);
+    }
+    void *block = sizeClass.next;
+    sizeClass.next += blockBytes;
+    return block;
+}
+
+// **Protected** //
+// do_deallocate()
+inline void SizeClassPool::do_deallocate(void *block, size_t bytes, size_t alignment) {
+    size_t unit = (alignment > GRANULE) ? alignment : GRANULE;
+    size_t blockBytes = (bytes + unit - 1) & ~(unit - 1);
+    if (blockBytes == 0) {
+        blockBytes = unit;
+    }
+    if (blockBytes > POOL_MAX_BLOCK_BYTES || alignment > alignof(Slab)) {
+        deallocateLarge(block, bytes, alignment);
+        return;
+    }
+
+    SizeClass &sizeClass = classes[blockBytes / GRANULE - 1];
+    FreeBlock *freed = static_cast<FreeBlock *>(block);
+    freed->next = sizeClass.freeList;
+    sizeClass.freeList = freed;
+}
+
+// **Protected** //
+// do_is_equal()
+inline bool SizeClassPool::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+    return this == &other;
+}
+
+// **Public** //
+// release()
+//
+// Gives every slab and large block back to upstream, invalidating
+// everything the pool has handed out.
+inline void SizeClassPool::release() {
+    while (slabs) {
+        Slab *next = slabs->next;
+        upstream->deallocate(slabs, POOL_SLAB_BYTES, alignof(Slab));
+        slabs = next;
+    }
+    while (largeBlocks) {
+        LargeBlock *next = largeBlocks->next;
+        size_t headerBytes = largeHeaderBytes(largeBlocks->alignment);
+        size_t baseAlign   = (largeBlocks->alignment > alignof(LargeBlock))
+                           ? largeBlocks->alignment : alignof(LargeBlock);
+        upstream->deallocate(reinterpret_cast<char *>(largeBlocks + 1) - headerBytes,
+                             headerBytes + largeBlocks->bytes, baseAlign);
+        largeBlocks = next;
+    }
+    for (SizeClass &sizeClass : classes) {
+        sizeClass = SizeClass();
+    }
+}
+
+// **Public** //
+// getUpstream()
+inline std::pmr::memory_resource *SizeClassPool::getUpstream() const {
+    return upstream;
+}
+
+#endif /* MemoryResource.hpp */
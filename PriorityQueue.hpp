@@ -0,0 +1,549 @@
+//
+//  PriorityQueue.hpp
+//  CustomLibraries
+//
+//  Description
+//
+//  Priority queues to sit alongside the FIFO Queue and LIFO Stack.
+//  Unlike std::priority_queue, top() is the item that compares first,
+//  so with the default std::less<T> both heaps are min-heaps, which is
+//  what schedulers and shortest-path searches want.
+//
+//  DaryHeap     An implicit heap in a vector where every node has D
+//               children (4 by default). A wider node means a shallower
+//               tree, and the D children of a node sit next to each
+//               other in memory, so a sift down touches about one cache
+//               line per level. push() returns a handle that can later
+//               be passed to decrease_key(), update() or erase().
+//
+//  PairingHeap  A node-based heap with O(1) push, merge and amortized
+//               o(log n) decrease_key. Better than DaryHeap when the
+//               workload is dominated by decrease_key calls.
+//
+
+#ifndef PriorityQueue_hpp
+#define PriorityQueue_hpp
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+
+// D-ary Heap
+template <class T, size_t D = 4, class Compare = std::less<T>>
+class DaryHeap {
+    static_assert(D >= 2, "DaryHeap needs at least two children per node");
+
+public:
+    typedef size_t handle;
+
+private:
+    static constexpr size_t NPOS = static_cast<size_t>(-1);
+
+    std::vector<T>      values;         // Heap ordered items
+    std::vector<handle> handles;        // handles[i] belongs to values[i]
+    std::vector<size_t> positions;      // positions[h] is the index of h
+    std::vector<handle> freeHandles;
+    Compare comp;
+
+    // Functions
+    handle newHandle();
+    void   place(size_t, T &&, handle);
+    void   siftUp(size_t);
+    void   siftDown(size_t);
+
+public:
+    // Constructor
+    explicit DaryHeap(const Compare & = Compare());
+
+    // Functions
+    handle   push(const T &);
+    handle   push(T &&);
+    void     pop();
+    const T &top() const;
+    void     decrease_key(handle, const T &);
+    void     update(handle, const T &);
+    void     erase(handle);
+    bool     contains(handle) const;
+    const T &get(handle) const;
+    template <class InputIt>
+    void     heapify(InputIt, InputIt);
+    void     reserve(size_t);
+    void     clear();
+    bool     isEmpty() const;
+    size_t   getNumItems() const;
+};
+
+// Constructor
+template <class T, size_t D, class Compare>
+DaryHeap<T, D, Compare>::DaryHeap(const Compare &c) : comp{c} { }
+
+// **Private** //
+// newHandle()
+template <class T, size_t D, class Compare>
+typename DaryHeap<T, D, Compare>::handle DaryHeap<T, D, Compare>::newHandle() {
+    if (!freeHandles.empty()) {
+        handle h = freeHandles.back();
+        freeHandles.pop_back();
+        return h;
+    }
+    positions.push_back(NPOS);
+    return positions.size() - 1;
+}
+
+// **Private** //
+// place()
+template <class T, size_t D, class Compare>
+void DaryHeap<T, D, Compare>::place(size_t index, T &&value, handle h) {
+    values[index]  = std::move(value);
+    handles[index] = h;
+    positions[h]   = index;
+}
+
+// **Private** //
+// siftUp()
+//
+// Moves the item at index towards the root. The item is held aside
+// and parents are shifted down into the hole, so each level costs
+// one move instead of a swap.
+template <class T, size_t D, class Compare>
+void DaryHeap<T, D, Compare>::siftUp(size_t index) {
+    T      value = std::move(values[index]);
+    handle h     = handles[index];
+
+    while (index > 0) {
+        size_t parent = (index - 1) / D;
+        if (!comp(value, values[parent])) {
+            break;
+        }
+        place(index, std::move(values[parent]), handles[parent]);
+        index = parent;
+    }
+    place(index, std::move(value), h);
+}
+
+// **Private** //
+// siftDown()
+template <class T, size_t D, class Compare>
+void DaryHeap<T, D, Compare>::siftDown(size_t index) {
+    size_t n     = values.size();
+    T      value = std::move(values[index]);
+    handle h     = handles[index];
+
+    for (;;) {
+        size_t first = D * index + 1;
+        if (first >= n) {
+            break;
+        }
+        size_t last = (first + D < n) ? first + D : n;
+        size_t best = first;
+        for (size_t c = first + 1; c < last; ++c) {
+            if (comp(values[c], values[best])) {
+                best = c;
+            }
+        }
+        if (!comp(values[best], value)) {
+            break;
+        }
+        place(index, std::move(values[best]), handles[best]);
+        index = best;
+    }
+    place(index, std::move(value), h);
+}
+
+// **Public** //
+// push()
+//
+// Adds an item and returns a handle to it that stays valid until the
+// item is popped or erased.
+template <class T, size_t D, class Compare>
+typename DaryHeap<T, D, Compare>::handle DaryHeap<T, D, Compare>::push(const T &item) {
+    return push(T(item));
+}
+
+template <class T, size_t D, class Compare>
+typename DaryHeap<T, D, Compare>::handle DaryHeap<T, D, Compare>::push(T &&item) {
+    handle h = newHandle();
+    values.push_back(std::move(item));
+    handles.push_back(h);
+    positions[h] = values.size() - 1;
+    siftUp(values.size() - 1);
+    return h;
+}
+
+// **Public** //
+// pop()
+template <class T, size_t D, class Compare>
+void DaryHeap<T, D, Compare>::pop() {
+    erase(handles.front());
+}
+
+// **Public** //
+// top()
+template <class T, size_t D, class Compare>
+const T &DaryHeap<T, D, Compare>::top() const {
+    return values.front();
+}
+
+// **Public** //
+// decrease_key()
+//
+// Replaces the item behind h with one that compares before (or equal
+// to) it, restoring the heap in O(log_D n).
+template <class T, size_t D, class Compare>
+void DaryHeap<T, D, Compare>::decrease_key(handle h, const T &item) {
+    size_t index = positions[h];
+    values[index] = item;
+    siftUp(index);
+}
+
+// **Public** //
+// update()
+//
+// Replaces the item behind h with any new value.
+template <class T, size_t D, class Compare>
+void DaryHeap<T, D, Compare>::update(handle h, const T &item) {
+    size_t index = positions[h];
+    bool   rises = comp(item, values[index]);
+    values[index] = item;
+    if (rises) siftUp(index);
+    else       siftDown(index);
+}
+
+// **Public** //
+// erase()
+template <class T, size_t D, class Compare>
+void DaryHeap<T, D, Compare>::erase(handle h) {
+    size_t index = positions[h];
+    size_t last  = values.size() - 1;
+
+    positions[h] = NPOS;
+    freeHandles.push_back(h);
+
+    if (index != last) {
+        bool rises = comp(values[last], values[index]);
+        place(index, std::move(values[last]), handles[last]);
+        values.pop_back();
+        handles.pop_back();
+        if (rises) siftUp(index);
+        else       siftDown(index);
+    }
+    else {
+        values.pop_back();
+        handles.pop_back();
+    }
+}
+
+// **Public** //
+// contains()
+template <class T, size_t D, class Compare>
+bool DaryHeap<T, D, Compare>::contains(handle h) const {
+    return h < positions.size() && positions[h] != NPOS;
+}
+
+// **Public** //
+// get()
+template <class T, size_t D, class Compare>
+const T &DaryHeap<T, D, Compare>::get(handle h) const {
+    return values[positions[h]];
+}
+
+// **Public** //
+// heapify()
+//
+// Replaces the contents with [first, last) in O(n) using Floyd's
+// bottom-up construction. The i-th item gets handle i.
+template <class T, size_t D, class Compare>
+template <class InputIt>
+void DaryHeap<T, D, Compare>::heapify(InputIt first, InputIt last) {
+    clear();
+    values.assign(first, last);
+
+    size_t n = values.size();
+    handles.resize(n);
+    positions.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        handles[i] = positions[i] = i;
+    }
+    if (n > 1) {
+        for (size_t i = (n - 2) / D + 1; i-- > 0; ) {
+            siftDown(i);
+        }
+    }
+}
+
+// **Public** //
+// reserve()
+template <class T, size_t D, class Compare>
+void DaryHeap<T, D, Compare>::reserve(size_t n) {
+    values.reserve(n);
+    handles.reserve(n);
+    positions.reserve(n);
+}
+
+// **Public** //
+// clear()
+template <class T, size_t D, class Compare>
+void DaryHeap<T, D, Compare>::clear() {
+    values.clear();
+    handles.clear();
+    positions.clear();
+    freeHandles.clear();
+}
+
+// **Public** //
+// isEmpty()
+template <class T, size_t D, class Compare>
+bool DaryHeap<T, D, Compare>::isEmpty() const {
+    return values.empty();
+}
+
+// **Public** //
+// getNumItems()
+template <class T, size_t D, class Compare>
+size_t DaryHeap<T, D, Compare>::getNumItems() const {
+    return values.size();
+}
+
+
+// Pairing Heap
+template <class T, class Compare = std::less<T>>
+class PairingHeap {
+private:
+    struct Node {
+        T data;
+        Node *child;    // Leftmost child
+        Node *sibling;  // Next sibling to the right
+        Node *prev;     // Left sibling, or the parent for a leftmost child
+
+        template <class U>
+        explicit Node(U &&d)
+            : data{std::forward<U>(d)}, child{nullptr}, sibling{nullptr}, prev{nullptr} {}
+    };
+
+    Node  *root;
+    size_t numItems;
+    Compare comp;
+    std::vector<Node *> pairs;  // Scratch space reused by pop()
+
+    // Functions
+    Node *meld(Node *, Node *);
+    void  cut(Node *);
+    void  destroy(Node *);
+
+public:
+    typedef Node *handle;
+
+    // Constructor
+    explicit PairingHeap(const Compare & = Compare());
+    PairingHeap(const PairingHeap &) = delete;
+    PairingHeap &operator=(const PairingHeap &) = delete;
+    PairingHeap(PairingHeap &&) noexcept;
+
+    // Destructor
+    ~PairingHeap();
+
+    // Functions
+    handle   push(const T &);
+    handle   push(T &&);
+    void     pop();
+    const T &top() const;
+    void     decrease_key(handle, const T &);
+    void     merge(PairingHeap &);
+    void     clear();
+    bool     isEmpty() const;
+    size_t   getNumItems() const;
+};
+
+// Constructor
+template <class T, class Compare>
+PairingHeap<T, Compare>::PairingHeap(const Compare &c)
+    : root{nullptr}, numItems{0}, comp{c} { }
+
+template <class T, class Compare>
+PairingHeap<T, Compare>::PairingHeap(PairingHeap &&other) noexcept
+    : root{other.root}, numItems{other.numItems}, comp{std::move(other.comp)} {
+    other.root = nullptr;
+    other.numItems = 0;
+}
+
+// Destructor
+template <class T, class Compare>
+PairingHeap<T, Compare>::~PairingHeap() {
+    clear();
+}
+
+// **Private** //
+// meld()
+//
+// Links two heap-ordered trees, making the loser the leftmost child
+// of the winner. Both roots must have no siblings.
+template <class T, class Compare>
+typename PairingHeap<T, Compare>::Node *PairingHeap<T, Compare>::meld(Node *a, Node *b) {
+    if (a == nullptr) return b;
+    if (b == nullptr) return a;
+    if (comp(b->data, a->data)) {
+        std::swap(a, b);
+    }
+    b->prev    = a;
+    b->sibling = a->child;
+    if (a->child) {
+        a->child->prev = b;
+    }
+    a->child = b;
+    return a;
+}
+
+// **Private** //
+// cut()
+//
+// Detaches a non-root node (and its subtree) from its parent.
+template <class T, class Compare>
+void PairingHeap<T, Compare>::cut(Node *n) {
+    if (n->prev->child == n) {
+        n->prev->child = n->sibling;
+    }
+    else {
+        n->prev->sibling = n->sibling;
+    }
+    if (n->sibling) {
+        n->sibling->prev = n->prev;
+    }
+    n->sibling = n->prev = nullptr;
+}
+
+// **Private** //
+// destroy()
+//
+// Frees a whole tree without recursion by splicing each node's
+// children into the sibling list being walked.
+template <class T, class Compare>
+void PairingHeap<T, Compare>::destroy(Node *n) {
+    while (n) {
+        if (n->child) {
+            Node *last = n->child;
+            while (last->sibling) {
+                last = last->sibling;
+            }
+            last->sibling = n->sibling;
+            n->sibling = n->child;
+        }
+        Node *next = n->sibling;
+        delete n;
+        n = next;
+    }
+}
+
+// **Public** //
+// push()
+template <class T, class Compare>
+typename PairingHeap<T, Compare>::handle PairingHeap<T, Compare>::push(const T &item) {
+    Node *n = new Node(item);
+    root = meld(root, n);
+    ++numItems;
+    return n;
+}
+
+template <class T, class Compare>
+typename PairingHeap<T, Compare>::handle PairingHeap<T, Compare>::push(T &&item) {
+    Node *n = new Node(std::move(item));
+    root = meld(root, n);
+    ++numItems;
+    return n;
+}
+
+// **Public** //
+// pop()
+//
+// Removes the root and combines its children with the standard two
+// pass pairing: meld neighbours left to right, then fold the results
+// together right to left.
+template <class T, class Compare>
+void PairingHeap<T, Compare>::pop() {
+    Node *old = root;
+    Node *n   = root->child;
+
+    pairs.clear();
+    while (n) {
+        Node *a = n;
+        Node *b = a->sibling;
+        n = b ? b->sibling : nullptr;
+
+        a->sibling = a->prev = nullptr;
+        if (b) {
+            b->sibling = b->prev = nullptr;
+        }
+        pairs.push_back(meld(a, b));
+    }
+
+    root = nullptr;
+    for (size_t i = pairs.size(); i-- > 0; ) {
+        root = meld(pairs[i], root);
+    }
+    delete old;
+    --numItems;
+}
+
+// **Public** //
+// top()
+template <class T, class Compare>
+const T &PairingHeap<T, Compare>::top() const {
+    return root->data;
+}
+
+// **Public** //
+// decrease_key()
+//
+// Replaces the item behind h with one that compares before (or equal
+// to) it. The node is cut from its parent and melded with the root.
+template <class T, class Compare>
+void PairingHeap<T, Compare>::decrease_key(handle h, const T &item) {
+    h->data = item;
+    if (h != root) {
+        cut(h);
+        root = meld(root, h);
+    }
+}
+
+// **Public** //
+// merge()
+//
+// Moves every item of other into this heap in O(1). Handles from
+// other stay valid and now belong to this heap.
+template <class T, class Compare>
+void PairingHeap<T, Compare>::merge(PairingHeap &other) {
+    if (this == &other) {
+        return;
+    }
+    root = meld(root, other.root);
+    numItems += other.numItems;
+    other.root = nullptr;
+    other.numItems = 0;
+}
+
+// **Public** //
+// clear()
+template <class T, class Compare>
+void PairingHeap<T, Compare>::clear() {
+    destroy(root);
+    root = nullptr;
+    numItems = 0;
+}
+
+// **Public** //
+// isEmpty()
+template <class T, class Compare>
+bool PairingHeap<T, Compare>::isEmpty() const {
+    return root == nullptr;
+}
+
+// **Public** //
+// getNumItems()
+template <class T, class Compare>
+size_t PairingHeap<T, Compare>::getNumItems() const {
+    return numItems;
+}
+
+#endif /* PriorityQueue.hpp */
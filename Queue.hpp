@@ -12,58 +12,249 @@
 //  and rear data from the queue, which is separate from the dequeue
 //  and enqueue operations.
 //
+//  The data is stored in a contiguous ring buffer whose capacity is
+//  always a power of two, so advancing the front and rear is a mask
+//  instead of a modulo and no memory is allocated per element. The
+//  size passed to the constructor is the most items the queue will
+//  hold. A growable queue instead doubles its buffer once it is full.
+//
+//  The buffer comes from the memory resource given to the constructor.
+//  A queue keeps its resource for life: assigning to it copies or moves
+//  the items into its own buffer unless both queues share a resource.
+//
 
 #ifndef Queue_hpp
 #define Queue_hpp
 
-#include <iostream>
+#include <climits>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "Serialization.hpp"
 
 template <class T>
 class Queue {
 private:
-    struct QueueNode {
-        T data;
-        QueueNode *next;
-    };
+    T      *buffer;
+    size_t  capacity;   // Slots in buffer, always a power of two
+    size_t  mask;       // capacity - 1
+    size_t  head;       // Index of the front, unwrapped
+    size_t  tail;       // Index one past the rear, unwrapped
+    int     numItems;
+    int     size;
+    bool    growable;
 
-    QueueNode *front;
-    QueueNode *rear;
-    int numItems;
-    int size;
+    std::pmr::polymorphic_allocator<T> alloc;
+
+    // Functions
+    static size_t roundUpCapacity(size_t);
+    T   *slot(size_t) const;
+    void reallocate(size_t);
+    bool reserveSlot();
+    void load(BinaryReader &);
 
 public:
     // Constructor
-    Queue(int=10);
+    Queue(int=10, bool=false, std::pmr::memory_resource * = std::pmr::get_default_resource());
+    Queue(const Queue &, std::pmr::memory_resource * = std::pmr::get_default_resource());
+    Queue(Queue &&) noexcept;
 
     // Destructor
     ~Queue();
 
+    // Operators
+    Queue &operator=(const Queue &);
+    Queue &operator=(Queue &&);
+
     // Functions
-    void enqueue(T);
-    void dequeue();
+    bool enqueue(const T &);
+    bool enqueue(T &&);
+    template <class... Args>
+    bool emplace(Args &&...);
+    bool dequeue();
     bool isEmpty() const;
     bool isFull() const;
     void clear();
+    void swap(Queue &);
+
+    // Serialization
+    void serialize(std::ostream &) const;
+    void deserialize(std::istream &);
+    void deserialize(const MappedFile &);
 
-    int getSize();
-    int getNumItems();
-    T   getFront();
-    T   getRear();
+    // Status Functions
+    bool   try_enqueue(const T &);
+    bool   try_enqueue(T &&);
+    bool   try_dequeue(T &);
+    size_t enqueue_bulk(const T *, size_t);
+    size_t dequeue_bulk(T *, size_t);
+
+    int getSize() const;
+    int getNumItems() const;
+    std::pmr::memory_resource *getResource() const;
+    T       &getFront();
+    const T &getFront() const;
+    T       &getRear();
+    const T &getRear() const;
 };
 
 // Constructor
+//
+// s is the number of items the queue may hold. If growable is set,
+// s is only the starting capacity and the queue never reports full.
+// The buffer is allocated from resource, which must outlive the queue.
 template <class T>
-Queue<T>::Queue(int s) {
-    size        = s;
+Queue<T>::Queue(int s, bool grow, std::pmr::memory_resource *resource) : alloc{resource} {
+    size        = (s > 0) ? s : 1;
     numItems    = 0;
-    front       = nullptr;
-    rear        = nullptr;
+    head        = 0;
+    tail        = 0;
+    growable    = grow;
+    capacity    = roundUpCapacity(size);
+    mask        = capacity - 1;
+    buffer      = alloc.allocate(capacity);
+}
+
+// Copy Constructor
+template <class T>
+Queue<T>::Queue(const Queue &other, std::pmr::memory_resource *resource)
+    : Queue(other.size, other.growable, resource) {
+    if (other.capacity > capacity) {
+        reallocate(other.capacity);
+    }
+    for (size_t i = other.head; i != other.tail; ++i) {
+        enqueue(*other.slot(i));
+    }
+}
+
+// Move Constructor
+//
+// Takes the buffer of other along with its memory resource. other
+// keeps its size and growable setting and is left empty, without a
+// buffer until its next enqueue.
+template <class T>
+Queue<T>::Queue(Queue &&other) noexcept
+    : buffer{other.buffer}, capacity{other.capacity}, mask{other.mask},
+      head{other.head}, tail{other.tail}, numItems{other.numItems},
+      size{other.size}, growable{other.growable}, alloc{other.alloc} {
+    other.buffer   = nullptr;
+    other.capacity = 0;
+    other.mask     = 0;
+    other.head     = other.tail = 0;
+    other.numItems = 0;
 }
 
 // Destructor
 template <class T>
 Queue<T>::~Queue() {
-    clear();
+    if (buffer) {
+        clear();
+        alloc.deallocate(buffer, capacity);
+    }
+}
+
+// Copy Assignment
+template <class T>
+Queue<T> &Queue<T>::operator=(const Queue &other) {
+    if (this != &other) {
+        Queue copy(other, getResource());
+        swap(copy);
+    }
+    return *this;
+}
+
+// Move Assignment
+//
+// The buffer of other is only taken over if it comes from the same
+// memory resource; otherwise the items are moved across one by one.
+template <class T>
+Queue<T> &Queue<T>::operator=(Queue &&other) {
+    if (this == &other) {
+        return *this;
+    }
+    if (alloc == other.alloc) {
+        Queue moved(std::move(other));
+        swap(moved);
+        return *this;
+    }
+    Queue moved(other.size, other.growable, getResource());
+    if (moved.capacity < other.capacity) {
+        moved.reallocate(other.capacity);
+    }
+    for (size_t i = other.head; i != other.tail; ++i) {
+        moved.emplace(std::move(*other.slot(i)));
+    }
+    other.clear();
+    swap(moved);
+    return *this;
+}
+
+// **Private** //
+// roundUpCapacity()
+template <class T>
+size_t Queue<T>::roundUpCapacity(size_t n) {
+    size_t c = 1;
+    while (c < n) {
+        c <<= 1;
+    }
+    return c;
+}
+
+// **Private** //
+// slot()
+template <class T>
+T *Queue<T>::slot(size_t index) const {
+    return buffer + (index & mask);
+}
+
+// **Private** //
+// reallocate()
+//
+// Moves the items into a new buffer of newCapacity slots, with the
+// front of the queue landing at index 0. Also gives a moved-from
+// queue, which has no buffer, a new one.
+template <class T>
+void Queue<T>::reallocate(size_t newCapacity) {
+    T *newBuffer = alloc.allocate(newCapacity);
+    size_t count = tail - head;
+
+    for (size_t i = 0; i < count; ++i) {
+        T *old = slot(head + i);
+        ::new (static_cast<void *>(newBuffer + i)) T(std::move(*old));
+        old->~T();
+    }
+    if (buffer) {
+        alloc.deallocate(buffer, capacity);
+    }
+
+    buffer   = newBuffer;
+    capacity = newCapacity;
+    mask     = capacity - 1;
+    head     = 0;
+    tail     = count;
+}
+
+// **Private** //
+// reserveSlot()
+//
+// Makes sure there is room for one more item, growing the buffer
+// if the queue allows it. Returns false if the queue is full.
+template <class T>
+bool Queue<T>::reserveSlot() {
+    if (buffer == nullptr && (growable || !isFull())) {
+        reallocate(roundUpCapacity(size));
+    }
+    if (growable) {
+        if (tail - head == capacity) {
+            reallocate(capacity << 1);
+        }
+        return true;
+    }
+    return !isFull();
 }
 
 // **Public** //
@@ -77,76 +268,176 @@ bool Queue<T>::isEmpty() const {
 // isFull()
 template <class T>
 bool Queue<T>::isFull() const {
-    return (numItems >= size);
+    return !growable && (numItems >= size);
 }
 
 // **Public** //
 // getSize()
 template <class T>
-int Queue<T>::getSize() {
+int Queue<T>::getSize() const {
     return size;
 }
 
 // **Public** //
 // getNumItems()
 template <class T>
-int Queue<T>::getNumItems() {
+int Queue<T>::getNumItems() const {
     return numItems;
 }
 
+// **Public** //
+// getResource()
+template <class T>
+std::pmr::memory_resource *Queue<T>::getResource() const {
+    return alloc.resource();
+}
+
 // **Public** //
 // front()
 template <class T>
-T Queue<T>::getFront() {
-    return front->data;
+T &Queue<T>::getFront() {
+    return *slot(head);
+}
+
+template <class T>
+const T &Queue<T>::getFront() const {
+    return *slot(head);
 }
 
 // **Public** //
 // rear()
 template <class T>
-T Queue<T>::getRear() {
-    return rear->data;
+T &Queue<T>::getRear() {
+    return *slot(tail - 1);
+}
+
+template <class T>
+const T &Queue<T>::getRear() const {
+    return *slot(tail - 1);
 }
 
 // **Public** //
 // enqueue()
+//
+// Returns false, leaving the queue unchanged, when it is full.
 template <class T>
-void Queue<T>::enqueue(T newData) {
-    QueueNode *newNode = nullptr;
-    newNode = new QueueNode;
+bool Queue<T>::enqueue(const T &newData) {
+    return emplace(newData);
+}
 
-    newNode->data = newData;
-    newNode->next = nullptr;
+template <class T>
+bool Queue<T>::enqueue(T &&newData) {
+    return emplace(std::move(newData));
+}
 
-    if (isEmpty()) {
-        front = rear = newNode;
-    }
-    else if (isFull()) {
-        std::cout << "Queue is full. Cannot add data." << std::endl;
-        delete newNode;
-    }
-    else {
-        rear->next = newNode;
-        rear = newNode;
+// **Public** //
+// emplace()
+//
+// Constructs the new rear item in place from args.
+template <class T>
+template <class... Args>
+bool Queue<T>::emplace(Args &&...args) {
+    if (!reserveSlot()) {
+        return false;
     }
+    ::new (static_cast<void *>(slot(tail))) T(std::forward<Args>(args)...);
+    ++tail;
     ++numItems;
+    return true;
 }
 
 // **Public** //
 // dequeue()
+//
+// Returns false when there is nothing to remove.
 template <class T>
-void Queue<T>::dequeue() {
-    QueueNode *temp = nullptr;
+bool Queue<T>::dequeue() {
+    if (isEmpty()) {
+        return false;
+    }
+    slot(head)->~T();
+    ++head;
+    --numItems;
+    return true;
+}
+
+// **Public** //
+// try_enqueue()
+template <class T>
+bool Queue<T>::try_enqueue(const T &newData) {
+    return emplace(newData);
+}
+
+template <class T>
+bool Queue<T>::try_enqueue(T &&newData) {
+    return emplace(std::move(newData));
+}
 
+// **Public** //
+// try_dequeue()
+//
+// Moves the front item into out and removes it. Returns false, and
+// leaves out untouched, when the queue is empty.
+template <class T>
+bool Queue<T>::try_dequeue(T &out) {
     if (isEmpty()) {
-        std::cout << "Queue is empty. Nothing to grab" << std::endl;
+        return false;
+    }
+    out = std::move(*slot(head));
+    return dequeue();
+}
+
+// **Public** //
+// enqueue_bulk()
+//
+// Copies up to count items from data onto the rear of the queue and
+// returns how many were added.
+template <class T>
+size_t Queue<T>::enqueue_bulk(const T *data, size_t count) {
+    size_t room = count;
+
+    if (buffer == nullptr) {
+        reallocate(roundUpCapacity(size));
+    }
+
+    if (growable) {
+        size_t needed = tail - head + count;
+        if (needed > capacity) {
+            reallocate(roundUpCapacity(needed));
+        }
     }
-    else {
-        temp = front;
-        front = front->next;
-        delete temp;
-        --numItems;
+    else if (static_cast<size_t>(size - numItems) < room) {
+        room = size - numItems;
     }
+
+    for (size_t i = 0; i < room; ++i) {
+        ::new (static_cast<void *>(slot(tail + i))) T(data[i]);
+    }
+    tail     += room;
+    numItems += static_cast<int>(room);
+    return room;
+}
+
+// **Public** //
+// dequeue_bulk()
+//
+// Moves up to count items from the front of the queue into out and
+// returns how many were removed.
+template <class T>
+size_t Queue<T>::dequeue_bulk(T *out, size_t count) {
+    size_t available = tail - head;
+    if (available < count) {
+        count = available;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        T *item = slot(head + i);
+        out[i] = std::move(*item);
+        item->~T();
+    }
+    head     += count;
+    numItems -= static_cast<int>(count);
+    return count;
 }
 
 // **Public** //
@@ -156,7 +447,84 @@ void Queue<T>::clear() {
     while (!isEmpty()) {
         dequeue();
     }
-    std::cout << "Queue is cleared." << std::endl;
+    head = tail = 0;
+}
+
+// **Public** //
+// swap()
+//
+// Each queue keeps its memory resource. Queues on the same resource
+// swap buffers; otherwise the items are moved across one by one,
+// which allocates.
+template <class T>
+void Queue<T>::swap(Queue &other) {
+    if (alloc != other.alloc) {
+        Queue mine(std::move(*this));
+        *this = std::move(other);
+        other = std::move(mine);
+        return;
+    }
+    std::swap(buffer,   other.buffer);
+    std::swap(capacity, other.capacity);
+    std::swap(mask,     other.mask);
+    std::swap(head,     other.head);
+    std::swap(tail,     other.tail);
+    std::swap(numItems, other.numItems);
+    std::swap(size,     other.size);
+    std::swap(growable, other.growable);
+}
+
+// **Private** //
+// load()
+//
+// Replaces the queue, size and growable setting included, with the
+// one stored in reader, once all of it has been read and checked.
+template <class T>
+void Queue<T>::load(BinaryReader &reader) {
+    std::vector<T> items;
+    SerializedHeader header = readSerialized<T>(reader, SerializedKind::QUEUE,
+                                                [&](T &&item) { items.push_back(std::move(item)); });
+    bool grow = (header.flags & 1) != 0;
+    if (header.capacity == 0 || header.capacity > INT_MAX || (!grow && items.size() > header.capacity)) {
+        throw std::runtime_error("deserialize: queue size is invalid");
+    }
+
+    Queue loaded(static_cast<int>(header.capacity), grow, getResource());
+    if (loaded.capacity < items.size()) {
+        loaded.reallocate(roundUpCapacity(items.size()));
+    }
+    for (T &item : items) {
+        loaded.emplace(std::move(item));
+    }
+    swap(loaded);
+}
+
+// **Public** //
+// serialize()
+//
+// Writes the items front to rear (see Serialization.hpp).
+template <class T>
+void Queue<T>::serialize(std::ostream &output) const {
+    writeSerialized<T>(output, SerializedKind::QUEUE, tail - head, growable ? 1 : 0, size,
+                       [&](auto &&writeItem) {
+                           for (size_t i = head; i != tail; ++i) {
+                               writeItem(*slot(i));
+                           }
+                       });
+}
+
+// **Public** //
+// deserialize()
+template <class T>
+void Queue<T>::deserialize(std::istream &input) {
+    BinaryReader reader(input);
+    load(reader);
+}
+
+template <class T>
+void Queue<T>::deserialize(const MappedFile &file) {
+    BinaryReader reader(file.data(), file.size());
+    load(reader);
 }
 
 #endif /* Queue.hpp */
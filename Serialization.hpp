@@ -0,0 +1,604 @@
+//
+//  Serialization.hpp
+//  CustomLibraries
+//
+//  Description
+//
+//  The binary format the containers save themselves in with
+//  serialize(std::ostream &) and load with deserialize(). A file is a
+//  32 byte header, the elements, and an 8 byte checksum:
+//
+//      offset  size  field
+//      0       4     magic "CLSZ"
+//      4       2     format version (SERIALIZATION_VERSION)
+//      6       2     container kind (SerializedKind)
+//      8       2     size of each element, 0 if elements vary in size
+//      10      2     element type (SerializedType)
+//      12      4     container flags (growable, bounded, ...)
+//      16      8     number of elements
+//      24      8     container capacity (queue size, bucket count, ...)
+//      32      ...   elements
+//      end-8   8     FNV-1a 64 of everything before it
+//
+//  Every integer is little-endian. Elements are written by
+//  Serializer<T>, which handles integers, floating point numbers,
+//  enums, std::string and std::pair out of the box; specialize it for
+//  your own types.
+//
+//  Trees are written in sorted order, so they load in O(n) with no
+//  rebalancing, and a file of plain numbers can be searched in place.
+//  MappedView<T> maps such a file with mmap and looks at the elements
+//  where they sit in the page cache, without copying them:
+//
+//      MappedView<uint64_t> ids("ids.bin");
+//      bool found = std::binary_search(ids.begin(), ids.end(), id);
+//
+//  The element type is recorded as unsigned, signed or floating point
+//  (for both halves of a pair), so a file of ints does not load as
+//  floats of the same size.
+//
+//  Bad magic, the wrong kind or version, a mismatched element type, a
+//  truncated file and a checksum mismatch all throw std::runtime_error.
+//
+
+#ifndef Serialization_hpp
+#define Serialization_hpp
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const uint16_t SERIALIZATION_VERSION = 1;
+
+enum class SerializedKind : uint16_t {
+    AVL_TREE           = 1,
+    BINARY_SEARCH_TREE = 2,
+    CHAINING_HASH      = 3,
+    PROBING_HASH       = 4,
+    QUEUE              = 5,
+    STACK              = 6
+};
+
+// What kind of value an element is. A pair stores PAIR plus the types
+// of its halves, first << 4 | second. Types Serializer gives no tag
+// to are OTHER.
+enum class SerializedType : uint16_t {
+    OTHER    = 0,
+    UNSIGNED = 1,
+    SIGNED   = 2,
+    FLOATING = 3,
+    STRING   = 4,
+    PAIR     = 0x100
+};
+
+struct SerializedHeader {
+    uint16_t       version;
+    SerializedKind kind;
+    uint32_t       elementSize;
+    SerializedType elementType;
+    uint32_t       flags;
+    uint64_t       count;
+    uint64_t       capacity;
+
+    static constexpr size_t BYTES        = 32;
+    static constexpr size_t FOOTER_BYTES = 8;
+};
+
+namespace serialization_detail {
+
+    static const uint64_t FNV_OFFSET = 14695981039346656037ull;
+    static const uint64_t FNV_PRIME  = 1099511628211ull;
+
+    inline uint64_t fnv1a(uint64_t hash, const unsigned char *data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ data[i]) * FNV_PRIME;
+        }
+        return hash;
+    }
+
+    inline bool isLittleEndianHost() {
+        const uint16_t probe = 1;
+        unsigned char first;
+        std::memcpy(&first, &probe, 1);
+        return first == 1;
+    }
+
+    [[noreturn]] inline void fail(const std::string &what) {
+        throw std::runtime_error("deserialize: " + what);
+    }
+
+} // namespace serialization_detail
+
+//**BINARY WRITER**//
+/* *
+ *  Description: Buffers bytes on their way to an ostream and keeps the
+ *               running checksum. finish() writes the checksum.
+ */
+class BinaryWriter {
+private:
+    std::ostream     &output;
+    std::vector<char> buffer;
+    size_t            used;
+    uint64_t          hash;
+
+    void flush();
+
+public:
+    // Constructor
+    explicit BinaryWriter(std::ostream &out) : output(out), buffer(1 << 16), used{0},
+                                               hash{serialization_detail::FNV_OFFSET} { }
+    BinaryWriter(const BinaryWriter &) = delete;
+    BinaryWriter &operator=(const BinaryWriter &) = delete;
+
+    // Functions
+    void write(const void *, size_t);
+    template <class U>
+    void writeLittle(U);
+    void finish();
+};
+
+// **Private** //
+// flush()
+inline void BinaryWriter::flush() {
+    hash = serialization_detail::fnv1a(hash, reinterpret_cast<const unsigned char *>(buffer.data()), used);
+    output.write(buffer.data(), static_cast<std::streamsize>(used));
+    used = 0;
+    if (!output) {
+        throw std::runtime_error("serialize: write failed");
+    }
+}
+
+// **Public** //
+// write()
+inline void BinaryWriter::write(const void *data, size_t size) {
+    const char *bytes = static_cast<const char *>(data);
+    while (size > 0) {
+        if (used == buffer.size()) {
+            flush();
+        }
+        size_t chunk = std::min(size, buffer.size() - used);
+        std::memcpy(buffer.data() + used, bytes, chunk);
+        used  += chunk;
+        bytes += chunk;
+        size  -= chunk;
+    }
+}
+
+// **Public** //
+// writeLittle()
+//
+// Writes an unsigned integer least significant byte first.
+template <class U>
+void BinaryWriter::writeLittle(U value) {
+    static_assert(std::is_unsigned<U>::value, "writeLittle takes unsigned integers");
+    unsigned char bytes[sizeof(U)];
+    for (size_t i = 0; i < sizeof(U); ++i) {
+        bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+    write(bytes, sizeof(U));
+}
+
+// **Public** //
+// finish()
+//
+// Flushes what is buffered and appends the checksum.
+inline void BinaryWriter::finish() {
+    flush();
+    unsigned char bytes[SerializedHeader::FOOTER_BYTES];
+    for (size_t i = 0; i < sizeof(bytes); ++i) {
+        bytes[i] = static_cast<unsigned char>(hash >> (8 * i));
+    }
+    output.write(reinterpret_cast<const char *>(bytes), sizeof(bytes));
+    if (!output) {
+        throw std::runtime_error("serialize: write failed");
+    }
+}
+
+//**BINARY READER**//
+/* *
+ *  Description: Reads bytes from an istream or from a block of memory,
+ *               keeping the running checksum. Throws if the input ends
+ *               early. A stream is read through its own streambuf, and
+ *               never past the end of the container, so several can be
+ *               stored one after another.
+ */
+class BinaryReader {
+private:
+    std::streambuf *input;
+    const char     *position, *end;
+    uint64_t        hash;
+
+public:
+    // Constructor
+    explicit BinaryReader(std::istream &in) : input{in.rdbuf()}, position{nullptr}, end{nullptr},
+                                              hash{serialization_detail::FNV_OFFSET} { }
+    BinaryReader(const void *data, size_t size)
+        : input{nullptr}, position{static_cast<const char *>(data)}, end{position + size},
+          hash{serialization_detail::FNV_OFFSET} { }
+    BinaryReader(const BinaryReader &) = delete;
+    BinaryReader &operator=(const BinaryReader &) = delete;
+
+    // Functions
+    void read(void *, size_t);
+    template <class U>
+    U readLittle();
+    void checkFooter();
+};
+
+// **Public** //
+// read()
+inline void BinaryReader::read(void *data, size_t size) {
+    if (input) {
+        if (static_cast<size_t>(input->sgetn(static_cast<char *>(data), static_cast<std::streamsize>(size))) != size) {
+            serialization_detail::fail("unexpected end of data");
+        }
+    }
+    else {
+        if (static_cast<size_t>(end - position) < size) {
+            serialization_detail::fail("unexpected end of data");
+        }
+        std::memcpy(data, position, size);
+        position += size;
+    }
+    hash = serialization_detail::fnv1a(hash, static_cast<const unsigned char *>(data), size);
+}
+
+// **Public** //
+// readLittle()
+template <class U>
+U BinaryReader::readLittle() {
+    static_assert(std::is_unsigned<U>::value, "readLittle takes unsigned integers");
+    unsigned char bytes[sizeof(U)];
+    read(bytes, sizeof(U));
+    U value = 0;
+    for (size_t i = 0; i < sizeof(U); ++i) {
+        value |= static_cast<U>(static_cast<U>(bytes[i]) << (8 * i));
+    }
+    return value;
+}
+
+// **Public** //
+// checkFooter()
+//
+// Reads the stored checksum and compares it with what was read.
+inline void BinaryReader::checkFooter() {
+    uint64_t expected = hash;
+    if (readLittle<uint64_t>() != expected) {
+        serialization_detail::fail("checksum mismatch");
+    }
+}
+
+namespace serialization_detail {
+
+    // Reads the header and checks the magic and format version
+    inline SerializedHeader readHeader(BinaryReader &reader) {
+        char magic[4];
+        reader.read(magic, 4);
+        if (std::memcmp(magic, "CLSZ", 4) != 0) {
+            fail("not a serialized container");
+        }
+        SerializedHeader header;
+        header.version = reader.readLittle<uint16_t>();
+        if (header.version != SERIALIZATION_VERSION) {
+            fail("unsupported format version " + std::to_string(header.version));
+        }
+        header.kind        = static_cast<SerializedKind>(reader.readLittle<uint16_t>());
+        header.elementSize = reader.readLittle<uint16_t>();
+        header.elementType = static_cast<SerializedType>(reader.readLittle<uint16_t>());
+        header.flags       = reader.readLittle<uint32_t>();
+        header.count       = reader.readLittle<uint64_t>();
+        header.capacity    = reader.readLittle<uint64_t>();
+        return header;
+    }
+
+} // namespace serialization_detail
+
+//**SERIALIZER**//
+/* *
+ *  Description: How one element is written and read. FIXED_SIZE is the
+ *               encoded size in bytes, or 0 if it varies. TYPE, where
+ *               given, is recorded in the header and checked on load.
+ */
+template <class T, class Enable = void>
+struct Serializer;
+
+namespace serialization_detail {
+
+    template <class T, class Enable = void>
+    struct SerializedTypeOf {
+        static constexpr SerializedType value = SerializedType::OTHER;
+    };
+
+    template <class T>
+    struct SerializedTypeOf<T, decltype(void(Serializer<T>::TYPE))> {
+        static constexpr SerializedType value = Serializer<T>::TYPE;
+    };
+
+    template <class T>
+    constexpr SerializedType scalarType() {
+        if constexpr (std::is_enum<T>::value) {
+            return scalarType<typename std::underlying_type<T>::type>();
+        }
+        else if constexpr (std::is_floating_point<T>::value) {
+            return SerializedType::FLOATING;
+        }
+        else {
+            return std::is_signed<T>::value ? SerializedType::SIGNED : SerializedType::UNSIGNED;
+        }
+    }
+
+} // namespace serialization_detail
+
+// Integers, floating point numbers and enums: their bytes, little-endian
+template <class T>
+struct Serializer<T, typename std::enable_if<std::is_arithmetic<T>::value || std::is_enum<T>::value>::type> {
+    typedef typename std::conditional<sizeof(T) == 1, uint8_t,
+            typename std::conditional<sizeof(T) == 2, uint16_t,
+            typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type>::type>::type Bits;
+    static_assert(sizeof(T) == sizeof(Bits), "unsupported arithmetic type size");
+
+    static constexpr size_t         FIXED_SIZE = sizeof(T);
+    static constexpr SerializedType TYPE       = serialization_detail::scalarType<T>();
+
+    static void write(BinaryWriter &writer, const T &value) {
+        Bits bits;
+        std::memcpy(&bits, &value, sizeof(T));
+        writer.writeLittle(bits);
+    }
+    static void read(BinaryReader &reader, T &value) {
+        Bits bits = reader.template readLittle<Bits>();
+        std::memcpy(&value, &bits, sizeof(T));
+    }
+};
+
+// std::string: 64 bit length, then the characters
+template <>
+struct Serializer<std::string> {
+    static constexpr size_t         FIXED_SIZE = 0;
+    static constexpr SerializedType TYPE       = SerializedType::STRING;
+
+    static void write(BinaryWriter &writer, const std::string &value) {
+        writer.writeLittle(static_cast<uint64_t>(value.size()));
+        writer.write(value.data(), value.size());
+    }
+    static void read(BinaryReader &reader, std::string &value) {
+        uint64_t size = reader.readLittle<uint64_t>();
+        value.clear();
+        // Read in pieces so a corrupt length cannot allocate the world
+        char piece[4096];
+        while (size > 0) {
+            size_t chunk = static_cast<size_t>(std::min<uint64_t>(size, sizeof(piece)));
+            reader.read(piece, chunk);
+            value.append(piece, chunk);
+            size -= chunk;
+        }
+    }
+};
+
+template <class A, class B>
+struct Serializer<std::pair<A, B>> {
+    static constexpr size_t FIXED_SIZE = (Serializer<typename std::remove_const<A>::type>::FIXED_SIZE &&
+                                          Serializer<B>::FIXED_SIZE)
+                                       ? Serializer<typename std::remove_const<A>::type>::FIXED_SIZE +
+                                         Serializer<B>::FIXED_SIZE
+                                       : 0;
+    static constexpr SerializedType TYPE = static_cast<SerializedType>(
+        static_cast<uint16_t>(SerializedType::PAIR) |
+        (static_cast<uint16_t>(serialization_detail::SerializedTypeOf<typename std::remove_const<A>::type>::value) & 0xF) << 4 |
+        (static_cast<uint16_t>(serialization_detail::SerializedTypeOf<B>::value) & 0xF));
+
+    static void write(BinaryWriter &writer, const std::pair<A, B> &value) {
+        Serializer<typename std::remove_const<A>::type>::write(writer, value.first);
+        Serializer<B>::write(writer, value.second);
+    }
+    static void read(BinaryReader &reader, std::pair<A, B> &value) {
+        Serializer<typename std::remove_const<A>::type>::read(reader, const_cast<typename std::remove_const<A>::type &>(value.first));
+        Serializer<B>::read(reader, value.second);
+    }
+};
+
+//**WRITE SERIALIZED**//
+/* *
+ *  Description: Writes a whole container: the header, then every
+ *               element that forEach(visit) passes to visit, then the
+ *               checksum. count must match the number visited.
+ */
+template <class T, class ForEach>
+void writeSerialized(std::ostream &output, SerializedKind kind, uint64_t count, uint32_t flags,
+                     uint64_t capacity, ForEach forEach) {
+    static_assert(Serializer<T>::FIXED_SIZE <= UINT16_MAX, "element size must fit the 16 bit header field");
+    BinaryWriter writer(output);
+    writer.write("CLSZ", 4);
+    writer.writeLittle(SERIALIZATION_VERSION);
+    writer.writeLittle(static_cast<uint16_t>(kind));
+    writer.writeLittle(static_cast<uint16_t>(Serializer<T>::FIXED_SIZE));
+    writer.writeLittle(static_cast<uint16_t>(serialization_detail::SerializedTypeOf<T>::value));
+    writer.writeLittle(flags);
+    writer.writeLittle(count);
+    writer.writeLittle(capacity);
+
+    uint64_t written = 0;
+    forEach([&](const T &item) {
+        Serializer<T>::write(writer, item);
+        written++;
+    });
+    if (written != count) {
+        throw std::logic_error("serialize: element count changed while writing");
+    }
+    writer.finish();
+}
+
+//**READ SERIALIZED**//
+/* *
+ *  Description: Reads a container written by writeSerialized, checking
+ *               the header against kind and the element type, passing
+ *               each element to sink(T &&) and finally checking the
+ *               checksum. Returns the header for the container's
+ *               flags and capacity. The elements are handed over before
+ *               the checksum is known, so build into a temporary and
+ *               only swap it in once this returns.
+ */
+template <class T, class Sink>
+SerializedHeader readSerialized(BinaryReader &reader, SerializedKind kind, Sink sink) {
+    using serialization_detail::fail;
+
+    SerializedHeader header = serialization_detail::readHeader(reader);
+    if (header.kind != kind) {
+        fail("holds a different kind of container");
+    }
+    if (header.elementSize != Serializer<T>::FIXED_SIZE) {
+        fail("element size does not match");
+    }
+    if (header.elementType != serialization_detail::SerializedTypeOf<T>::value) {
+        fail("element type does not match");
+    }
+
+    for (uint64_t i = 0; i < header.count; ++i) {
+        T item{};
+        Serializer<T>::read(reader, item);
+        sink(std::move(item));
+    }
+    reader.checkFooter();
+    return header;
+}
+
+//**MAPPED FILE**//
+/* *
+ *  Description: A whole file mapped read-only into memory. Containers
+ *               load from one with deserialize(const MappedFile &),
+ *               which parses the mapping directly instead of going
+ *               through a stream.
+ */
+class MappedFile {
+private:
+    void  *region;
+    size_t length;
+
+public:
+    // Constructor
+    explicit MappedFile(const std::string &);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Destructor
+    ~MappedFile();
+
+    // Functions
+    const char *data() const { return static_cast<const char *>(region); }
+    size_t size() const { return length; }
+};
+
+// Constructor
+inline MappedFile::MappedFile(const std::string &path) : region{nullptr}, length{0} {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open " + path + ": " + std::strerror(errno));
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        throw std::runtime_error("cannot map " + path + ": empty or unreadable");
+    }
+    length = static_cast<size_t>(info.st_size);
+    void *mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        throw std::runtime_error("cannot map " + path + ": " + std::strerror(errno));
+    }
+    region = mapped;
+}
+
+// Destructor
+inline MappedFile::~MappedFile() {
+    ::munmap(region, length);
+}
+
+//**MAPPED VIEW**//
+/* *
+ *  Description: Read-only array view of the elements of a serialized
+ *               AVLTree, BinarySearchTree, Queue or Stack of plain
+ *               numbers, straight out of the mapped file. Tree files
+ *               are in sorted order, so they can be binary searched.
+ *               The header is checked on construction, and the
+ *               checksum too unless verify is false (which skips
+ *               reading the whole file up front). Needs a little-endian
+ *               machine, where the stored bytes are the numbers.
+ */
+template <class T>
+class MappedView {
+private:
+    static_assert(std::is_arithmetic<T>::value, "MappedView holds integers or floating point numbers");
+
+    MappedFile       file;
+    const T         *items;
+    SerializedHeader header;
+
+public:
+    // Constructor
+    explicit MappedView(const std::string &, bool verify = true);
+
+    // Functions
+    const T *begin() const { return items; }
+    const T *end() const { return items + header.count; }
+    const T &operator[](size_t i) const { return items[i]; }
+    size_t getNumItems() const { return static_cast<size_t>(header.count); }
+    bool isEmpty() const { return header.count == 0; }
+    SerializedKind getKind() const { return header.kind; }
+};
+
+// Constructor
+template <class T>
+MappedView<T>::MappedView(const std::string &path, bool verify) : file(path), items{nullptr} {
+    using serialization_detail::fail;
+    if (!serialization_detail::isLittleEndianHost()) {
+        fail("MappedView needs a little-endian host");
+    }
+    if (file.size() < SerializedHeader::BYTES + SerializedHeader::FOOTER_BYTES) {
+        fail(path + " is too short");
+    }
+
+    // Parse just the header; the elements are left where they are
+    BinaryReader reader(file.data(), SerializedHeader::BYTES);
+    header = serialization_detail::readHeader(reader);
+    if (header.kind == SerializedKind::CHAINING_HASH || header.kind == SerializedKind::PROBING_HASH) {
+        fail(path + " holds key/value pairs");
+    }
+    if (header.elementSize != sizeof(T)) {
+        fail(path + " element size does not match");
+    }
+    if (header.elementType != Serializer<T>::TYPE) {
+        fail(path + " element type does not match");
+    }
+    size_t payload = file.size() - SerializedHeader::BYTES - SerializedHeader::FOOTER_BYTES;
+    if (payload / sizeof(T) != header.count || payload % sizeof(T) != 0) {
+        fail(path + " is truncated or has trailing data");
+    }
+
+    if (verify) {
+        uint64_t hash = serialization_detail::fnv1a(serialization_detail::FNV_OFFSET,
+                                                    reinterpret_cast<const unsigned char *>(file.data()),
+                                                    file.size() - SerializedHeader::FOOTER_BYTES);
+        BinaryReader footer(file.data() + file.size() - SerializedHeader::FOOTER_BYTES,
+                            SerializedHeader::FOOTER_BYTES);
+        if (footer.readLittle<uint64_t>() != hash) {
+            fail(path + " checksum mismatch");
+        }
+    }
+    items = reinterpret_cast<const T *>(file.data() + SerializedHeader::BYTES);
+}
+
+#endif /* Serialization.hpp */
@@ -5,13 +5,81 @@
 //  Created by Kyle Hurd on 11/15/2020.
 //
 //  Sorting algorithms include bubble sort, selection sort, insertion sort,
-//  and quick sort.
+//  heap sort, quick sort (an introsort), tim sort, parallel sample sort and
+//  merge sort that run on a WorkStealingPool, and radix sorts for
+//  integers, floats, strings and records with numeric keys. nthElement,
+//  partialSort and TopK select the first k elements without sorting
+//  the whole input.
+//
+//  Every sort takes a range of random access iterators, so it works on
+//  C arrays, std::vector, std::array and the like, and also has an
+//  overload for C arrays and (under C++20) std::span. Each takes an
+//  optional comparator and projection, in the style of std::ranges:
+//
+//      quickSort(v.begin(), v.end());                          // ascending
+//      quickSort(v.begin(), v.end(), std::greater<>());        // descending
+//      quickSort(v.begin(), v.end(), std::less<>(), &Row::id); // by a member
+//
+//  Elements are moved, never copied.
 //
 
 #ifndef Sorting_hpp
 #define Sorting_hpp
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "WorkStealingPool.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#include <immintrin.h>
+#define SORTING_SIMD 1
+#define SORTING_AVX2 __attribute__((target("avx2,popcnt")))
+#endif
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#define SORTING_SPAN 1
+#endif
+
+// Ranges this small are insertion sorted by quickSort.
+static const int INSERTION_SORT_THRESHOLD = 16;
+
+// Ranges larger than this pick the quickSort pivot by Tukey's ninther
+// rather than a plain median of three.
+static const int NINTHER_THRESHOLD = 128;
+
+// Ranges this small are sorted on one thread by the parallel sorts.
+static const size_t PARALLEL_SORT_THRESHOLD = 1 << 16;
+
+// Ranges this small are sorted by comparison rather than by radixSort.
+static const int RADIX_SORT_THRESHOLD   = 64;
+static const int STRING_RADIX_THRESHOLD = 32;
+
+//**SORT IDENTITY**//
+/* *
+ *  Description: The default projection, which hands elements to the
+ *               comparator unchanged (std::identity before C++20).
+ */
+struct SortIdentity {
+    template <typename U>
+    U &&operator()(U &&u) const noexcept {
+        return std::forward<U>(u);
+    }
+};
 
 //**PRINT ARRAY**//
 /* *
@@ -22,10 +90,10 @@
  */
 template <typename T, size_t size>
 void printArray(const T (&array)[size]) {
-    for (int i = 0; i < size; i++) {
+    for (size_t i = 0; i < size; i++) {
         std::cout << array[i] << " ";
     }
-    std::cout << std::endl;
+    std::cout << '\n';
 }
 
 //**SWAP**//
@@ -38,11 +106,547 @@ void printArray(const T (&array)[size]) {
  */
 template <typename T>
 void swap(T &x, T &y) {
-    T temp = x;
-    x = y;
-    y = temp;
+    T temp = std::move(x);
+    x = std::move(y);
+    y = std::move(temp);
 }
 
+// Building blocks shared by the sorts. Each takes a less(a, b) functor
+// that already has the comparator and projection folded in.
+//
+// Elements are exchanged with a qualified std::swap: an unqualified call
+// would be ambiguous with the swap() template above for any element
+// type declared in the global namespace.
+namespace sorting_detail {
+
+    template <typename Compare, typename Projection>
+    struct ProjectedLess {
+        Compare    comp;
+        Projection proj;
+
+        template <typename A, typename B>
+        bool operator()(A &&a, B &&b) {
+            return std::invoke(comp, std::invoke(proj, std::forward<A>(a)),
+                               std::invoke(proj, std::forward<B>(b)));
+        }
+    };
+
+    template <typename Compare, typename Projection>
+    ProjectedLess<Compare, Projection> makeLess(Compare comp, Projection proj) {
+        return ProjectedLess<Compare, Projection>{std::move(comp), std::move(proj)};
+    }
+
+    //**INSERTION SORT**//
+    template <typename RandomIt, typename Less>
+    void insertionSort(RandomIt first, RandomIt last, Less &less) {
+        if (first == last) {
+            return;
+        }
+        for (RandomIt i = first + 1; i != last; ++i) {
+            auto item = std::move(*i);
+            RandomIt j = i;
+            while (j != first && less(item, *(j - 1))) {
+                *j = std::move(*(j - 1));
+                --j;
+            }
+            *j = std::move(item);
+        }
+    }
+
+    //**HEAP SORT**//
+    template <typename RandomIt, typename Diff, typename Less>
+    void siftDown(RandomIt heap, Diff root, Diff count, Less &less) {
+        auto item = std::move(heap[root]);
+        Diff child;
+        while ((child = 2 * root + 1) < count) {
+            if (child + 1 < count && less(heap[child], heap[child + 1])) {
+                child++;
+            }
+            if (!less(item, heap[child])) {
+                break;
+            }
+            heap[root] = std::move(heap[child]);
+            root = child;
+        }
+        heap[root] = std::move(item);
+    }
+
+    template <typename RandomIt, typename Less>
+    void heapSort(RandomIt first, RandomIt last, Less &less) {
+        typedef typename std::iterator_traits<RandomIt>::difference_type Diff;
+        Diff count = last - first;
+        for (Diff i = count / 2 - 1; i >= 0; --i) {
+            siftDown(first, i, count, less);
+        }
+        for (Diff end = count - 1; end > 0; --end) {
+            std::swap(*first, first[end]);
+            siftDown(first, Diff(0), end, less);
+        }
+    }
+
+    //**PIVOT SELECTION**//
+    //
+    // medianOfThree returns whichever of the three is the median.
+    // choosePivot uses it on the first, middle and last elements, or for
+    // large ranges takes Tukey's ninther (the median of three medians of
+    // three), so sorted, reversed and organ-pipe inputs still split near
+    // the middle.
+    template <typename RandomIt, typename Less>
+    RandomIt medianOfThree(RandomIt a, RandomIt b, RandomIt c, Less &less) {
+        if (less(*a, *b)) {
+            if (less(*b, *c)) return b;
+            return less(*a, *c) ? c : a;
+        }
+        if (less(*a, *c)) return a;
+        return less(*b, *c) ? c : b;
+    }
+
+    template <typename RandomIt, typename Less>
+    RandomIt choosePivot(RandomIt first, RandomIt last, Less &less) {
+        auto n       = last - first;
+        RandomIt mid = first + n / 2;
+        if (n > NINTHER_THRESHOLD) {
+            auto s     = n / 8;
+            RandomIt a = medianOfThree(first, first + s, first + 2 * s, less);
+            RandomIt b = medianOfThree(mid - s, mid, mid + s, less);
+            RandomIt c = medianOfThree(last - 1 - 2 * s, last - 1 - s, last - 1, less);
+            return medianOfThree(a, b, c, less);
+        }
+        return medianOfThree(first, mid, last - 1, less);
+    }
+
+    //**THREE-WAY PARTITION**//
+    //
+    // Bentley-McIlroy three-way partition around the pivot from
+    // choosePivot. It scans inwards from both ends like Hoare's
+    // partition, parking elements equal to the pivot at the two ends,
+    // and swaps them into the middle at the end. Afterwards [first, lt)
+    // is less than the pivot, [lt, gt) is equal to it and [gt, last) is
+    // greater, so runs of duplicates are finished in one pass while
+    // distinct keys cost no more swaps than a two-way partition.
+    template <typename RandomIt, typename Less>
+    void partition3(RandomIt first, RandomIt last, Less &less, RandomIt &lt, RandomIt &gt) {
+        typedef typename std::iterator_traits<RandomIt>::difference_type Diff;
+        std::swap(*first, *choosePivot(first, last, less));
+
+        // The pivot stays at first[0] until the final swaps
+        auto &pivot = *first;
+        Diff high = last - first - 1;
+        Diff i = 0, j = high + 1;
+        Diff p = 0, q = high + 1;
+        for (;;) {
+            while (less(first[++i], pivot)) {
+                if (i == high) break;
+            }
+            while (less(pivot, first[--j])) {
+                if (j == 0) break;
+            }
+            if (i == j && !less(first[i], pivot) && !less(pivot, first[i])) {
+                std::swap(first[++p], first[i]);
+            }
+            if (i >= j) {
+                break;
+            }
+            std::swap(first[i], first[j]);
+            if (!less(first[i], pivot)) {
+                std::swap(first[++p], first[i]);
+            }
+            if (!less(pivot, first[j])) {
+                std::swap(first[--q], first[j]);
+            }
+        }
+
+        // Bring the parked equal elements into the middle
+        i = j + 1;
+        for (Diff k = 0; k <= p; k++) {
+            std::swap(first[k], first[j--]);
+        }
+        for (Diff k = high; k >= q; k--) {
+            std::swap(first[k], first[i++]);
+        }
+        lt = first + (j + 1);
+        gt = first + i;
+    }
+
+    //**INTROSORT**//
+    //
+    // The quicksort loop. Ranges of INSERTION_SORT_THRESHOLD elements or
+    // fewer are left to insertion sort. Otherwise the range is split
+    // three ways, the smaller side is sorted by a recursive call and the
+    // larger side by looping, so the stack never grows past O(log n).
+    // Each split spends one unit of depthLimit; when it runs out the
+    // range is heap sorted.
+    template <typename RandomIt, typename Less>
+    void introSort(RandomIt first, RandomIt last, int depthLimit, Less &less) {
+        while (last - first > INSERTION_SORT_THRESHOLD) {
+            if (depthLimit == 0) {
+                sorting_detail::heapSort(first, last, less);
+                return;
+            }
+            depthLimit--;
+
+            RandomIt lt, gt;
+            partition3(first, last, less, lt, gt);
+            if (lt - first < last - gt) {
+                introSort(first, lt, depthLimit, less);
+                first = gt;
+            }
+            else {
+                introSort(gt, last, depthLimit, less);
+                last = lt;
+            }
+        }
+        sorting_detail::insertionSort(first, last, less);
+    }
+
+    // 2 * floor(log2(n))
+    template <typename Diff>
+    int depthLimit(Diff n) {
+        int depth = 0;
+        for (; n > 1; n >>= 1) {
+            depth += 2;
+        }
+        return depth;
+    }
+
+} // namespace sorting_detail
+
+#ifdef SORTING_SIMD
+// AVX2 kernels for quickSort on int32_t and float. Everything here is
+// compiled for AVX2 through SORTING_AVX2 and only called once
+// hasAvx2() has confirmed the CPU supports it.
+namespace sorting_detail {
+
+    // Ranges this small are finished by the bitonic network.
+    static const int SIMD_SORT_BLOCK = 64;
+
+    inline bool hasAvx2() {
+        static const bool supported = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+        return supported;
+    }
+
+    // Row m lists the lanes whose bit is set in m, in order, followed by
+    // the rest: permuting by it packs the selected lanes at the bottom.
+    struct PartitionTable {
+        int32_t lanes[256][8];
+
+        constexpr PartitionTable() : lanes{} {
+            for (int m = 0; m < 256; ++m) {
+                int k = 0;
+                for (int lane = 0; lane < 8; ++lane) {
+                    if (m & (1 << lane)) lanes[m][k++] = lane;
+                }
+                for (int lane = 0; lane < 8; ++lane) {
+                    if (!(m & (1 << lane))) lanes[m][k++] = lane;
+                }
+            }
+        }
+    };
+    alignas(32) inline constexpr PartitionTable PARTITION_TABLE{};
+
+    // Eight lanes of int32_t
+    struct SimdInt32 {
+        typedef int32_t T;
+        typedef __m256i V;
+
+        static SORTING_AVX2 V load(const T *p)     { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+        static SORTING_AVX2 void store(T *p, V v)  { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+        static SORTING_AVX2 V set1(T x)            { return _mm256_set1_epi32(x); }
+        static SORTING_AVX2 V permute(V v, __m256i idx) { return _mm256_permutevar8x32_epi32(v, idx); }
+        static SORTING_AVX2 void minMax(V a, V b, V &lo, V &hi) {
+            lo = _mm256_min_epi32(a, b);
+            hi = _mm256_max_epi32(a, b);
+        }
+        template <int Mask>
+        static SORTING_AVX2 V blend(V a, V b)      { return _mm256_blend_epi32(a, b, Mask); }
+        // Lanes with v < pivot, or v <= pivot
+        static SORTING_AVX2 int lessMask(V v, V pivot) {
+            return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(pivot, v)));
+        }
+        static SORTING_AVX2 int lessEqualMask(V v, V pivot) {
+            return ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, pivot))) & 0xFF;
+        }
+        static T padding() { return std::numeric_limits<T>::max(); }
+    };
+
+    // Eight lanes of float. min/max are done by compare and blend rather
+    // than minps/maxps, which would turn -0.0 and +0.0 into two copies
+    // of the same zero.
+    struct SimdFloat {
+        typedef float T;
+        typedef __m256 V;
+
+        static SORTING_AVX2 V load(const T *p)     { return _mm256_loadu_ps(p); }
+        static SORTING_AVX2 void store(T *p, V v)  { _mm256_storeu_ps(p, v); }
+        static SORTING_AVX2 V set1(T x)            { return _mm256_set1_ps(x); }
+        static SORTING_AVX2 V permute(V v, __m256i idx) { return _mm256_permutevar8x32_ps(v, idx); }
+        static SORTING_AVX2 void minMax(V a, V b, V &lo, V &hi) {
+            V bLess = _mm256_cmp_ps(b, a, _CMP_LT_OQ);
+            lo = _mm256_blendv_ps(a, b, bLess);
+            hi = _mm256_blendv_ps(b, a, bLess);
+        }
+        template <int Mask>
+        static SORTING_AVX2 V blend(V a, V b)      { return _mm256_blend_ps(a, b, Mask); }
+        static SORTING_AVX2 int lessMask(V v, V pivot) {
+            return _mm256_movemask_ps(_mm256_cmp_ps(v, pivot, _CMP_LT_OQ));
+        }
+        static SORTING_AVX2 int lessEqualMask(V v, V pivot) {
+            return _mm256_movemask_ps(_mm256_cmp_ps(v, pivot, _CMP_LE_OQ));
+        }
+        static T padding() { return std::numeric_limits<T>::infinity(); }
+    };
+
+    //**BITONIC NETWORK**//
+    //
+    // One compare-exchange stage inside a register: each lane meets the
+    // lane its index XOR'd with a distance away, and the lanes in Mask
+    // keep the larger of the pair.
+    template <typename S, int Mask>
+    SORTING_AVX2 inline typename S::V exchange(typename S::V v, __m256i partner) {
+        typename S::V lo, hi;
+        S::minMax(v, S::permute(v, partner), lo, hi);
+        return S::template blend<Mask>(lo, hi);
+    }
+
+    // Sorts the eight lanes of v (bitonic sort, six stages).
+    template <typename S>
+    SORTING_AVX2 inline typename S::V sortRegister(typename S::V v) {
+        const __m256i xor1 = _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6);
+        const __m256i xor2 = _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5);
+        const __m256i xor4 = _mm256_setr_epi32(4, 5, 6, 7, 0, 1, 2, 3);
+        v = exchange<S, 0x66>(v, xor1);
+        v = exchange<S, 0x3C>(v, xor2);
+        v = exchange<S, 0x5A>(v, xor1);
+        v = exchange<S, 0xF0>(v, xor4);
+        v = exchange<S, 0xCC>(v, xor2);
+        return exchange<S, 0xAA>(v, xor1);
+    }
+
+    // Sorts the eight lanes of a bitonic v (the last three stages).
+    template <typename S>
+    SORTING_AVX2 inline typename S::V mergeRegister(typename S::V v) {
+        v = exchange<S, 0xF0>(v, _mm256_setr_epi32(4, 5, 6, 7, 0, 1, 2, 3));
+        v = exchange<S, 0xCC>(v, _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5));
+        return exchange<S, 0xAA>(v, _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6));
+    }
+
+    // Sorts count registers (1, 2, 4 or 8) as one sequence: each is
+    // sorted alone, then sorted groups are merged pairwise by reversing
+    // the second, exchanging across the two, and cleaning up the halves.
+    template <typename S>
+    SORTING_AVX2 void sortRegisters(typename S::V *r, int count) {
+        typedef typename S::V V;
+        const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+        for (int i = 0; i < count; ++i) {
+            r[i] = sortRegister<S>(r[i]);
+        }
+        for (int size = 2; size <= count; size *= 2) {
+            int half = size / 2;
+            for (int g = 0; g < count; g += size) {
+                V flipped[4];
+                for (int i = 0; i < half; ++i) {
+                    flipped[i] = S::permute(r[g + size - 1 - i], reverse);
+                }
+                for (int i = 0; i < half; ++i) {
+                    S::minMax(r[g + i], flipped[i], r[g + i], r[g + half + i]);
+                }
+                for (int stride = half / 2; stride > 0; stride /= 2) {
+                    for (int i = g; i < g + size; ++i) {
+                        if (((i - g) & stride) == 0) {
+                            S::minMax(r[i], r[i + stride], r[i], r[i + stride]);
+                        }
+                    }
+                }
+                for (int i = g; i < g + size; ++i) {
+                    r[i] = mergeRegister<S>(r[i]);
+                }
+            }
+        }
+    }
+
+    // Sorts up to SIMD_SORT_BLOCK elements, padded out to whole
+    // registers with the largest value.
+    template <typename S>
+    SORTING_AVX2 void bitonicSort(typename S::T *first, size_t n) {
+        typedef typename S::T T;
+        alignas(32) T block[SIMD_SORT_BLOCK];
+        typename S::V r[SIMD_SORT_BLOCK / 8];
+
+        int count = 1;
+        while (size_t(count) * 8 < n) {
+            count *= 2;
+        }
+        std::copy(first, first + n, block);
+        std::fill(block + n, block + count * 8, S::padding());
+        for (int i = 0; i < count; ++i) {
+            r[i] = S::load(block + 8 * i);
+        }
+        sortRegisters<S>(r, count);
+        for (int i = 0; i < count; ++i) {
+            S::store(block + 8 * i, r[i]);
+        }
+        std::copy(block, block + n, first);
+    }
+
+    //**VECTORIZED PARTITION**//
+    //
+    // In-place partition of [first, last) (at least 16 elements) into
+    // elements less than pivot (or not greater, with TakeEqual) followed
+    // by the rest; returns the boundary. Each register read is packed by
+    // a table permutation so the left-going lanes come first, then
+    // stored whole at both write fronts, which each advance by their
+    // lane count. The first and last registers are held back so both
+    // fronts always have a register's worth of already-read space to
+    // write into, and the next read comes from whichever side has less.
+    template <typename S, bool TakeEqual>
+    SORTING_AVX2 inline void partitionRegister(typename S::V v, typename S::V pivot,
+                                                typename S::T *&writeLeft, typename S::T *&writeRight) {
+        int mask = TakeEqual ? S::lessEqualMask(v, pivot) : S::lessMask(v, pivot);
+        __m256i lanes = _mm256_load_si256(reinterpret_cast<const __m256i *>(PARTITION_TABLE.lanes[mask]));
+        typename S::V packed = S::permute(v, lanes);
+        int left = __builtin_popcount(mask);
+        S::store(writeLeft, packed);
+        S::store(writeRight - 8, packed);
+        writeLeft  += left;
+        writeRight -= 8 - left;
+    }
+
+    template <typename S, bool TakeEqual>
+    SORTING_AVX2 typename S::T *partitionVector(typename S::T *first, typename S::T *last, typename S::T pivotValue) {
+        typedef typename S::T T;
+        typedef typename S::V V;
+        V pivot = S::set1(pivotValue);
+
+        V firstRegister = S::load(first);
+        V lastRegister  = S::load(last - 8);
+        T *readLeft  = first + 8, *readRight  = last - 8;
+        T *writeLeft = first,     *writeRight = last;
+
+        while (readRight - readLeft >= 8) {
+            V v;
+            if (readLeft - writeLeft <= writeRight - readRight) {
+                v = S::load(readLeft);
+                readLeft += 8;
+            }
+            else {
+                readRight -= 8;
+                v = S::load(readRight);
+            }
+            partitionRegister<S, TakeEqual>(v, pivot, writeLeft, writeRight);
+        }
+
+        T tail[8];
+        int tailCount = static_cast<int>(readRight - readLeft);
+        std::copy(readLeft, readRight, tail);
+        for (int i = 0; i < tailCount; ++i) {
+            bool goesLeft = TakeEqual ? !(pivotValue < tail[i]) : tail[i] < pivotValue;
+            if (goesLeft) {
+                *writeLeft++ = tail[i];
+            }
+            else {
+                *--writeRight = tail[i];
+            }
+        }
+
+        partitionRegister<S, TakeEqual>(firstRegister, pivot, writeLeft, writeRight);
+        partitionRegister<S, TakeEqual>(lastRegister, pivot, writeLeft, writeRight);
+        return writeLeft;
+    }
+
+    //**SIMD INTROSORT**//
+    //
+    // introSort with the vectorized partition and a bitonic base case.
+    // Partitioning is two-way around a pivot set aside at first[0]. When
+    // the pivot equals the element just before the range (which is no
+    // greater than anything in it), everything equal to the pivot is
+    // split off in one pass and never looked at again, which keeps
+    // duplicate-heavy input linear.
+    template <typename S>
+    SORTING_AVX2 void simdIntroSort(typename S::T *first, typename S::T *last, int depthLimit, bool leftmost) {
+        typedef typename S::T T;
+        std::less<> less;
+
+        while (last - first > SIMD_SORT_BLOCK) {
+            if (depthLimit == 0) {
+                sorting_detail::heapSort(first, last, less);
+                return;
+            }
+            depthLimit--;
+
+            std::swap(*first, *choosePivot(first, last, less));
+            T pivot = *first;
+
+            if (!leftmost && !(first[-1] < pivot)) {
+                first = partitionVector<S, true>(first + 1, last, pivot);
+                continue;
+            }
+
+            T *middle = partitionVector<S, false>(first + 1, last, pivot) - 1;
+            std::swap(*first, *middle);
+            if (middle - first < last - middle) {
+                simdIntroSort<S>(first, middle, depthLimit, leftmost);
+                first    = middle + 1;
+                leftmost = false;
+            }
+            else {
+                simdIntroSort<S>(middle + 1, last, depthLimit, false);
+                last = middle;
+            }
+        }
+        if (last - first > 1) {
+            bitonicSort<S>(first, static_cast<size_t>(last - first));
+        }
+    }
+
+    template <typename T>
+    SORTING_AVX2 bool hasNaN(const T *, size_t) {
+        return false;
+    }
+
+    template <>
+    SORTING_AVX2 inline bool hasNaN<float>(const float *p, size_t n) {
+        size_t i = 0;
+        __m256 unordered = _mm256_setzero_ps();
+        for (; i + 8 <= n; i += 8) {
+            __m256 v  = _mm256_loadu_ps(p + i);
+            unordered = _mm256_or_ps(unordered, _mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+        }
+        bool found = _mm256_movemask_ps(unordered) != 0;
+        for (; i < n; ++i) {
+            found |= (p[i] != p[i]);
+        }
+        return found;
+    }
+
+    // Sorts p[0..n) and returns true, or returns false without touching
+    // it if the CPU lacks AVX2 or a float range holds a NaN (which
+    // compares false both ways and would break the network).
+    template <typename T>
+    bool simdQuickSort(T *p, size_t n) {
+        typedef typename std::conditional<std::is_same<T, float>::value, SimdFloat, SimdInt32>::type S;
+        if (!hasAvx2() || hasNaN(p, n)) {
+            return false;
+        }
+        simdIntroSort<S>(p, p + n, depthLimit(n), true);
+        return true;
+    }
+
+    // quickSort takes the SIMD path for plain ascending sorts of int32_t
+    // or float held contiguously.
+    template <typename RandomIt, typename Compare, typename Projection>
+    struct UseSimdSort {
+        typedef typename std::iterator_traits<RandomIt>::value_type T;
+        static constexpr bool value =
+            (std::is_same<T, int32_t>::value || std::is_same<T, float>::value) &&
+            (std::is_same<Compare, std::less<>>::value || std::is_same<Compare, std::less<T>>::value) &&
+            std::is_same<Projection, SortIdentity>::value &&
+            (std::is_same<RandomIt, T *>::value || std::is_same<RandomIt, typename std::vector<T>::iterator>::value);
+    };
+
+} // namespace sorting_detail
+#endif
+
 //**BUBBLE SORT**//
 /* *
  *  Created by:  Kyle Hurd
@@ -57,13 +661,15 @@ void swap(T &x, T &y) {
  *               Best sorting time:  O(n)
  *               Worst sorting time: O(n^2)
  */
-template <typename T, size_t size>
-void bubbleSort(T (&array)[size]) {
-    for (int i = 0; i < size - 1; ++i) {
+template <typename RandomIt, typename Compare = std::less<>, typename Projection = SortIdentity>
+void bubbleSort(RandomIt first, RandomIt last, Compare comp = Compare(), Projection proj = Projection()) {
+    auto less = sorting_detail::makeLess(comp, proj);
+    auto size = last - first;
+    for (decltype(size) i = 0; i < size - 1; ++i) {
         bool flag = false;
-        for (int j = 0; j < size - i - 1; ++j) {
-            if (array[j] > array[j+1]) {
-                swap(array[j], array[j+1]);
+        for (decltype(size) j = 0; j < size - i - 1; ++j) {
+            if (less(first[j + 1], first[j])) {
+                std::swap(first[j], first[j + 1]);
                 flag = true;
             }
         }
@@ -73,6 +679,11 @@ void bubbleSort(T (&array)[size]) {
     }
 }
 
+template <typename T, size_t size>
+void bubbleSort(T (&array)[size]) {
+    bubbleSort(array, array + size);
+}
+
 //**SELECTION SORT**//
 /* *
  *  Created by:  Kyle Hurd
@@ -84,20 +695,27 @@ void bubbleSort(T (&array)[size]) {
  *               Best sorting time:  O(n^2)
  *               Worst sorting time: O(n^2)
  */
-template <typename T, size_t size>
-void selectionSort(T (&array)[size]) {
-    int id;
-    for (int i = 0; i < size - 1; ++i) {
-        id = i;
-        for (int j = i + 1; j < size; ++j) {
-            if (array[j] < array[id]) {
+template <typename RandomIt, typename Compare = std::less<>, typename Projection = SortIdentity>
+void selectionSort(RandomIt first, RandomIt last, Compare comp = Compare(), Projection proj = Projection()) {
+    auto less = sorting_detail::makeLess(comp, proj);
+    for (RandomIt i = first; i != last; ++i) {
+        RandomIt id = i;
+        for (RandomIt j = i + 1; j != last; ++j) {
+            if (less(*j, *id)) {
                 id = j;
             }
         }
-        swap(array[id], array[i]);
+        if (id != i) {
+            std::swap(*id, *i);
+        }
     }
 }
 
+template <typename T, size_t size>
+void selectionSort(T (&array)[size]) {
+    selectionSort(array, array + size);
+}
+
 //**INSERTION SORT**//
 /* *
  *  Created by:  Kyle Hurd
@@ -110,32 +728,55 @@ void selectionSort(T (&array)[size]) {
  *               Best sorting time:  O(n)
  *               Worst sorting time: O(n^2)
  */
+template <typename RandomIt, typename Compare = std::less<>, typename Projection = SortIdentity>
+void insertionSort(RandomIt first, RandomIt last, Compare comp = Compare(), Projection proj = Projection()) {
+    auto less = sorting_detail::makeLess(comp, proj);
+    sorting_detail::insertionSort(first, last, less);
+}
+
 template <typename T, size_t size>
 void insertionSort(T (&array)[size]) {
-    for (int i = 0; i < size; ++i) {
-        int id = array[i];
-        int j  = i - 1;
-        while (j > -1 && array[j] > id) {
-            array[j + 1] = array[j];
-            j--;
-        }
-        array[j + 1] = id;
-    }
+    insertionSort(array, array + size);
 }
 
 //**PARTITION**//
+/* *
+ *  Description: Lomuto partition of array[low..high] around array[high].
+ *               Everything less than the pivot ends up to its left,
+ *               everything else to its right, and the pivot's final index
+ *               is returned.
+ */
 template <typename T>
 int partition(T array[], int low, int high) {
-    
-    int pivotPos = high;
-    int pivotVal = low;
+    int store = low;
     for (int i = low; i < high; i++) {
-        if (array[i] < array[pivotPos]) {
-            swap(array[i], array[pivotVal++]);
+        if (array[i] < array[high]) {
+            std::swap(array[i], array[store++]);
         }
     }
-    swap(array[pivotVal], array[pivotPos]);
-    return pivotPos;
+    std::swap(array[store], array[high]);
+    return store;
+}
+
+//**HEAP SORT**//
+/* *
+ *  Description: In-place heap sort. Slower than quickSort on average but
+ *               never worse than O(n log n) and uses no extra memory;
+ *               quickSort falls back to it when partitioning keeps going
+ *               badly.
+ *
+ *               Best sorting time:  O(n log n)
+ *               Worst sorting time: O(n log n)
+ */
+template <typename RandomIt, typename Compare = std::less<>, typename Projection = SortIdentity>
+void heapSort(RandomIt first, RandomIt last, Compare comp = Compare(), Projection proj = Projection()) {
+    auto less = sorting_detail::makeLess(comp, proj);
+    sorting_detail::heapSort(first, last, less);
+}
+
+template <typename T, size_t size>
+void heapSort(T (&array)[size]) {
+    heapSort(array, array + size);
 }
 
 //**QUICK SORT**//
@@ -148,14 +789,1428 @@ int partition(T array[], int low, int high) {
  *               and high ranges. If you want to sort a specific section exclusively,
  *               you can write the function as 'quickSort(array, low, high). By default
  *               low is the 0th element and high is the last element.
+ *
+ *               Implemented as an introsort (see sorting_detail::introSort).
+ *               Ascending sorts of int32_t or float in a C array or vector
+ *               use the AVX2 version (sorting_detail::simdIntroSort) when
+ *               the CPU has AVX2.
+ *
+ *               Best sorting time:  O(n)   (all elements equal)
+ *               Worst sorting time: O(n log n)
  */
+template <typename RandomIt, typename Compare = std::less<>, typename Projection = SortIdentity>
+void quickSort(RandomIt first, RandomIt last, Compare comp = Compare(), Projection proj = Projection()) {
+#ifdef SORTING_SIMD
+    if constexpr (sorting_detail::UseSimdSort<RandomIt, Compare, Projection>::value) {
+        if (last - first > 1 && sorting_detail::simdQuickSort(&*first, static_cast<size_t>(last - first))) {
+            return;
+        }
+    }
+#endif
+    if (last - first > 1) {
+        auto less = sorting_detail::makeLess(comp, proj);
+        sorting_detail::introSort(first, last, sorting_detail::depthLimit(last - first), less);
+    }
+}
+
 template <typename T, size_t size>
 void quickSort(T (&array)[size], int low=0, int high=size-1) {
     if (low < high) {
-        int pivot = partition(array, low, high);
-        quickSort(array, low, pivot - 1);
-        quickSort(array, pivot + 1, high);
+        quickSort(array + low, array + high + 1);
+    }
+}
+
+// Helpers for the selection functions.
+namespace sorting_detail {
+
+    //**HEAP SELECT**//
+    //
+    // Moves the middle - first elements that sort first into [first,
+    // middle), in sorted order. They are kept as a max-heap while the
+    // rest of the range is scanned, so each later element costs one
+    // comparison with the heap's root unless it belongs in the heap.
+    template <typename RandomIt, typename Less>
+    void heapSelect(RandomIt first, RandomIt middle, RandomIt last, Less &less) {
+        typedef typename std::iterator_traits<RandomIt>::difference_type Diff;
+        Diff count = middle - first;
+        if (count == 0) {
+            return;
+        }
+        for (Diff i = count / 2; i-- > 0; ) {
+            siftDown(first, i, count, less);
+        }
+        for (RandomIt i = middle; i != last; ++i) {
+            if (less(*i, *first)) {
+                std::swap(*i, *first);
+                siftDown(first, Diff(0), count, less);
+            }
+        }
+        for (Diff end = count - 1; end > 0; --end) {
+            std::swap(first[0], first[end]);
+            siftDown(first, Diff(0), end, less);
+        }
+    }
+
+    //**INTROSELECT**//
+    //
+    // Quickselect on partition3: after each split only the part holding
+    // nth is kept, and the loop stops as soon as nth lands among the
+    // elements equal to the pivot. Each split spends one unit of
+    // depthLimit; when it runs out what remains is heap sorted, so the
+    // worst case is O(n log n) rather than quadratic.
+    template <typename RandomIt, typename Less>
+    void introSelect(RandomIt first, RandomIt nth, RandomIt last, int depthLimit, Less &less) {
+        while (last - first > INSERTION_SORT_THRESHOLD) {
+            if (depthLimit == 0) {
+                sorting_detail::heapSort(first, last, less);
+                return;
+            }
+            depthLimit--;
+
+            RandomIt lt, gt;
+            partition3(first, last, less, lt, gt);
+            if (nth < lt) {
+                last = lt;
+            }
+            else if (nth >= gt) {
+                first = gt;
+            }
+            else {
+                return;
+            }
+        }
+        sorting_detail::insertionSort(first, last, less);
     }
+
+} // namespace sorting_detail
+
+// partialSort keeps up to this many elements in a heap; beyond it
+// selecting and then sorting the prefix is faster.
+static const size_t PARTIAL_SORT_HEAP_LIMIT = 4096;
+
+//**NTH ELEMENT**//
+/* *
+ *  Description: Rearranges [first, last) so that *nth is the element
+ *               that would be there if the range were sorted, with
+ *               nothing after nth ordered before it and nothing before
+ *               it ordered after it. Neither side is sorted. Does
+ *               nothing if nth == last.
+ *
+ *               Selection time: O(n) on average, O(n log n) worst
+ */
+template <typename RandomIt, typename Compare = std::less<>, typename Projection = SortIdentity>
+void nthElement(RandomIt first, RandomIt nth, RandomIt last, Compare comp = Compare(), Projection proj = Projection()) {
+    if (nth != last && last - first > 1) {
+        auto less = sorting_detail::makeLess(comp, proj);
+        sorting_detail::introSelect(first, nth, last, sorting_detail::depthLimit(last - first), less);
+    }
+}
+
+//**PARTIAL SORT**//
+/* *
+ *  Description: Puts the middle - first elements that sort first into
+ *               [first, middle), in sorted order, and leaves the rest in
+ *               [middle, last) in no particular order.
+ *
+ *               Up to PARTIAL_SORT_HEAP_LIMIT elements are picked with a
+ *               bounded heap in one pass over the range; more are picked
+ *               by nthElement and then sorted with quickSort.
+ *
+ *               Sorting time: O(n log k) for k <= PARTIAL_SORT_HEAP_LIMIT,
+ *                             O(n + k log k) otherwise
+ */
+template <typename RandomIt, typename Compare = std::less<>, typename Projection = SortIdentity>
+void partialSort(RandomIt first, RandomIt middle, RandomIt last, Compare comp = Compare(), Projection proj = Projection()) {
+    size_t k = static_cast<size_t>(middle - first);
+    if (k == 0) {
+        return;
+    }
+    if (k <= PARTIAL_SORT_HEAP_LIMIT) {
+        auto less = sorting_detail::makeLess(comp, proj);
+        sorting_detail::heapSelect(first, middle, last, less);
+        return;
+    }
+    nthElement(first, middle - 1, last, comp, proj);
+    quickSort(first, middle - 1, comp, proj);
+}
+
+//**TOP K**//
+/* *
+ *  Description: Keeps the k items that sort first out of a stream of any
+ *               length, using memory for k items only. To keep the k
+ *               largest, order by std::greater<>:
+ *
+ *                   TopK<Hit, std::greater<>, double Hit::*> best(100, {}, &Hit::score);
+ *                   for (const Hit &hit : hits) best.push(hit);
+ *                   std::vector<Hit> top = best.takeSorted();
+ *
+ *               Once k items are held they form a max-heap (by Compare),
+ *               so an item that does not make the cut costs a single
+ *               comparison with the worst one held.
+ *
+ *               push(): O(1) to reject an item, O(log k) to keep one
+ */
+template <class T, class Compare = std::less<>, class Projection = SortIdentity>
+class TopK {
+private:
+    std::vector<T> items;   // A heap once it holds k items
+    size_t k;
+    sorting_detail::ProjectedLess<Compare, Projection> less;
+
+    template <class U>
+    void pushItem(U &&);
+
+public:
+    // Constructor
+    explicit TopK(size_t k, Compare comp = Compare(), Projection proj = Projection());
+
+    // Functions
+    void push(const T &item) { pushItem(item); }
+    void push(T &&item)      { pushItem(std::move(item)); }
+    bool isEmpty() const;
+    bool isFull() const;
+    size_t getNumItems() const;
+    const T &getThreshold() const;
+    std::vector<T> takeSorted();
+};
+
+// Constructor
+template <class T, class Compare, class Projection>
+TopK<T, Compare, Projection>::TopK(size_t count, Compare comp, Projection proj)
+    : k{count}, less{std::move(comp), std::move(proj)} {
+    items.reserve(count);
+}
+
+// **Private** //
+// pushItem()
+template <class T, class Compare, class Projection>
+template <class U>
+void TopK<T, Compare, Projection>::pushItem(U &&item) {
+    if (items.size() < k) {
+        items.push_back(std::forward<U>(item));
+        if (items.size() == k) {
+            for (size_t i = k / 2; i-- > 0; ) {
+                sorting_detail::siftDown(items.begin(), i, k, less);
+            }
+        }
+    }
+    else if (k != 0 && less(item, items[0])) {
+        items[0] = std::forward<U>(item);
+        sorting_detail::siftDown(items.begin(), size_t(0), k, less);
+    }
+}
+
+// **Public** //
+// isEmpty()
+template <class T, class Compare, class Projection>
+bool TopK<T, Compare, Projection>::isEmpty() const {
+    return items.empty();
+}
+
+// **Public** //
+// isFull()
+//
+// True once k items have been seen; from then on an item is only kept
+// if it sorts before getThreshold().
+template <class T, class Compare, class Projection>
+bool TopK<T, Compare, Projection>::isFull() const {
+    return items.size() == k;
+}
+
+// **Public** //
+// getNumItems()
+template <class T, class Compare, class Projection>
+size_t TopK<T, Compare, Projection>::getNumItems() const {
+    return items.size();
+}
+
+// **Public** //
+// getThreshold()
+//
+// The last of the items held, in Compare order. Only valid once isFull().
+template <class T, class Compare, class Projection>
+const T &TopK<T, Compare, Projection>::getThreshold() const {
+    return items[0];
+}
+
+// **Public** //
+// takeSorted()
+//
+// Returns the items held, in Compare order, and empties the TopK.
+template <class T, class Compare, class Projection>
+std::vector<T> TopK<T, Compare, Projection>::takeSorted() {
+    std::vector<T> result;
+    result.swap(items);
+    if (result.size() > 1) {
+        sorting_detail::introSort(result.begin(), result.end(), sorting_detail::depthLimit(result.size()), less);
+    }
+    items.reserve(k);
+    return result;
+}
+
+// Helpers for the parallel sorts. Comparators and projections are
+// called from several threads at once, so they must be safe to share.
+namespace sorting_detail {
+
+    // Raw storage for n elements. Whoever constructs elements in it
+    // is responsible for destroying them.
+    template <typename T>
+    struct ScratchBuffer {
+        std::allocator<T> alloc;
+        T                *data;
+        size_t            size;
+
+        explicit ScratchBuffer(size_t n) : data{alloc.allocate(n)}, size{n} { }
+        ~ScratchBuffer() { alloc.deallocate(data, size); }
+        ScratchBuffer(const ScratchBuffer &) = delete;
+        ScratchBuffer &operator=(const ScratchBuffer &) = delete;
+    };
+
+    // Runs body(begin, end) over [0, n) split into parts pieces.
+    template <typename Body>
+    void parallelFor(WorkStealingPool &pool, size_t n, size_t parts, Body body) {
+        TaskGroup group(pool);
+        size_t step = (n + parts - 1) / parts;
+        for (size_t begin = 0; begin < n; begin += step) {
+            size_t end = (begin + step < n) ? begin + step : n;
+            group.run([&body, begin, end] { body(begin, end); });
+        }
+        group.wait();
+    }
+
+    //**PARALLEL MERGE**//
+    //
+    // Moves the merge of [a, aEnd) and [b, bEnd) into out. Large merges
+    // are split at the middle of the longer input and a binary search
+    // in the shorter one, and the two halves merged in parallel. Ties
+    // take from a first, so merging is stable.
+    template <typename InIt, typename OutIt, typename Less>
+    void parallelMerge(WorkStealingPool &pool, InIt a, InIt aEnd, InIt b, InIt bEnd, OutIt out,
+                       Less &less, size_t threshold) {
+        size_t na = static_cast<size_t>(aEnd - a);
+        size_t nb = static_cast<size_t>(bEnd - b);
+
+        if (na + nb <= threshold || na == 0 || nb == 0) {
+            while (a != aEnd && b != bEnd) {
+                if (less(*b, *a)) {
+                    *out++ = std::move(*b++);
+                }
+                else {
+                    *out++ = std::move(*a++);
+                }
+            }
+            out = std::move(a, aEnd, out);
+            std::move(b, bEnd, out);
+            return;
+        }
+
+        InIt aMid, bMid;
+        if (na >= nb) {
+            aMid = a + na / 2;
+            bMid = std::lower_bound(b, bEnd, *aMid, std::ref(less));
+        }
+        else {
+            bMid = b + nb / 2;
+            aMid = std::upper_bound(a, aEnd, *bMid, std::ref(less));
+        }
+        OutIt outMid = out + ((aMid - a) + (bMid - b));
+
+        TaskGroup group(pool);
+        group.run([&] { parallelMerge(pool, a, aMid, b, bMid, out, less, threshold); });
+        parallelMerge(pool, aMid, aEnd, bMid, bEnd, outMid, less, threshold);
+        group.wait();
+    }
+
+    //**PARALLEL MERGE SORT**//
+    //
+    // Sorts the n elements at data, leaving the result at other if
+    // resultInOther is set and at data otherwise. The two halves are
+    // sorted in parallel into whichever array the parent will merge
+    // from, so the data ping-pongs between the arrays and is never
+    // copied back separately.
+    template <typename DataIt, typename OtherIt, typename Less>
+    void parallelMergeSort(WorkStealingPool &pool, DataIt data, OtherIt other, size_t n,
+                           bool resultInOther, Less &less, size_t threshold) {
+        if (n <= threshold || n < 2) {
+            introSort(data, data + n, depthLimit(n), less);
+            if (resultInOther) {
+                std::move(data, data + n, other);
+            }
+            return;
+        }
+
+        size_t half = n / 2;
+        TaskGroup group(pool);
+        group.run([&] { parallelMergeSort(pool, data, other, half, !resultInOther, less, threshold); });
+        parallelMergeSort(pool, data + half, other + half, n - half, !resultInOther, less, threshold);
+        group.wait();
+
+        if (resultInOther) {
+            parallelMerge(pool, data, data + half, data + half, data + n, other, less, threshold);
+        }
+        else {
+            parallelMerge(pool, other, other + half, other + half, other + n, data, less, threshold);
+        }
+    }
+
+    template <typename RandomIt, typename Less>
+    void parallelMergeSort(WorkStealingPool &pool, RandomIt first, RandomIt last, Less &less,
+                           size_t threshold) {
+        typedef typename std::iterator_traits<RandomIt>::value_type T;
+        size_t n      = static_cast<size_t>(last - first);
+        size_t pieces = size_t(pool.getNumThreads()) * 4;
+
+        // Move everything into the buffer, sort from there back into place
+        ScratchBuffer<T> buffer(n);
+        parallelFor(pool, n, pieces, [&](size_t begin, size_t end) {
+            std::uninitialized_move(first + begin, first + end, buffer.data + begin);
+        });
+        parallelMergeSort(pool, buffer.data, first, n, true, less, threshold);
+        parallelFor(pool, n, pieces, [&](size_t begin, size_t end) {
+            std::destroy(buffer.data + begin, buffer.data + end);
+        });
+    }
+
+    //**PARALLEL SAMPLE SORT**//
+    //
+    // One round of sample sort:
+    //   1. Sort a random sample and take evenly spaced splitters from it.
+    //   2. In parallel blocks, classify every element into a bucket by
+    //      binary search over the splitters and count bucket sizes.
+    //   3. Prefix sum the counts so each block knows where its share of
+    //      every bucket goes, then scatter the elements into a buffer.
+    //   4. Sort the buckets in parallel and move them back.
+    // Keys equal to a splitter get a bucket of their own, which needs no
+    // sorting, so heavy duplicates cannot pile up in one bucket.
+    template <typename RandomIt, typename Less>
+    void parallelSampleSort(WorkStealingPool &pool, RandomIt first, RandomIt last, Less &less) {
+        typedef typename std::iterator_traits<RandomIt>::value_type T;
+        const size_t OVERSAMPLE = 16;
+        size_t n       = static_cast<size_t>(last - first);
+        size_t threads = pool.getNumThreads();
+
+        // 1. Splitters, as iterators into the (not yet moved) input
+        size_t wanted = threads * 4 - 1;
+        if (wanted > 127) {
+            wanted = 127;
+        }
+        std::vector<RandomIt> sample((wanted + 1) * OVERSAMPLE);
+        uint64_t state = 0x9E3779B97F4A7C15ull ^ n;
+        for (RandomIt &s : sample) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            s = first + static_cast<std::ptrdiff_t>(state % n);
+        }
+        auto derefLess = [&less](RandomIt x, RandomIt y) { return less(*x, *y); };
+        introSort(sample.begin(), sample.end(), depthLimit(sample.size()), derefLess);
+
+        std::vector<RandomIt> splitters;
+        for (size_t i = 1; i <= wanted; ++i) {
+            RandomIt s = sample[i * OVERSAMPLE];
+            if (splitters.empty() || less(*splitters.back(), *s)) {
+                splitters.push_back(s);
+            }
+        }
+        size_t m        = splitters.size();
+        size_t nBuckets = 2 * m + 1;
+
+        // 2. Classify; bucket 2i holds keys between splitters i-1 and i,
+        //    bucket 2i+1 keys equal to splitter i
+        size_t nBlocks   = threads * 4;
+        size_t blockSize = (n + nBlocks - 1) / nBlocks;
+        nBlocks          = (n + blockSize - 1) / blockSize;
+        std::unique_ptr<uint8_t[]> bucketOf(new uint8_t[n]);
+        std::vector<size_t> offsets(nBlocks * nBuckets, 0);
+
+        parallelFor(pool, n, nBlocks, [&](size_t begin, size_t end) {
+            size_t *count = &offsets[(begin / blockSize) * nBuckets];
+            for (size_t i = begin; i < end; ++i) {
+                auto &item = first[i];
+                size_t lo = 0, hi = m;
+                while (lo < hi) {
+                    size_t mid = (lo + hi) / 2;
+                    if (less(*splitters[mid], item)) {
+                        lo = mid + 1;
+                    }
+                    else {
+                        hi = mid;
+                    }
+                }
+                size_t bucket = (lo < m && !less(item, *splitters[lo])) ? 2 * lo + 1 : 2 * lo;
+                bucketOf[i] = static_cast<uint8_t>(bucket);
+                count[bucket]++;
+            }
+        });
+
+        // 3. Turn counts into write positions, bucket by bucket
+        std::vector<size_t> bucketStart(nBuckets + 1);
+        size_t position = 0;
+        for (size_t bucket = 0; bucket < nBuckets; ++bucket) {
+            bucketStart[bucket] = position;
+            for (size_t block = 0; block < nBlocks; ++block) {
+                size_t count = offsets[block * nBuckets + bucket];
+                offsets[block * nBuckets + bucket] = position;
+                position += count;
+            }
+        }
+        bucketStart[nBuckets] = n;
+
+        ScratchBuffer<T> buffer(n);
+        parallelFor(pool, n, nBlocks, [&](size_t begin, size_t end) {
+            size_t *next = &offsets[(begin / blockSize) * nBuckets];
+            for (size_t i = begin; i < end; ++i) {
+                ::new (static_cast<void *>(buffer.data + next[bucketOf[i]]++)) T(std::move(first[i]));
+            }
+        });
+
+        // 4. Sort the buckets and move them home
+        TaskGroup group(pool);
+        for (size_t bucket = 0; bucket < nBuckets; ++bucket) {
+            size_t begin = bucketStart[bucket];
+            size_t end   = bucketStart[bucket + 1];
+            if (begin == end) {
+                continue;
+            }
+            group.run([&, bucket, begin, end] {
+                T *data = buffer.data;
+                if (bucket % 2 == 0) {
+                    introSort(data + begin, data + end, depthLimit(end - begin), less);
+                }
+                std::move(data + begin, data + end, first + begin);
+                std::destroy(data + begin, data + end);
+            });
+        }
+        group.wait();
+    }
+
+} // namespace sorting_detail
+
+//**PARALLEL SAMPLE SORT**//
+/* *
+ *  Description: Multi-threaded sort on a WorkStealingPool. One round of
+ *               sample sort splits the range into up to 255 buckets by
+ *               sampled splitters, scattering in parallel, then the
+ *               buckets are sorted in parallel. Usually the fastest
+ *               parallel sort here; needs n extra elements and n bytes of
+ *               scratch. Not stable.
+ *
+ *               Ranges of sequentialThreshold elements or fewer, or a
+ *               single thread, fall back to quickSort. The overload
+ *               without a pool creates one with numThreads workers
+ *               (0 = one per hardware thread) for the call; pass a pool
+ *               to reuse its threads across sorts.
+ *
+ *               Sorting time: O(n log n / threads) expected
+ */
+template <typename RandomIt, typename Compare = std::less<>, typename Projection = SortIdentity>
+void parallelSampleSort(WorkStealingPool &pool, RandomIt first, RandomIt last, Compare comp = Compare(),
+                        Projection proj = Projection(), size_t sequentialThreshold = PARALLEL_SORT_THRESHOLD) {
+    auto less = sorting_detail::makeLess(comp, proj);
+    size_t n  = static_cast<size_t>(last - first);
+    if (n <= sequentialThreshold || n < 2 || pool.getNumThreads() < 2) {
+        quickSort(first, last, comp, proj);
+        return;
+    }
+    sorting_detail::parallelSampleSort(pool, first, last, less);
+}
+
+template <typename RandomIt, typename Compare = std::less<>, typename Projection = SortIdentity>
+void parallelSampleSort(RandomIt first, RandomIt last, Compare comp = Compare(), Projection proj = Projection(),
+                        unsigned numThreads = 0, size_t sequentialThreshold = PARALLEL_SORT_THRESHOLD) {
+    if (static_cast<size_t>(last - first) <= sequentialThreshold || numThreads == 1) {
+        quickSort(first, last, comp, proj);
+        return;
+    }
+    WorkStealingPool pool(numThreads);
+    parallelSampleSort(pool, first, last, comp, proj, sequentialThreshold);
+}
+
+//**PARALLEL MERGE SORT**//
+/* *
+ *  Description: Multi-threaded merge sort on a WorkStealingPool. Halves
+ *               are sorted in parallel down to sequentialThreshold
+ *               elements, where quickSort takes over, and the merges are
+ *               themselves split and run in parallel. Needs n extra
+ *               elements of scratch. Not stable, since the pieces below
+ *               the threshold are sorted with quickSort.
+ *
+ *               Thread count and fallback as for parallelSampleSort.
+ *
+ *               Sorting time: O(n log n / threads)
+ */
+template <typename RandomIt, typename Compare = std::less<>, typename Projection = SortIdentity>
+void parallelMergeSort(WorkStealingPool &pool, RandomIt first, RandomIt last, Compare comp = Compare(),
+                       Projection proj = Projection(), size_t sequentialThreshold = PARALLEL_SORT_THRESHOLD) {
+    auto less = sorting_detail::makeLess(comp, proj);
+    size_t n  = static_cast<size_t>(last - first);
+    // Below 2 a split or merge could hand its whole input to one half
+    sequentialThreshold = std::max<size_t>(sequentialThreshold, 2);
+    if (n <= sequentialThreshold || pool.getNumThreads() < 2) {
+        quickSort(first, last, comp, proj);
+        return;
+    }
+    sorting_detail::parallelMergeSort(pool, first, last, less, sequentialThreshold);
+}
+
+template <typename RandomIt, typename Compare = std::less<>, typename Projection = SortIdentity>
+void parallelMergeSort(RandomIt first, RandomIt last, Compare comp = Compare(), Projection proj = Projection(),
+                       unsigned numThreads = 0, size_t sequentialThreshold = PARALLEL_SORT_THRESHOLD) {
+    sequentialThreshold = std::max<size_t>(sequentialThreshold, 2);
+    if (static_cast<size_t>(last - first) <= sequentialThreshold || numThreads == 1) {
+        quickSort(first, last, comp, proj);
+        return;
+    }
+    WorkStealingPool pool(numThreads);
+    parallelMergeSort(pool, first, last, comp, proj, sequentialThreshold);
+}
+
+// Helpers for the radix sorts.
+namespace sorting_detail {
+
+    // Maps an arithmetic key to unsigned bits whose unsigned order is
+    // the key's order. Signed integers get their sign bit flipped.
+    // Floats get every bit flipped when negative and just the sign bit
+    // when positive, which puts -0.0 before +0.0 and NaNs at the ends.
+    template <typename T, typename Enable = void>
+    struct RadixKey;
+
+    template <typename T>
+    struct RadixKey<T, typename std::enable_if<std::is_integral<T>::value>::type> {
+        typedef typename std::make_unsigned<T>::type Bits;
+        static constexpr Bits FLIP = std::is_signed<T>::value ? Bits(Bits(1) << (sizeof(T) * 8 - 1)) : Bits(0);
+
+        static Bits encode(T value) { return Bits(Bits(value) ^ FLIP); }
+        static T decode(Bits bits)  { return T(Bits(bits ^ FLIP)); }
+    };
+
+    template <typename T>
+    struct RadixKey<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+        static_assert(sizeof(T) == 4 || sizeof(T) == 8, "radix sort supports float and double");
+        typedef typename std::conditional<sizeof(T) == 4, uint32_t, uint64_t>::type Bits;
+        static constexpr Bits SIGN = Bits(1) << (sizeof(T) * 8 - 1);
+
+        static Bits encode(T value) {
+            Bits bits;
+            std::memcpy(&bits, &value, sizeof(T));
+            return (bits & SIGN) ? Bits(~bits) : Bits(bits | SIGN);
+        }
+        static T decode(Bits bits) {
+            bits = (bits & SIGN) ? Bits(bits & ~SIGN) : Bits(~bits);
+            T value;
+            std::memcpy(&value, &bits, sizeof(T));
+            return value;
+        }
+    };
+
+    // Key types RadixKey handles: integers other than bool, float and
+    // double
+    template <typename T>
+    struct IsRadixKey
+        : std::integral_constant<bool, (std::is_integral<T>::value && !std::is_same<T, bool>::value) ||
+                                           std::is_same<T, float>::value || std::is_same<T, double>::value> { };
+
+    //**LSD RADIX PASSES**//
+    //
+    // Sorts keys[0..n) by 8 bit digits, least significant first, moving
+    // idx[] along with them when it is not null. All the digit counts
+    // come from one read pass, and a digit position where every key
+    // agrees is skipped. The arrays ping-pong with the tmp arrays; on
+    // return keys and idx point at whichever holds the result.
+    template <typename Bits, typename Index>
+    void lsdRadixPasses(Bits *&keys, Bits *&keysTmp, Index *&idx, Index *&idxTmp, size_t n) {
+        const int PASSES = sizeof(Bits);
+        std::vector<size_t> counts(PASSES * 256, 0);
+        for (size_t i = 0; i < n; ++i) {
+            Bits key = keys[i];
+            for (int p = 0; p < PASSES; ++p) {
+                counts[p * 256 + ((key >> (8 * p)) & 0xFF)]++;
+            }
+        }
+
+        for (int p = 0; p < PASSES; ++p) {
+            size_t *count = &counts[p * 256];
+            int shift     = 8 * p;
+            if (count[(keys[0] >> shift) & 0xFF] == n) {
+                continue;
+            }
+
+            size_t position = 0;
+            for (int d = 0; d < 256; ++d) {
+                size_t c = count[d];
+                count[d] = position;
+                position += c;
+            }
+            for (size_t i = 0; i < n; ++i) {
+                size_t to = count[(keys[i] >> shift) & 0xFF]++;
+                keysTmp[to] = keys[i];
+                if (idx) {
+                    idxTmp[to] = idx[i];
+                }
+            }
+            std::swap(keys, keysTmp);
+            std::swap(idx, idxTmp);
+        }
+    }
+
+    // Stable sort of records by an arithmetic key: radix sort (key,
+    // index) pairs, then move each record once into place.
+    template <typename Index, typename RandomIt, typename KeyFn>
+    void radixSortByKey(RandomIt first, size_t n, KeyFn &key) {
+        typedef typename std::iterator_traits<RandomIt>::value_type T;
+        typedef typename std::decay<decltype(std::invoke(key, *first))>::type K;
+        static_assert(IsRadixKey<K>::value, "radixSortByKey needs an integer (not bool), float or double key");
+        typedef RadixKey<K> Map;
+        typedef typename Map::Bits Bits;
+
+        std::vector<Bits>  keyBuffer(2 * n);
+        std::vector<Index> idxBuffer(2 * n);
+        Bits  *keys = keyBuffer.data(), *keysTmp = keys + n;
+        Index *idx  = idxBuffer.data(), *idxTmp  = idx + n;
+        for (size_t i = 0; i < n; ++i) {
+            keys[i] = Map::encode(std::invoke(key, first[i]));
+            idx[i]  = static_cast<Index>(i);
+        }
+        lsdRadixPasses(keys, keysTmp, idx, idxTmp, n);
+
+        ScratchBuffer<T> records(n);
+        for (size_t i = 0; i < n; ++i) {
+            ::new (static_cast<void *>(records.data + i)) T(std::move(first[idx[i]]));
+        }
+        std::move(records.data, records.data + n, first);
+        std::destroy(records.data, records.data + n);
+    }
+
+    //**AMERICAN FLAG SORT**//
+    //
+    // In-place MSD radix sort for byte strings. Each pass counts the
+    // byte at depth (strings that have ended count as a digit below
+    // every byte), then permutes the range into its 257 buckets by
+    // following swap cycles, and queues every bucket that still needs
+    // sorting at depth + 1. Small buckets are insertion sorted on their
+    // remaining suffix. Ranges are kept on an explicit stack, so long
+    // shared prefixes cannot overflow the call stack.
+    template <typename S>
+    inline int stringDigit(const S &s, size_t depth) {
+        return depth < s.size() ? static_cast<unsigned char>(s[depth]) + 1 : 0;
+    }
+
+    template <typename S>
+    bool suffixLess(const S &a, const S &b, size_t depth) {
+        size_t na = a.size(), nb = b.size();
+        for (size_t i = depth; i < na && i < nb; ++i) {
+            unsigned char ca = static_cast<unsigned char>(a[i]);
+            unsigned char cb = static_cast<unsigned char>(b[i]);
+            if (ca != cb) {
+                return ca < cb;
+            }
+        }
+        return na < nb;
+    }
+
+    template <typename RandomIt>
+    void americanFlagSort(RandomIt first, RandomIt last) {
+        struct Range {
+            RandomIt first, last;
+            size_t   depth;
+        };
+        std::vector<Range> ranges;
+        ranges.push_back(Range{first, last, 0});
+
+        size_t count[257];
+        size_t next[257];
+        size_t end[257];
+
+        while (!ranges.empty()) {
+            Range r = ranges.back();
+            ranges.pop_back();
+            size_t n = static_cast<size_t>(r.last - r.first);
+
+            if (n <= size_t(STRING_RADIX_THRESHOLD)) {
+                auto less = [depth = r.depth](const auto &a, const auto &b) { return suffixLess(a, b, depth); };
+                sorting_detail::insertionSort(r.first, r.last, less);
+                continue;
+            }
+
+            std::fill(count, count + 257, 0);
+            for (RandomIt it = r.first; it != r.last; ++it) {
+                count[stringDigit(*it, r.depth)]++;
+            }
+
+            // Everything shares this byte: just look at the next one
+            int d0 = stringDigit(*r.first, r.depth);
+            if (count[d0] == n) {
+                if (d0 != 0) {
+                    ranges.push_back(Range{r.first, r.last, r.depth + 1});
+                }
+                continue;
+            }
+
+            size_t position = 0;
+            for (int d = 0; d < 257; ++d) {
+                next[d] = position;
+                position += count[d];
+                end[d] = position;
+            }
+            for (int d = 0; d < 257; ++d) {
+                while (next[d] < end[d]) {
+                    auto &item = r.first[next[d]];
+                    int digit  = stringDigit(item, r.depth);
+                    while (digit != d) {
+                        std::swap(item, r.first[next[digit]++]);
+                        digit = stringDigit(item, r.depth);
+                    }
+                    next[d]++;
+                }
+            }
+
+            // Bucket 0 holds strings that ended here, which are all equal
+            size_t begin = count[0];
+            for (int d = 1; d < 257; ++d) {
+                if (count[d] > 1) {
+                    ranges.push_back(Range{r.first + begin, r.first + begin + count[d], r.depth + 1});
+                }
+                begin += count[d];
+            }
+        }
+    }
+
+    template <typename T>
+    struct IsByteString : std::false_type { };
+
+    template <typename Traits, typename Alloc>
+    struct IsByteString<std::basic_string<char, Traits, Alloc>> : std::true_type { };
+
+    template <typename Traits>
+    struct IsByteString<std::basic_string_view<char, Traits>> : std::true_type { };
+
+} // namespace sorting_detail
+
+//**RADIX SORT**//
+/* *
+ *  Description: Linear time sort for integers, floats and strings.
+ *
+ *               Integers (8 to 64 bit, signed or unsigned), float and
+ *               double: LSD radix sort on 8 bit digits, with keys mapped
+ *               so their unsigned bit patterns sort in numeric order.
+ *               Digit positions where all keys agree are skipped, so
+ *               small values in wide types cost fewer passes. Needs two
+ *               scratch arrays of n keys. Stable.
+ *
+ *               std::string and std::string_view: American flag sort
+ *               (in-place MSD radix sort) in byte order. Not stable.
+ *
+ *               Ranges of RADIX_SORT_THRESHOLD elements or fewer go to
+ *               quickSort (or insertion sort for strings) instead.
+ *
+ *               Sorting time: O(n * key bytes)
+ */
+template <typename RandomIt>
+typename std::enable_if<sorting_detail::IsRadixKey<typename std::iterator_traits<RandomIt>::value_type>::value>::type
+radixSort(RandomIt first, RandomIt last) {
+    typedef typename std::iterator_traits<RandomIt>::value_type T;
+    typedef sorting_detail::RadixKey<T> Map;
+    typedef typename Map::Bits Bits;
+
+    size_t n = static_cast<size_t>(last - first);
+    if (n <= size_t(RADIX_SORT_THRESHOLD)) {
+        quickSort(first, last, [](T a, T b) { return Map::encode(a) < Map::encode(b); });
+        return;
+    }
+
+    std::vector<Bits> buffer(2 * n);
+    Bits *keys = buffer.data(), *tmp = keys + n;
+    for (size_t i = 0; i < n; ++i) {
+        keys[i] = Map::encode(first[i]);
+    }
+    unsigned char *noIndex = nullptr, *noIndexTmp = nullptr;
+    sorting_detail::lsdRadixPasses(keys, tmp, noIndex, noIndexTmp, n);
+    for (size_t i = 0; i < n; ++i) {
+        first[i] = Map::decode(keys[i]);
+    }
+}
+
+template <typename RandomIt>
+typename std::enable_if<sorting_detail::IsByteString<typename std::iterator_traits<RandomIt>::value_type>::value>::type
+radixSort(RandomIt first, RandomIt last) {
+    sorting_detail::americanFlagSort(first, last);
+}
+
+template <typename T, size_t size>
+void radixSort(T (&array)[size]) {
+    radixSort(array, array + size);
+}
+
+//**RADIX SORT BY KEY**//
+/* *
+ *  Description: Sorts records by an integer or floating point key taken
+ *               from each one by key(record), which may be a function or
+ *               a pointer to member:
+ *
+ *                   radixSortByKey(rows.begin(), rows.end(), &Row::timestamp);
+ *
+ *               The keys are extracted once and radix sorted together
+ *               with record indices, then every record is moved exactly
+ *               once, so large records are cheap to sort. Stable.
+ *
+ *               Sorting time: O(n * key bytes)
+ */
+template <typename RandomIt, typename KeyFn>
+void radixSortByKey(RandomIt first, RandomIt last, KeyFn key) {
+    size_t n = static_cast<size_t>(last - first);
+    if (n < 2) {
+        return;
+    }
+    if (n <= size_t(UINT32_MAX)) {
+        sorting_detail::radixSortByKey<uint32_t>(first, n, key);
+    }
+    else {
+        sorting_detail::radixSortByKey<size_t>(first, n, key);
+    }
+}
+
+// Helpers for timSort.
+namespace sorting_detail {
+
+    //**RUN DETECTION**//
+    //
+    // Length of the run starting at first. A strictly descending run is
+    // reversed in place; runs with equal neighbours count as ascending,
+    // so reversing never reorders equal elements.
+    template <typename RandomIt, typename Less>
+    size_t countRun(RandomIt first, RandomIt last, Less &less) {
+        size_t n = static_cast<size_t>(last - first);
+        if (n < 2) {
+            return n;
+        }
+        size_t run = 2;
+        if (less(first[1], first[0])) {
+            while (run < n && less(first[run], first[run - 1])) {
+                run++;
+            }
+            for (size_t i = 0, j = run - 1; i < j; ++i, --j) {
+                std::swap(first[i], first[j]);
+            }
+        }
+        else {
+            while (run < n && !less(first[run], first[run - 1])) {
+                run++;
+            }
+        }
+        return run;
+    }
+
+    //**BINARY INSERTION SORT**//
+    //
+    // Insertion sorts [sorted, last) into the already sorted [first,
+    // sorted). Each item goes after any equal to it.
+    template <typename RandomIt, typename Less>
+    void binaryInsertionSort(RandomIt first, RandomIt sorted, RandomIt last, Less &less) {
+        for (RandomIt i = sorted; i != last; ++i) {
+            auto item = std::move(*i);
+            RandomIt lo = first, hi = i;
+            while (lo < hi) {
+                RandomIt mid = lo + (hi - lo) / 2;
+                if (less(item, *mid)) {
+                    hi = mid;
+                }
+                else {
+                    lo = mid + 1;
+                }
+            }
+            std::move_backward(lo, i, i + 1);
+            *lo = std::move(item);
+        }
+    }
+
+    //**GALLOP**//
+    //
+    // Exponential then binary search of the sorted a[0..n) for key,
+    // starting at a[hint]. gallopLeft returns the first position whose
+    // element is not less than key, gallopRight the first whose element
+    // is greater than key. Cheap when the answer is close to hint.
+    template <typename T, typename It, typename Less>
+    ptrdiff_t gallopLeft(const T &key, It a, ptrdiff_t n, ptrdiff_t hint, Less &less) {
+        ptrdiff_t lastOfs = 0, ofs = 1;
+        if (less(a[hint], key)) {
+            ptrdiff_t maxOfs = n - hint;
+            while (ofs < maxOfs && less(a[hint + ofs], key)) {
+                lastOfs = ofs;
+                ofs = 2 * ofs + 1;
+            }
+            ofs = std::min(ofs, maxOfs);
+            lastOfs += hint;
+            ofs += hint;
+        }
+        else {
+            ptrdiff_t maxOfs = hint + 1;
+            while (ofs < maxOfs && !less(a[hint - ofs], key)) {
+                lastOfs = ofs;
+                ofs = 2 * ofs + 1;
+            }
+            ofs = std::min(ofs, maxOfs);
+            ptrdiff_t below = hint - ofs;
+            ofs = hint - lastOfs;
+            lastOfs = below;
+        }
+        // a[lastOfs] < key <= a[ofs]
+        lastOfs++;
+        while (lastOfs < ofs) {
+            ptrdiff_t mid = lastOfs + (ofs - lastOfs) / 2;
+            if (less(a[mid], key)) {
+                lastOfs = mid + 1;
+            }
+            else {
+                ofs = mid;
+            }
+        }
+        return ofs;
+    }
+
+    template <typename T, typename It, typename Less>
+    ptrdiff_t gallopRight(const T &key, It a, ptrdiff_t n, ptrdiff_t hint, Less &less) {
+        ptrdiff_t lastOfs = 0, ofs = 1;
+        if (less(key, a[hint])) {
+            ptrdiff_t maxOfs = hint + 1;
+            while (ofs < maxOfs && less(key, a[hint - ofs])) {
+                lastOfs = ofs;
+                ofs = 2 * ofs + 1;
+            }
+            ofs = std::min(ofs, maxOfs);
+            ptrdiff_t below = hint - ofs;
+            ofs = hint - lastOfs;
+            lastOfs = below;
+        }
+        else {
+            ptrdiff_t maxOfs = n - hint;
+            while (ofs < maxOfs && !less(key, a[hint + ofs])) {
+                lastOfs = ofs;
+                ofs = 2 * ofs + 1;
+            }
+            ofs = std::min(ofs, maxOfs);
+            lastOfs += hint;
+            ofs += hint;
+        }
+        // a[lastOfs] <= key < a[ofs]
+        lastOfs++;
+        while (lastOfs < ofs) {
+            ptrdiff_t mid = lastOfs + (ofs - lastOfs) / 2;
+            if (less(key, a[mid])) {
+                ofs = mid;
+            }
+            else {
+                lastOfs = mid + 1;
+            }
+        }
+        return ofs;
+    }
+
+    // Stretches of this many wins in a row switch a merge to galloping.
+    static const size_t MIN_GALLOP = 7;
+
+    //**MERGE LOW**//
+    //
+    // Merges [first, middle) and [middle, last), with the left run
+    // moved out to buffer and merged back from the front. Each side
+    // counts how many times in a row it has won; once one side wins
+    // minGallop times the merge gallops, copying whole stretches found
+    // by gallopLeft/Right, and drops back once stretches get short.
+    // minGallop adapts across merges to how well galloping has paid.
+    template <typename RandomIt, typename T, typename Less>
+    void mergeLow(RandomIt first, RandomIt middle, RandomIt last, T *buffer, Less &less, size_t &minGallop) {
+        T *a = buffer, *aEnd = std::move(first, middle, buffer);
+        RandomIt b = middle, out = first;
+
+        while (a != aEnd && b != last) {
+            size_t winsA = 0, winsB = 0;
+            while (a != aEnd && b != last) {
+                if (less(*b, *a)) {
+                    *out++ = std::move(*b++);
+                    winsA = 0;
+                    if (++winsB >= minGallop) {
+                        break;
+                    }
+                }
+                else {
+                    *out++ = std::move(*a++);
+                    winsB = 0;
+                    if (++winsA >= minGallop) {
+                        break;
+                    }
+                }
+            }
+
+            while (a != aEnd && b != last) {
+                if (minGallop > 1) {
+                    minGallop--;
+                }
+                size_t k = static_cast<size_t>(gallopRight(*b, a, aEnd - a, 0, less));
+                out = std::move(a, a + k, out);
+                a += k;
+                winsA = k;
+                if (a == aEnd) {
+                    break;
+                }
+                *out++ = std::move(*b++);
+                if (b == last) {
+                    break;
+                }
+                k = static_cast<size_t>(gallopLeft(*a, b, last - b, 0, less));
+                out = std::move(b, b + k, out);
+                b += k;
+                winsB = k;
+                if (b == last) {
+                    break;
+                }
+                *out++ = std::move(*a++);
+                if (winsA < MIN_GALLOP && winsB < MIN_GALLOP) {
+                    minGallop++;
+                    break;
+                }
+            }
+        }
+        std::move(a, aEnd, out);
+    }
+
+    //**MERGE HIGH**//
+    //
+    // mergeLow mirrored: the right run is moved out to buffer and the
+    // two are merged from the back.
+    template <typename RandomIt, typename T, typename Less>
+    void mergeHigh(RandomIt first, RandomIt middle, RandomIt last, T *buffer, Less &less, size_t &minGallop) {
+        T *b = buffer, *bEnd = std::move(middle, last, buffer);
+        RandomIt a = middle, out = last;
+
+        while (a != first && bEnd != b) {
+            size_t winsA = 0, winsB = 0;
+            while (a != first && bEnd != b) {
+                if (less(*(bEnd - 1), *(a - 1))) {
+                    *--out = std::move(*--a);
+                    winsB = 0;
+                    if (++winsA >= minGallop) {
+                        break;
+                    }
+                }
+                else {
+                    *--out = std::move(*--bEnd);
+                    winsA = 0;
+                    if (++winsB >= minGallop) {
+                        break;
+                    }
+                }
+            }
+
+            while (a != first && bEnd != b) {
+                if (minGallop > 1) {
+                    minGallop--;
+                }
+                ptrdiff_t lenA = a - first;
+                size_t k = static_cast<size_t>(lenA - gallopRight(*(bEnd - 1), first, lenA, lenA - 1, less));
+                out = std::move_backward(a - k, a, out);
+                a -= k;
+                winsA = k;
+                if (a == first) {
+                    break;
+                }
+                *--out = std::move(*--bEnd);
+                if (bEnd == b) {
+                    break;
+                }
+                ptrdiff_t lenB = bEnd - b;
+                k = static_cast<size_t>(lenB - gallopLeft(*(a - 1), b, lenB, lenB - 1, less));
+                out = std::move_backward(bEnd - k, bEnd, out);
+                bEnd -= k;
+                winsB = k;
+                if (bEnd == b) {
+                    break;
+                }
+                *--out = std::move(*--a);
+                if (winsA < MIN_GALLOP && winsB < MIN_GALLOP) {
+                    minGallop++;
+                    break;
+                }
+            }
+        }
+        std::move(b, bEnd, out - (bEnd - b));
+    }
+
+    //**ROTATE**//
+    //
+    // Swaps the blocks [first, middle) and [middle, last) by three
+    // reversals; returns where the old first element ended up.
+    template <typename RandomIt>
+    void reverseRange(RandomIt first, RandomIt last) {
+        while (first < last && first < --last) {
+            std::swap(*first++, *last);
+        }
+    }
+
+    template <typename RandomIt>
+    RandomIt rotateRange(RandomIt first, RandomIt middle, RandomIt last) {
+        reverseRange(first, middle);
+        reverseRange(middle, last);
+        reverseRange(first, last);
+        return first + (last - middle);
+    }
+
+    //**MERGE RUNS**//
+    //
+    // Stably merges the sorted runs [first, middle) and [middle, last).
+    // The ends of the runs that are already in place are galloped off
+    // first. If the shorter run fits in buffer the merge is done by
+    // mergeLow/High; otherwise the runs are split (the middle of the
+    // longer, and where it falls in the shorter), the inner pieces
+    // swapped by a rotation, and both halves merged on their own. With
+    // no buffer at all that is an in-place O(n log n) merge.
+    template <typename RandomIt, typename T, typename Less>
+    void mergeRuns(RandomIt first, RandomIt middle, RandomIt last, T *buffer, size_t bufferSize,
+                   Less &less, size_t &minGallop) {
+        if (first == middle || middle == last) {
+            return;
+        }
+        first += gallopRight(*middle, first, middle - first, 0, less);
+        if (first == middle) {
+            return;
+        }
+        last = middle + gallopLeft(*(middle - 1), middle, last - middle, (last - middle) - 1, less);
+        if (middle == last) {
+            return;
+        }
+
+        size_t lenA = static_cast<size_t>(middle - first);
+        size_t lenB = static_cast<size_t>(last - middle);
+        if (lenA <= lenB && lenA <= bufferSize) {
+            mergeLow(first, middle, last, buffer, less, minGallop);
+            return;
+        }
+        if (lenB < lenA && lenB <= bufferSize) {
+            mergeHigh(first, middle, last, buffer, less, minGallop);
+            return;
+        }
+
+        RandomIt cutA, cutB;
+        if (lenA >= lenB) {
+            cutA = first + lenA / 2;
+            cutB = middle + gallopLeft(*cutA, middle, last - middle, 0, less);
+        }
+        else {
+            cutB = middle + lenB / 2;
+            cutA = first + gallopRight(*cutB, first, middle - first, 0, less);
+        }
+        RandomIt newMiddle = rotateRange(cutA, middle, cutB);
+        mergeRuns(first, cutA, newMiddle, buffer, bufferSize, less, minGallop);
+        mergeRuns(newMiddle, cutB, last, buffer, bufferSize, less, minGallop);
+    }
+
+    //**NODE POWER**//
+    //
+    // Powersort's merge priority for the adjacent runs [begin, middle)
+    // and [middle, end) of an n element array: the depth at which the
+    // run midpoints, as fractions of n, first fall in different halves
+    // of a binary subdivision of [0, 1).
+    inline unsigned nodePower(size_t begin, size_t middle, size_t end, size_t n) {
+        size_t a = begin + middle, b = middle + end, n2 = 2 * n;
+        unsigned power = 0;
+        for (;;) {
+            power++;
+            a *= 2;
+            b *= 2;
+            bool aHigh = a >= n2, bHigh = b >= n2;
+            if (aHigh != bHigh) {
+                return power;
+            }
+            if (aHigh) {
+                a -= n2;
+                b -= n2;
+            }
+        }
+    }
+
+    // Runs shorter than this are extended by binary insertion sort.
+    inline size_t minRunLength(size_t n) {
+        size_t extra = 0;
+        while (n >= 64) {
+            extra |= n & 1;
+            n >>= 1;
+        }
+        return n + extra;
+    }
+
+    //**TIM SORT**//
+    //
+    // Finds the natural runs left to right (extending short ones to
+    // minRunLength), and keeps a stack of runs waiting to be merged.
+    // Each new run boundary gets a node power; runs on the stack whose
+    // boundary has a higher power are merged first (powersort), which
+    // keeps merges balanced and the stack O(log n) deep.
+    template <typename RandomIt, typename T, typename Less>
+    void timSort(RandomIt first, RandomIt last, T *buffer, size_t bufferSize, Less &less) {
+        struct Run {
+            size_t   begin, length;
+            unsigned power;
+        };
+        Run stack[85];
+        int top = 0;
+
+        size_t n = static_cast<size_t>(last - first);
+        size_t minRun = minRunLength(n);
+        size_t minGallop = MIN_GALLOP;
+
+        auto nextRun = [&](size_t begin) {
+            size_t length = countRun(first + begin, last, less);
+            if (length < minRun) {
+                size_t extended = std::min(minRun, n - begin);
+                binaryInsertionSort(first + begin, first + begin + length, first + begin + extended, less);
+                length = extended;
+            }
+            return length;
+        };
+
+        size_t begin = 0, length = nextRun(0);
+        while (begin + length < n) {
+            size_t nextBegin = begin + length;
+            size_t nextLength = nextRun(nextBegin);
+            unsigned power = nodePower(begin, nextBegin, nextBegin + nextLength, n);
+
+            while (top > 0 && stack[top - 1].power > power) {
+                Run &run = stack[--top];
+                mergeRuns(first + run.begin, first + begin, first + begin + length, buffer, bufferSize,
+                          less, minGallop);
+                begin = run.begin;
+                length += run.length;
+            }
+            stack[top++] = Run{begin, length, power};
+            begin  = nextBegin;
+            length = nextLength;
+        }
+        while (top > 0) {
+            Run &run = stack[--top];
+            mergeRuns(first + run.begin, first + begin, first + begin + length, buffer, bufferSize,
+                      less, minGallop);
+            begin = run.begin;
+            length += run.length;
+        }
+    }
+
+} // namespace sorting_detail
+
+//**TIM SORT**//
+/* *
+ *  Description: Stable adaptive merge sort. Natural runs (ascending, or
+ *               strictly descending and reversed) are found and merged
+ *               in powersort order, and merges gallop through stretches
+ *               where one run keeps winning. Input made of a few sorted
+ *               stretches sorts in close to linear time, and sorting
+ *               by one key and then stably by another gives a multi-key
+ *               order.
+ *
+ *               Needs scratch space for n / 2 elements, which timSort
+ *               allocates; if that is not possible it merges in place
+ *               by rotations instead (O(n log^2 n), no extra memory).
+ *               timSortBuffered takes the scratch space from the caller:
+ *               buffer holds bufferSize constructed elements, which are
+ *               left in a valid but unspecified state. Any size works,
+ *               merges of runs too big for it are done in place.
+ *
+ *               Sorting time: O(n log n), O(n) on presorted input
+ */
+template <typename RandomIt, typename Compare = std::less<>, typename Projection = SortIdentity>
+void timSortBuffered(RandomIt first, RandomIt last, typename std::iterator_traits<RandomIt>::value_type *buffer,
+                     size_t bufferSize, Compare comp = Compare(), Projection proj = Projection()) {
+    if (last - first > 1) {
+        auto less = sorting_detail::makeLess(comp, proj);
+        sorting_detail::timSort(first, last, buffer, buffer ? bufferSize : 0, less);
+    }
+}
+
+template <typename RandomIt, typename Compare = std::less<>, typename Projection = SortIdentity>
+void timSort(RandomIt first, RandomIt last, Compare comp = Compare(), Projection proj = Projection()) {
+    typedef typename std::iterator_traits<RandomIt>::value_type T;
+    size_t n = static_cast<size_t>(last - first);
+    if (n < 2) {
+        return;
+    }
+
+    std::unique_ptr<T[]> buffer;
+    if constexpr (std::is_default_constructible<T>::value) {
+        if (n > 64) {
+            buffer.reset(new (std::nothrow) T[n / 2]);
+        }
+    }
+    timSortBuffered(first, last, buffer.get(), n / 2, comp, proj);
+}
+
+template <typename T, size_t size>
+void timSort(T (&array)[size]) {
+    timSort(array, array + size);
+}
+
+#ifdef SORTING_SPAN
+//**SPAN OVERLOADS**//
+/* *
+ *  Description: The sorts above for a std::span, e.g. quickSort(std::span(v)).
+ */
+template <typename T, size_t Extent, typename Compare = std::less<>, typename Projection = SortIdentity>
+void bubbleSort(std::span<T, Extent> s, Compare comp = Compare(), Projection proj = Projection()) {
+    bubbleSort(s.begin(), s.end(), std::move(comp), std::move(proj));
+}
+
+template <typename T, size_t Extent, typename Compare = std::less<>, typename Projection = SortIdentity>
+void selectionSort(std::span<T, Extent> s, Compare comp = Compare(), Projection proj = Projection()) {
+    selectionSort(s.begin(), s.end(), std::move(comp), std::move(proj));
+}
+
+template <typename T, size_t Extent, typename Compare = std::less<>, typename Projection = SortIdentity>
+void insertionSort(std::span<T, Extent> s, Compare comp = Compare(), Projection proj = Projection()) {
+    insertionSort(s.begin(), s.end(), std::move(comp), std::move(proj));
+}
+
+template <typename T, size_t Extent, typename Compare = std::less<>, typename Projection = SortIdentity>
+void heapSort(std::span<T, Extent> s, Compare comp = Compare(), Projection proj = Projection()) {
+    heapSort(s.begin(), s.end(), std::move(comp), std::move(proj));
+}
+
+template <typename T, size_t Extent, typename Compare = std::less<>, typename Projection = SortIdentity>
+void quickSort(std::span<T, Extent> s, Compare comp = Compare(), Projection proj = Projection()) {
+    quickSort(s.begin(), s.end(), std::move(comp), std::move(proj));
+}
+
+template <typename T, size_t Extent, typename Compare = std::less<>, typename Projection = SortIdentity>
+void nthElement(std::span<T, Extent> s, size_t nth, Compare comp = Compare(), Projection proj = Projection()) {
+    nthElement(s.begin(), s.begin() + nth, s.end(), comp, proj);
+}
+
+template <typename T, size_t Extent, typename Compare = std::less<>, typename Projection = SortIdentity>
+void partialSort(std::span<T, Extent> s, size_t k, Compare comp = Compare(), Projection proj = Projection()) {
+    partialSort(s.begin(), s.begin() + k, s.end(), comp, proj);
+}
+
+template <typename T, size_t Extent, typename Compare = std::less<>, typename Projection = SortIdentity>
+void timSort(std::span<T, Extent> s, Compare comp = Compare(), Projection proj = Projection()) {
+    timSort(s.begin(), s.end(), comp, proj);
+}
+
+template <typename T, size_t Extent>
+void radixSort(std::span<T, Extent> s) {
+    radixSort(s.begin(), s.end());
+}
+
+template <typename T, size_t Extent, typename KeyFn>
+void radixSortByKey(std::span<T, Extent> s, KeyFn key) {
+    radixSortByKey(s.begin(), s.end(), std::move(key));
+}
+
+template <typename T, size_t Extent, typename Compare = std::less<>, typename Projection = SortIdentity>
+void parallelSampleSort(std::span<T, Extent> s, Compare comp = Compare(), Projection proj = Projection(),
+                        unsigned numThreads = 0, size_t sequentialThreshold = PARALLEL_SORT_THRESHOLD) {
+    parallelSampleSort(s.begin(), s.end(), std::move(comp), std::move(proj), numThreads, sequentialThreshold);
+}
+
+template <typename T, size_t Extent, typename Compare = std::less<>, typename Projection = SortIdentity>
+void parallelMergeSort(std::span<T, Extent> s, Compare comp = Compare(), Projection proj = Projection(),
+                       unsigned numThreads = 0, size_t sequentialThreshold = PARALLEL_SORT_THRESHOLD) {
+    parallelMergeSort(s.begin(), s.end(), std::move(comp), std::move(proj), numThreads, sequentialThreshold);
 }
+#endif
 
 #endif /* Sorting.hpp */
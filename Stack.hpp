@@ -1,131 +1,414 @@
-// 
+//
 // Stack.hpp
 // CustomLibraries
 //
 // Created by Kyle Hurd on 10/21/2020
 //
+// Description
+//
+// The Stack stores its items contiguously. The first InlineCount items
+// live inside the Stack object itself (on the caller's stack frame for
+// a local Stack), so small stacks never touch the heap. Past that the
+// items move to a heap buffer that doubles as needed.
+//
+// A GROWABLE stack (the default) treats the size given to the
+// constructor as a hint and never reports full. A BOUNDED stack holds
+// at most that many items and push() returns false once it is full.
+//
+// The heap buffer comes from the memory resource given to the
+// constructor, which the stack keeps for life. Moving between stacks
+// on different resources moves the items one at a time.
+//
 
 #ifndef Stack_hpp
 #define Stack_hpp
 
-#include <iostream>
+#include <climits>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Serialization.hpp"
 
-template<class T>
+template<class T, size_t InlineCount = (sizeof(T) < 256 ? 256 / sizeof(T) : 1)>
 class Stack {
 
+public:
+    enum CapacityMode { GROWABLE, BOUNDED };
+
 private:
-    struct Node {
-        T data;
-        Node *next;
-    };
-    Node *top;
+    alignas(T) unsigned char inlineBuffer[InlineCount * sizeof(T)];
+    T *items;
 
     int numItems;
+    int capacity;       // Slots available in items
     int BufferSize;
+    CapacityMode mode;
+
+    std::pmr::polymorphic_allocator<T> alloc;
+
+    bool isInline() const;
+    void reallocate(int);
+    void release();
+    void takeFrom(Stack &&);
+    void load(BinaryReader &);
 
 public:
-    
+
     // Constructors
-    Stack(int = 0x0A);
+    Stack(int = 0x0A, CapacityMode = GROWABLE,
+          std::pmr::memory_resource * = std::pmr::get_default_resource());
+    Stack(const Stack &, std::pmr::memory_resource * = std::pmr::get_default_resource());
+    Stack(Stack &&) noexcept(std::is_nothrow_move_constructible<T>::value);
 
     // Deconstructors
     ~Stack();
 
+    // Operators
+    Stack &operator=(const Stack &);
+    Stack &operator=(Stack &&);
+
     // Functions
-    void push(T);
-    void pop();
-    T    peek();
-    bool isEmpty();
-    bool isFull();
-    int  getSize();
+    bool push(const T &);
+    bool push(T &&);
+    template<class... Args>
+    bool emplace(Args &&...);
+    T    pop();
+    T       &peek();
+    const T &peek() const;
+    void clear();
+    bool isEmpty() const;
+    bool isFull() const;
+    int  getSize() const;
+    std::pmr::memory_resource *getResource() const;
+
+    // Serialization
+    void serialize(std::ostream &) const;
+    void deserialize(std::istream &);
+    void deserialize(const MappedFile &);
 };
 
 // Initializer
-template<class T>
-Stack<T>::Stack(int n) {
-    
+//
+// n is the capacity of a BOUNDED stack, or the size to grow to the
+// first time a GROWABLE stack outgrows its inline storage. The heap
+// buffer is allocated from resource, which must outlive the stack.
+template<class T, size_t InlineCount>
+Stack<T, InlineCount>::Stack(int n, CapacityMode m, std::pmr::memory_resource *resource)
+    : alloc{resource} {
+
+    items      = reinterpret_cast<T *>(inlineBuffer);
     numItems   = 0x00;
+    capacity   = static_cast<int>(InlineCount);
     BufferSize = n;
+    mode       = m;
+}
+
+// Copy Constructor
+template<class T, size_t InlineCount>
+Stack<T, InlineCount>::Stack(const Stack &other, std::pmr::memory_resource *resource)
+    : Stack(other.BufferSize, other.mode, resource) {
+
+    if (other.numItems > capacity) {
+        reallocate(other.numItems);
+    }
+    for (int i = 0; i < other.numItems; ++i) {
+        ::new (static_cast<void *>(items + i)) T(other.items[i]);
+        ++numItems;
+    }
+}
+
+// Move Constructor
+//
+// Takes the items of other along with its memory resource.
+template<class T, size_t InlineCount>
+Stack<T, InlineCount>::Stack(Stack &&other) noexcept(std::is_nothrow_move_constructible<T>::value)
+    : Stack(other.BufferSize, other.mode, other.getResource()) {
 
-    top = nullptr;
+    takeFrom(std::move(other));
 }
 
 // Destructor
-template<class T>
-Stack<T>::~Stack() {
-    
-    // Variable Declarations
-    T temp;
-    
-    // Start of Code
-    while (!isEmpty()) {
-        pop(temp);
+template<class T, size_t InlineCount>
+Stack<T, InlineCount>::~Stack() {
+
+    release();
+}
+
+// Copy Assignment
+template<class T, size_t InlineCount>
+Stack<T, InlineCount> &Stack<T, InlineCount>::operator=(const Stack &other) {
+
+    if (this != &other) {
+        Stack copy(other, getResource());
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+// Move Assignment
+//
+// The stack keeps its own memory resource.
+template<class T, size_t InlineCount>
+Stack<T, InlineCount> &Stack<T, InlineCount>::operator=(Stack &&other) {
+
+    if (this != &other) {
+        release();
+        BufferSize = other.BufferSize;
+        mode       = other.mode;
+        takeFrom(std::move(other));
+    }
+    return *this;
+}
+
+// **Private** //
+// isInline()
+template<class T, size_t InlineCount>
+bool Stack<T, InlineCount>::isInline() const {
+    return items == reinterpret_cast<const T *>(inlineBuffer);
+}
+
+// **Private** //
+// reallocate()
+//
+// Moves the items into a heap buffer with room for newCapacity items.
+template<class T, size_t InlineCount>
+void Stack<T, InlineCount>::reallocate(int newCapacity) {
+
+    T *newItems = alloc.allocate(newCapacity);
+
+    for (int i = 0; i < numItems; ++i) {
+        ::new (static_cast<void *>(newItems + i)) T(std::move_if_noexcept(items[i]));
+        items[i].~T();
+    }
+    if (!isInline()) {
+        alloc.deallocate(items, capacity);
+    }
+    items    = newItems;
+    capacity = newCapacity;
+}
+
+// **Private** //
+// release()
+//
+// Destroys the items and returns to the empty inline buffer.
+template<class T, size_t InlineCount>
+void Stack<T, InlineCount>::release() {
+
+    clear();
+    if (!isInline()) {
+        alloc.deallocate(items, capacity);
+    }
+    items    = reinterpret_cast<T *>(inlineBuffer);
+    capacity = static_cast<int>(InlineCount);
+}
+
+// **Private** //
+// takeFrom()
+//
+// Takes the items of other, which is left empty. A heap buffer from
+// the same memory resource is stolen outright; inline items, or a
+// buffer from another resource, have to be moved one at a time.
+template<class T, size_t InlineCount>
+void Stack<T, InlineCount>::takeFrom(Stack &&other) {
+
+    if (other.isInline() || alloc != other.alloc) {
+        if (other.numItems > capacity) {
+            reallocate(other.numItems);
+        }
+        for (int i = 0; i < other.numItems; ++i) {
+            ::new (static_cast<void *>(items + i)) T(std::move(other.items[i]));
+        }
+        numItems = other.numItems;
+        other.clear();
+    }
+    else {
+        items    = other.items;
+        capacity = other.capacity;
+        numItems = other.numItems;
+
+        other.items    = reinterpret_cast<T *>(other.inlineBuffer);
+        other.capacity = static_cast<int>(InlineCount);
+        other.numItems = 0x00;
     }
-    numItems = 0x00;
 }
 
 // **Functions** //
 // isEmpty()
-template<class T>
-bool Stack<T>::isEmpty() {
-    return !top;
+template<class T, size_t InlineCount>
+bool Stack<T, InlineCount>::isEmpty() const {
+    return numItems == 0x00;
 }
 
 // isFull()
-template<class T>
-bool Stack<T>::isFull() {
-    return (BufferSize <= numItems);
+//
+// Only a BOUNDED stack can be full.
+template<class T, size_t InlineCount>
+bool Stack<T, InlineCount>::isFull() const {
+    return mode == BOUNDED && BufferSize <= numItems;
 }
 
 // size()
-template<class T>
-int Stack<T>::getSize() {
+template<class T, size_t InlineCount>
+int Stack<T, InlineCount>::getSize() const {
     return numItems;
 }
 
+// getResource()
+template<class T, size_t InlineCount>
+std::pmr::memory_resource *Stack<T, InlineCount>::getResource() const {
+    return alloc.resource();
+}
+
 // push()
-template<class T>
-void Stack<T>::push(T item) {
-    
-    // Variable Declarations
-    Node *newNode = nullptr;
-    newNode = new Node;
-    newNode->data = item;
-    
-    // Start of Code
-    if (isEmpty()) {
-        top = newNode;
-        newNode->next = nullptr;
+//
+// Returns false if the stack is BOUNDED and already full.
+template<class T, size_t InlineCount>
+bool Stack<T, InlineCount>::push(const T &item) {
+    return emplace(item);
+}
+
+template<class T, size_t InlineCount>
+bool Stack<T, InlineCount>::push(T &&item) {
+    return emplace(std::move(item));
+}
+
+// emplace()
+//
+// Constructs the new top item in place from args.
+template<class T, size_t InlineCount>
+template<class... Args>
+bool Stack<T, InlineCount>::emplace(Args &&...args) {
+
+    if (isFull()) {
+        return false;
     }
-    else {
-        newNode->next = top;
-        top = newNode;
+    if (numItems == capacity) {
+        int newCapacity = capacity * 2;
+        if (newCapacity < BufferSize) {
+            newCapacity = BufferSize;
+        }
+        if (mode == BOUNDED && newCapacity > BufferSize) {
+            newCapacity = BufferSize;
+        }
+        // Build the item before moving the buffer, args may refer to
+        // an item already on the stack.
+        T item(std::forward<Args>(args)...);
+        reallocate(newCapacity);
+        ::new (static_cast<void *>(items + numItems)) T(std::move(item));
+        ++numItems;
+        return true;
     }
+    ::new (static_cast<void *>(items + numItems)) T(std::forward<Args>(args)...);
+    ++numItems;
+    return true;
 }
 
 // pop()
-template<class T>
-void Stack<T>::pop() {
-    
-    // Start of Code
-    if (!isEmpty()) {
-        Node *temp = nullptr;
-        temp = top->next;
-        delete top;
-        top = temp;
-    }
-    else {
-        std::cout << "Stack is empty." << std::endl;
+//
+// Removes the top item and returns it. Throws std::out_of_range if
+// the stack is empty.
+template<class T, size_t InlineCount>
+T Stack<T, InlineCount>::pop() {
+
+    if (isEmpty()) {
+        throw std::out_of_range("Stack is empty.");
     }
+    T *top = items + numItems - 1;
+    T item(std::move(*top));
+    top->~T();
+    --numItems;
+    return item;
 }
 
 // peek()
-template<class T>
-T Stack<T>::peek() {
-    
+//
+// Throws std::out_of_range if the stack is empty.
+template<class T, size_t InlineCount>
+T &Stack<T, InlineCount>::peek() {
+
+    if (isEmpty()) {
+        throw std::out_of_range("Stack is empty.");
+    }
+    return items[numItems - 1];
+}
+
+template<class T, size_t InlineCount>
+const T &Stack<T, InlineCount>::peek() const {
+
     if (isEmpty()) {
-        std::cout << "Stack is empty." << std::endl;
+        throw std::out_of_range("Stack is empty.");
+    }
+    return items[numItems - 1];
+}
+
+// clear()
+template<class T, size_t InlineCount>
+void Stack<T, InlineCount>::clear() {
+
+    while (numItems > 0) {
+        items[--numItems].~T();
     }
-    return top->data;
+}
+
+// **Private** //
+// load()
+//
+// Replaces the stack, size and mode included, with the one stored in
+// reader, once all of it has been read and checked.
+template<class T, size_t InlineCount>
+void Stack<T, InlineCount>::load(BinaryReader &reader) {
+
+    std::vector<T> loaded;
+    SerializedHeader header = readSerialized<T>(reader, SerializedKind::STACK,
+                                                [&](T &&item) { loaded.push_back(std::move(item)); });
+    CapacityMode loadedMode = (header.flags & 1) ? BOUNDED : GROWABLE;
+    if (header.capacity > INT_MAX || loaded.size() > INT_MAX ||
+        (loadedMode == BOUNDED && loaded.size() > header.capacity)) {
+        throw std::runtime_error("deserialize: stack size is invalid");
+    }
+
+    Stack stack(static_cast<int>(header.capacity), loadedMode, getResource());
+    if (static_cast<int>(loaded.size()) > stack.capacity) {
+        stack.reallocate(static_cast<int>(loaded.size()));
+    }
+    for (T &item : loaded) {
+        stack.emplace(std::move(item));
+    }
+    *this = std::move(stack);
+}
+
+// serialize()
+//
+// Writes the items bottom to top (see Serialization.hpp).
+template<class T, size_t InlineCount>
+void Stack<T, InlineCount>::serialize(std::ostream &output) const {
+
+    writeSerialized<T>(output, SerializedKind::STACK, numItems, mode == BOUNDED ? 1 : 0, BufferSize,
+                       [&](auto &&writeItem) {
+                           for (int i = 0; i < numItems; ++i) {
+                               writeItem(items[i]);
+                           }
+                       });
+}
+
+// deserialize()
+template<class T, size_t InlineCount>
+void Stack<T, InlineCount>::deserialize(std::istream &input) {
+
+    BinaryReader reader(input);
+    load(reader);
+}
+
+template<class T, size_t InlineCount>
+void Stack<T, InlineCount>::deserialize(const MappedFile &file) {
+
+    BinaryReader reader(file.data(), file.size());
+    load(reader);
 }
 #endif /* Stack.hpp */
@@ -0,0 +1,311 @@
+//
+//  WorkStealingPool.hpp
+//  CustomLibraries
+//
+//  Description
+//
+//  A fixed set of worker threads for fork-join parallelism, used by the
+//  parallel sorts in Sorting.hpp.
+//
+//  Every worker owns a deque of tasks. A task submitted from a worker
+//  goes on the back of that worker's own deque and the worker takes
+//  from the back, so recently forked work runs hot in the same cache.
+//  A worker that runs dry steals from the front of another worker's
+//  deque, which is where the oldest and usually largest pieces of work
+//  are. Tasks submitted from outside the pool are dealt round-robin.
+//  Idle workers sleep on a condition variable and are only woken when
+//  work arrives while somebody is asleep.
+//
+//  TaskGroup forks tasks and joins them:
+//
+//      TaskGroup group(pool);
+//      group.run([&] { sortLeft(); });
+//      group.run([&] { sortRight(); });
+//      group.wait();
+//
+//  A thread blocked in wait() runs pending tasks instead of sleeping,
+//  so tasks can fork and wait on subtasks without starving the pool.
+//  The first exception thrown by a task is rethrown from wait().
+//
+
+#ifndef WorkStealingPool_hpp
+#define WorkStealingPool_hpp
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class WorkStealingPool {
+private:
+    typedef std::function<void()> Task;
+
+    // The deques are short lock-protected sections; sort tasks are
+    // coarse enough that the locks are never what limits scaling.
+    struct alignas(64) WorkerQueue {
+        std::mutex       lock;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread>                  workers;
+
+    alignas(64) std::atomic<size_t>   queued;
+    alignas(64) std::atomic<unsigned> sleepers;
+    std::atomic<unsigned>             nextQueue;
+    std::atomic<bool>                 stopping;
+    std::mutex                        sleepLock;
+    std::condition_variable           wake;
+
+    // Which pool, and which worker in it, the calling thread is
+    struct WorkerIdentity {
+        const WorkStealingPool *pool  = nullptr;
+        unsigned                index = 0;
+    };
+    static WorkerIdentity &identity() {
+        static thread_local WorkerIdentity self;
+        return self;
+    }
+
+    void push(Task);
+    bool popLocal(unsigned, Task &);
+    bool steal(unsigned, Task &);
+    void workerLoop(unsigned);
+
+public:
+    // Constructor
+    explicit WorkStealingPool(unsigned numThreads = 0);
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    // Destructor
+    ~WorkStealingPool();
+
+    // Functions
+    template <class F>
+    void submit(F &&task) { push(Task(std::forward<F>(task))); }
+    bool runPendingTask();
+    unsigned getNumThreads() const;
+};
+
+class TaskGroup {
+private:
+    WorkStealingPool   &pool;
+    std::atomic<size_t> pending;
+    std::mutex          errorLock;
+    std::exception_ptr  error;
+
+    void join();
+
+public:
+    // Constructor
+    explicit TaskGroup(WorkStealingPool &p) : pool(p), pending{0} { }
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup &operator=(const TaskGroup &) = delete;
+
+    // Destructor
+    //
+    // Waits for outstanding tasks, which may refer to this group.
+    ~TaskGroup() { join(); }
+
+    // Functions
+    template <class F>
+    void run(F &&);
+    void wait();
+};
+
+// **Constructor** //
+//
+// numThreads == 0 uses one worker per hardware thread.
+inline WorkStealingPool::WorkStealingPool(unsigned numThreads)
+    : queued{0}, sleepers{0}, nextQueue{0}, stopping{false} {
+    if (numThreads == 0) {
+        numThreads = std::thread::hardware_concurrency();
+        if (numThreads == 0) {
+            numThreads = 1;
+        }
+    }
+    for (unsigned i = 0; i < numThreads; ++i) {
+        queues.emplace_back(new WorkerQueue);
+    }
+    for (unsigned i = 0; i < numThreads; ++i) {
+        workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+// **Destructor** //
+//
+// Lets the workers finish every task already submitted, then joins them.
+inline WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        stopping.store(true);
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+// **Private** //
+// push()
+inline void WorkStealingPool::push(Task task) {
+    WorkerIdentity &self = identity();
+    unsigned index = (self.pool == this)
+                   ? self.index
+                   : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    {
+        std::lock_guard<std::mutex> guard(queues[index]->lock);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+
+    // Pairs with the sleepers/queued check in workerLoop: either the
+    // worker sees the task, or we see the worker and wake it.
+    queued.fetch_add(1, std::memory_order_seq_cst);
+    if (sleepers.load(std::memory_order_seq_cst) != 0) {
+        { std::lock_guard<std::mutex> guard(sleepLock); }
+        wake.notify_one();
+    }
+}
+
+// **Private** //
+// popLocal()
+//
+// Newest task from the worker's own deque.
+inline bool WorkStealingPool::popLocal(unsigned index, Task &task) {
+    WorkerQueue &q = *queues[index];
+    std::lock_guard<std::mutex> guard(q.lock);
+    if (q.tasks.empty()) {
+        return false;
+    }
+    task = std::move(q.tasks.back());
+    q.tasks.pop_back();
+    queued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+}
+
+// **Private** //
+// steal()
+//
+// Oldest task from any deque, trying them in turn from start.
+inline bool WorkStealingPool::steal(unsigned start, Task &task) {
+    size_t n = queues.size();
+    for (size_t i = 0; i < n; ++i) {
+        WorkerQueue &q = *queues[(start + i) % n];
+        std::unique_lock<std::mutex> guard(q.lock, std::try_to_lock);
+        if (guard.owns_lock() && !q.tasks.empty()) {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+// **Private** //
+// workerLoop()
+inline void WorkStealingPool::workerLoop(unsigned index) {
+    identity() = WorkerIdentity{this, index};
+    Task task;
+
+    for (;;) {
+        if (popLocal(index, task) || steal(index + 1, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(sleepLock);
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        while (queued.load(std::memory_order_seq_cst) == 0 && !stopping.load()) {
+            wake.wait(guard);
+        }
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+        if (stopping.load() && queued.load() == 0) {
+            return;
+        }
+    }
+}
+
+// **Public** //
+// runPendingTask()
+//
+// Runs one queued task on the calling thread, if there is one.
+// Returns false if there was nothing to run.
+inline bool WorkStealingPool::runPendingTask() {
+    WorkerIdentity &self = identity();
+    Task task;
+    if (self.pool == this) {
+        if (!popLocal(self.index, task) && !steal(self.index + 1, task)) {
+            return false;
+        }
+    }
+    else if (!steal(0, task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+// **Public** //
+// getNumThreads()
+inline unsigned WorkStealingPool::getNumThreads() const {
+    return static_cast<unsigned>(workers.size());
+}
+
+// **Public** //
+// run()
+//
+// Submits task to the pool as part of this group.
+template <class F>
+void TaskGroup::run(F &&task) {
+    pending.fetch_add(1, std::memory_order_relaxed);
+    pool.submit([this, task = std::forward<F>(task)]() mutable {
+        try {
+            task();
+        }
+        catch (...) {
+            std::lock_guard<std::mutex> guard(errorLock);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        pending.fetch_sub(1, std::memory_order_release);
+    });
+}
+
+// **Private** //
+// join()
+//
+// Helps run tasks until every task in the group has finished.
+inline void TaskGroup::join() {
+    while (pending.load(std::memory_order_acquire) != 0) {
+        if (!pool.runPendingTask()) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// **Public** //
+// wait()
+//
+// Returns once every task run so far has finished, rethrowing the
+// first exception any of them threw.
+inline void TaskGroup::wait() {
+    join();
+    if (error) {
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+#endif /* WorkStealingPool.hpp */
@@ -3,15 +3,41 @@
 //
 //  Created by Kyle Hurd on 12/12/20.
 //
+//  BufferedWriter and BufferedReader do text I/O through one large
+//  buffer each, formatting and parsing numbers with std::to_chars and
+//  std::from_chars (no locale, no streams). Use them for loading and
+//  dumping large amounts of data:
+//
+//      BufferedWriter out("numbers.txt");
+//      for (int x : values) out << x << '\n';
+//
+//      BufferedReader in("numbers.txt", BufferedReader::MAP);
+//      int x;
+//      while (in.read(x)) values.push_back(x);
+//
 
 #ifndef helperFunctions_hpp
 #define helperFunctions_hpp
 
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <fstream>
-#include <string>
 #include <sstream>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HELPER_MMAP 1
+#endif
 
 
 /* *
@@ -19,13 +45,23 @@
  *  Modified:    11/28/2020
  *  Description: Converts an integer to a string. For example,
  *               if int 42 is passed in, '42' as a string will
- *               be returned.
+ *               be returned. Integers and floating point numbers
+ *               are formatted with std::to_chars (floats in the
+ *               shortest form that reads back exactly); any other
+ *               type goes through operator<<.
  */
 template <class T>
 std::string numToString(T num) {
-    std::ostringstream ss;
-    ss << num;
-    return ss.str();
+    if constexpr (std::is_arithmetic<T>::value && !std::is_same<T, bool>::value && !std::is_same<T, char>::value) {
+        char text[64];
+        std::to_chars_result result = std::to_chars(text, text + sizeof(text), num);
+        return std::string(text, result.ptr);
+    }
+    else {
+        std::ostringstream ss;
+        ss << num;
+        return ss.str();
+    }
 }
 
 /* *
@@ -43,9 +79,11 @@ std::string numToString(T num) {
  *               std::fstream outfile;
  *               openOutFile(outfile, "path/to/file.txt");
  *               print("Output to fstream", outfile);
+ *
+ *               Lines end with '\n' and are not flushed one by one.
  */
-void print(std::string n = "", std::ostream &output = std::cout) {
-    output << n << std::endl;
+inline void print(const std::string &n = "", std::ostream &output = std::cout) {
+    output << n << '\n';
 }
 
 /* *
@@ -59,10 +97,10 @@ void print(std::string n = "", std::ostream &output = std::cout) {
  *               std::fstream infile;
  *               openInFile(infile, "./path/to/file.txt");
  */
-void openInFile(std::fstream &file, std::string s) {
-    
+inline void openInFile(std::fstream &file, std::string s) {
+
     file.open(s, std::ios::in);
-    
+
     if (file.is_open()) print(s + " opened successfully.");
     else                print(s + " could not be opened. Cannot read data.");
 }
@@ -78,12 +116,437 @@ void openInFile(std::fstream &file, std::string s) {
  *               std::fstream outfile;
  *               openOutFile(outfile, "./path/to/file.txt");
  */
-void openOutFile(std::fstream &file, std::string s) {
-    
+inline void openOutFile(std::fstream &file, std::string s) {
+
     file.open(s, std::ios::out);
-    
+
     if (file.is_open()) print(s + " opened successfully.");
     else                print(s + " could not be opened. Cannot write data.");
 }
 
+/* *
+ *  Description: Collects output in a large buffer and writes it to a
+ *               file or stream in one block when the buffer fills, on
+ *               flush() and on destruction. Numbers are formatted with
+ *               std::to_chars, straight into the buffer.
+ *
+ *               Ex.
+ *               BufferedWriter out("path/to/file.txt");
+ *               out << "count " << n << '\n';
+ *               out.write(3.25);
+ */
+class BufferedWriter {
+private:
+    std::FILE        *file;
+    std::ostream     *stream;
+    std::vector<char> buffer;
+    size_t            used;
+    bool              failed;
+
+    void reserve(size_t);
+
+public:
+    // Constructor
+    explicit BufferedWriter(const std::string &path, size_t bufferSize = 1 << 16);
+    explicit BufferedWriter(std::ostream &output, size_t bufferSize = 1 << 16);
+    BufferedWriter(const BufferedWriter &) = delete;
+    BufferedWriter &operator=(const BufferedWriter &) = delete;
+
+    // Destructor
+    ~BufferedWriter();
+
+    // Functions
+    bool isOpen() const;
+    bool good() const;
+    void write(char);
+    void write(std::string_view);
+    void write(const char *text) { write(std::string_view(text)); }
+    void write(const std::string &text) { write(std::string_view(text)); }
+    template <class T>
+    typename std::enable_if<std::is_arithmetic<T>::value>::type write(T);
+    void flush();
+
+    template <class T>
+    BufferedWriter &operator<<(const T &value) {
+        write(value);
+        return *this;
+    }
+};
+
+// Constructor
+//
+// Writes to the file at path, replacing it. isOpen() says whether it
+// could be opened.
+inline BufferedWriter::BufferedWriter(const std::string &path, size_t bufferSize)
+    : file{std::fopen(path.c_str(), "wb")}, stream{nullptr}, buffer(std::max<size_t>(bufferSize, 64)),
+      used{0}, failed{false} {
+    if (file) {
+        std::setvbuf(file, nullptr, _IONBF, 0);
+    }
+}
+
+inline BufferedWriter::BufferedWriter(std::ostream &output, size_t bufferSize)
+    : file{nullptr}, stream{&output}, buffer(std::max<size_t>(bufferSize, 64)), used{0}, failed{false} { }
+
+// Destructor
+inline BufferedWriter::~BufferedWriter() {
+    flush();
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+// **Private** //
+// reserve()
+//
+// Makes room for count more characters, flushing if need be.
+inline void BufferedWriter::reserve(size_t count) {
+    if (buffer.size() - used < count) {
+        flush();
+    }
+}
+
+// **Public** //
+// isOpen()
+inline bool BufferedWriter::isOpen() const {
+    return file != nullptr || stream != nullptr;
+}
+
+// **Public** //
+// good()
+//
+// False once a write has failed.
+inline bool BufferedWriter::good() const {
+    return isOpen() && !failed;
+}
+
+// **Public** //
+// write()
+inline void BufferedWriter::write(char c) {
+    reserve(1);
+    buffer[used++] = c;
+}
+
+inline void BufferedWriter::write(std::string_view text) {
+    if (text.size() >= buffer.size()) {
+        // Too big to be worth copying: send it straight through
+        flush();
+        if (file) {
+            failed |= std::fwrite(text.data(), 1, text.size(), file) != text.size();
+        }
+        else if (stream) {
+            failed |= !stream->write(text.data(), std::streamsize(text.size()));
+        }
+        return;
+    }
+    reserve(text.size());
+    std::memcpy(buffer.data() + used, text.data(), text.size());
+    used += text.size();
+}
+
+// Integers in decimal, floating point numbers in the shortest form
+// that reads back as the same value. bool is written as 0 or 1 and
+// char as the character itself.
+template <class T>
+typename std::enable_if<std::is_arithmetic<T>::value>::type BufferedWriter::write(T value) {
+    if constexpr (std::is_same<T, char>::value) {
+        write(static_cast<char>(value));
+    }
+    else if constexpr (std::is_same<T, bool>::value) {
+        write(value ? '1' : '0');
+    }
+    else {
+        reserve(64);
+        std::to_chars_result result = std::to_chars(buffer.data() + used, buffer.data() + buffer.size(), value);
+        used = static_cast<size_t>(result.ptr - buffer.data());
+    }
+}
+
+// **Public** //
+// flush()
+//
+// Writes out whatever is buffered.
+inline void BufferedWriter::flush() {
+    if (used == 0) {
+        return;
+    }
+    if (file) {
+        failed |= std::fwrite(buffer.data(), 1, used, file) != used;
+    }
+    else if (stream) {
+        failed |= !stream->write(buffer.data(), std::streamsize(used));
+        stream->flush();
+    }
+    used = 0;
+}
+
+/* *
+ *  Description: Reads whitespace separated tokens and lines from a
+ *               file. Numbers are parsed with std::from_chars.
+ *
+ *               BLOCK mode reads the file through a buffer of
+ *               bufferSize bytes. MAP mode maps the whole file into
+ *               memory with mmap and parses it in place, which avoids
+ *               copying it; where mmap is not available it falls back
+ *               to BLOCK.
+ *
+ *               read() returns false at the end of the input or if the
+ *               next token is not a valid value; fail() tells the two
+ *               apart. Either way the token is consumed.
+ *
+ *               Ex.
+ *               BufferedReader in("path/to/file.txt");
+ *               int count;
+ *               std::string name;
+ *               while (in.read(name) && in.read(count)) { ... }
+ */
+class BufferedReader {
+public:
+    enum Mode { BLOCK, MAP };
+
+private:
+    std::FILE        *file;
+    std::vector<char> buffer;
+    const char       *position, *end;
+    void             *mapped;
+    size_t            mappedSize;
+    bool              atEof, failed;
+
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\f' || c == '\v';
+    }
+    bool refill();
+    bool nextToken(std::string_view &);
+
+public:
+    // Constructor
+    explicit BufferedReader(const std::string &path, Mode mode = BLOCK, size_t bufferSize = 1 << 16);
+    BufferedReader(const BufferedReader &) = delete;
+    BufferedReader &operator=(const BufferedReader &) = delete;
+
+    // Destructor
+    ~BufferedReader();
+
+    // Functions
+    bool isOpen() const;
+    bool isEof();
+    bool fail() const;
+    template <class T>
+    typename std::enable_if<std::is_arithmetic<T>::value, bool>::type read(T &);
+    bool read(std::string &);
+    bool readLine(std::string &);
+};
+
+// Constructor
+//
+// isOpen() says whether the file could be opened.
+inline BufferedReader::BufferedReader(const std::string &path, Mode mode, size_t bufferSize)
+    : file{nullptr}, position{nullptr}, end{nullptr}, mapped{nullptr}, mappedSize{0}, atEof{false}, failed{false} {
+#ifdef HELPER_MMAP
+    if (mode == MAP) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        struct stat info;
+        if (fd >= 0 && ::fstat(fd, &info) == 0) {
+            mappedSize = static_cast<size_t>(info.st_size);
+            atEof      = true;
+            if (mappedSize == 0) {
+                position = end = "";
+                ::close(fd);
+                return;
+            }
+            void *region = ::mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (region != MAP_FAILED) {
+                ::madvise(region, mappedSize, MADV_SEQUENTIAL);
+                ::close(fd);
+                mapped   = region;
+                position = static_cast<const char *>(region);
+                end      = position + mappedSize;
+                return;
+            }
+            atEof = false;
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+#else
+    (void)mode;
+#endif
+    file = std::fopen(path.c_str(), "rb");
+    if (file) {
+        std::setvbuf(file, nullptr, _IONBF, 0);
+        buffer.resize(std::max<size_t>(bufferSize, 64));
+        position = end = buffer.data();
+    }
+}
+
+// Destructor
+inline BufferedReader::~BufferedReader() {
+#ifdef HELPER_MMAP
+    if (mapped) {
+        ::munmap(mapped, mappedSize);
+    }
+#endif
+    if (file) {
+        std::fclose(file);
+    }
+}
+
+// **Private** //
+// refill()
+//
+// Moves the unread characters to the front of the buffer and reads
+// more after them, growing the buffer if it is already full. Returns
+// false if nothing more could be read.
+inline bool BufferedReader::refill() {
+    if (atEof || file == nullptr) {
+        return false;
+    }
+    size_t remaining = static_cast<size_t>(end - position);
+    std::memmove(buffer.data(), position, remaining);
+    if (remaining == buffer.size()) {
+        buffer.resize(buffer.size() * 2);
+    }
+    size_t got = std::fread(buffer.data() + remaining, 1, buffer.size() - remaining, file);
+    if (got == 0) {
+        atEof = true;
+    }
+    position = buffer.data();
+    end      = position + remaining + got;
+    return got != 0;
+}
+
+// **Private** //
+// nextToken()
+//
+// Skips whitespace and points token at the next run of non-whitespace
+// characters, which stays valid until the next call.
+inline bool BufferedReader::nextToken(std::string_view &token) {
+    for (;;) {
+        while (position != end && isSpace(*position)) {
+            position++;
+        }
+        if (position != end || !refill()) {
+            break;
+        }
+    }
+    if (position == end) {
+        return false;
+    }
+
+    size_t length = 0;
+    for (;;) {
+        while (position + length != end && !isSpace(position[length])) {
+            length++;
+        }
+        if (position + length != end || !refill()) {
+            break;
+        }
+    }
+    token = std::string_view(position, length);
+    position += length;
+    return true;
+}
+
+// **Public** //
+// isOpen()
+inline bool BufferedReader::isOpen() const {
+    return file != nullptr || mapped != nullptr || position != nullptr;
+}
+
+// **Public** //
+// isEof()
+//
+// True once only whitespace (or nothing) is left to read.
+inline bool BufferedReader::isEof() {
+    for (;;) {
+        while (position != end && isSpace(*position)) {
+            position++;
+        }
+        if (position != end) {
+            return false;
+        }
+        if (!refill()) {
+            return true;
+        }
+    }
+}
+
+// **Public** //
+// fail()
+//
+// True once a token failed to parse as the type asked for.
+inline bool BufferedReader::fail() const {
+    return failed;
+}
+
+// **Public** //
+// read()
+//
+// Reads the next token as a number, or as a string. bool reads the 0
+// or 1 that BufferedWriter writes.
+template <class T>
+typename std::enable_if<std::is_arithmetic<T>::value, bool>::type BufferedReader::read(T &value) {
+    std::string_view token;
+    if (!nextToken(token)) {
+        return false;
+    }
+    if constexpr (std::is_same<T, bool>::value) {
+        if (token != "0" && token != "1") {
+            failed = true;
+            return false;
+        }
+        value = token == "1";
+    }
+    else {
+        const char *first = token.data(), *last = token.data() + token.size();
+        if (first != last && *first == '+') {
+            first++;
+        }
+        std::from_chars_result result = std::from_chars(first, last, value);
+        if (result.ec != std::errc() || result.ptr != last) {
+            failed = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool BufferedReader::read(std::string &value) {
+    std::string_view token;
+    if (!nextToken(token)) {
+        return false;
+    }
+    value.assign(token.data(), token.size());
+    return true;
+}
+
+// **Public** //
+// readLine()
+//
+// Reads the rest of the current line, without the line ending.
+inline bool BufferedReader::readLine(std::string &line) {
+    line.clear();
+    if (position == end && !refill()) {
+        return false;
+    }
+    for (;;) {
+        const char *newline = static_cast<const char *>(std::memchr(position, '\n', size_t(end - position)));
+        if (newline) {
+            line.append(position, newline);
+            position = newline + 1;
+            break;
+        }
+        line.append(position, end);
+        position = end;
+        if (!refill()) {
+            break;
+        }
+    }
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    return true;
+}
+
 #endif /* helperFunctions_hpp */